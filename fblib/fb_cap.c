@@ -0,0 +1,437 @@
+//-----------------------------------------------------------------------------
+//
+// frame capture stream (keyframe + XOR/RLE delta of damaged area)
+//
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fblib.h"
+#include "fb_cap.h"
+
+//-----------------------------------------------------------------------------
+// Function prototype define.
+//-----------------------------------------------------------------------------
+static int          _rle_enc        (unsigned char *d, const unsigned char *s, int len);
+static int          _rle_dec        (unsigned char *d, int len, const unsigned char *s, int s_len);
+static int          _cap_rect       (fb_cap_t *cap, fb_rect_t *r, bool key);
+static long         _cap_need       (fb_info_t *fb, fb_rect_t *r, int cnt, long *area);
+static fb_cap_rd_t  *_cap_rd_open   (FILE *fp);
+int                 fb_cap_size     (fb_info_t *fb);
+int                 fb_cap_enc      (fb_info_t *fb, int msec, fb_rect_t *r, int cnt,
+                                        unsigned char *d, int size);
+int                 fb_cap_header   (fb_info_t *fb, unsigned char *d);
+int                 fb_cap_frame    (fb_cap_t *cap, bool key);
+void                fb_cap_close    (fb_cap_t *cap);
+fb_cap_t            *fb_cap_init    (fb_info_t *fb, const char *fname, int key_int);
+int                 fb_cap_read     (fb_cap_rd_t *rd);
+void                fb_cap_rd_close (fb_cap_rd_t *rd);
+fb_cap_rd_t         *fb_cap_rd_init (const char *fname);
+fb_cap_rd_t         *fb_cap_rd_fdopen (int fd);
+
+//-----------------------------------------------------------------------------
+/* len byte 를 RLE 할 때 최대 크기 */
+#define RLE_MAX(len)        ((len) + (len) / 128 + 2)
+
+//-----------------------------------------------------------------------------
+/*
+    PackBits : n < 128 이면 n + 1 byte 그대로, n >= 128 이면 다음 1 byte 를 n - 126 번 반복.
+    XOR delta 는 변경이 없는 pixel 이 0 이므로 긴 반복으로 줄어듬.
+    3 byte 이상 반복만 반복으로 기록하여 결과가 RLE_MAX 를 넘지 않도록 함.
+*/
+static int _rle_enc (unsigned char *d, const unsigned char *s, int len)
+{
+    int i = 0, o = 0, run, lit;
+
+    while (i < len) {
+        for (run = 1; (i + run < len) && (run < 129) && (s[i + run] == s[i]); run++)
+            ;
+        if (run >= 3) {
+            unsigned char v = s[i];
+
+            d[o++] = run + 126;
+            d[o++] = v;
+            i += run;
+            continue;
+        }
+        /* 다음 반복이 나올 때까지 literal */
+        for (lit = 1; (i + lit < len) && (lit < 128); lit++)
+            if ((i + lit + 2 < len) && (s[i + lit] == s[i + lit + 1]) &&
+                (s[i + lit] == s[i + lit + 2]))
+                break;
+        d[o++] = lit - 1;
+        memmove (&d[o], &s[i], lit);
+        o += lit;   i += lit;
+    }
+    return o;
+}
+
+//-----------------------------------------------------------------------------
+static int _rle_dec (unsigned char *d, int len, const unsigned char *s, int s_len)
+{
+    /* d 에 len byte 를 풀어냄, return : 사용한 s 의 byte 수 (-1 = 잘못된 data) */
+    int i = 0, o = 0, n;
+
+    while (o < len) {
+        if (i >= s_len)
+            return -1;
+        n = s[i++];
+        if (n < 128) {
+            if ((o + n + 1 > len) || (i + n + 1 > s_len))
+                return -1;
+            memcpy (&d[o], &s[i], n + 1);
+            o += n + 1;     i += n + 1;
+        } else {
+            if ((o + n - 126 > len) || (i >= s_len))
+                return -1;
+            memset (&d[o], s[i++], n - 126);
+            o += n - 126;
+        }
+    }
+    return i;
+}
+
+//-----------------------------------------------------------------------------
+static int _cap_rect (fb_cap_t *cap, fb_rect_t *r, bool key)
+{
+    fb_info_t *fb = cap->fb;
+    int bpp = fb->bpp >> 3, len = r->w * bpp, y, x, size = 0;
+    int hdr[5] = { r->x, r->y, r->w, r->h, 0 };
+
+    for (y = r->y; y < r->y + r->h; y++) {
+        unsigned char *s = (unsigned char *)fb->data + y * fb->stride + r->x * bpp;
+        unsigned char *p = cap->prev + (y * fb->w + r->x) * bpp;
+
+        /* keyframe 은 왼쪽 pixel 과의 XOR (같은 색이 이어지는 영역이 0 이 됨) */
+        if (key) {
+            memcpy (cap->row, s, bpp);
+            for (x = bpp; x < len; x++)
+                cap->row[x] = s[x] ^ s[x - bpp];
+        }
+        else
+            for (x = 0; x < len; x++)
+                cap->row[x] = s[x] ^ p[x];
+        memcpy (p, s, len);
+        size += _rle_enc (cap->buf + size, cap->row, len);
+    }
+    hdr[4] = size;
+    fwrite (hdr, sizeof(int), 5, cap->fp);
+    fwrite (cap->buf, 1, size, cap->fp);
+    cap->bytes += sizeof(hdr) + size;
+    return ferror (cap->fp) ? -1 : 0;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    r 목록을 fb_cap_enc 로 기록할 때 d 에 쓰는 최대 byte 수 (line 버퍼로 쓰는 뒤쪽 포함).
+    area : rect 면적의 합 (fb_rect_merge 결과는 서로 겹칠 수 있으므로 화면보다 클 수 있음)
+*/
+static long _cap_need (fb_info_t *fb, fb_rect_t *r, int cnt, long *area)
+{
+    int bpp = fb->bpp >> 3, i;
+    long need = sizeof(int) * 3;
+
+    for (i = 0, *area = 0; i < cnt; i++, r++) {
+        need  += sizeof(int) * 5 + (long)r->h * (RLE_MAX(r->w * bpp) + 2);
+        *area += (long)r->w * r->h;
+    }
+    return need;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    fb_cap_enc 결과의 최대 크기 (전체 화면 keyframe 이상, d 의 크기로 사용)
+*/
+int fb_cap_size (fb_info_t *fb)
+{
+    int bpp = fb->bpp >> 3;
+
+    return sizeof(int) * (3 + 5 * FB_DAMAGE_MAX) +
+            RLE_MAX(fb->w * bpp) * fb->h + FB_DAMAGE_MAX * 4 * fb->h;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    r 목록의 현재 화면을 keyframe 형식의 frame 1 개로 d(size byte) 에 기록 (mirroring 등 이전 frame 이 없는 경우).
+    겹치는 rect 의 면적 합이 화면 이상이거나 d 를 넘는 경우 전체 화면 1 개로 기록.
+    return : 기록한 byte 수, -1 = d 가 전체 화면보다 작음
+*/
+int fb_cap_enc (fb_info_t *fb, int msec, fb_rect_t *r, int cnt, unsigned char *d, int size)
+{
+    int bpp = fb->bpp >> 3, i, y, x, o, len, hdr[5];
+    fb_rect_t full = { 0, 0, fb->w, fb->h };
+    unsigned char *s;
+    long area;
+
+    if ((_cap_need (fb, r, cnt, &area) > size) || (area >= (long)fb->w * fb->h)) {
+        r = &full;  cnt = 1;
+        if (_cap_need (fb, r, cnt, &area) > size)
+            return -1;
+    }
+
+    hdr[0] = eFB_CAP_KEY;   hdr[1] = msec;  hdr[2] = cnt;
+    memcpy (d, hdr, sizeof(int) * 3);
+    o = sizeof(int) * 3;
+
+    for (i = 0; i < cnt; i++, r++) {
+        int h_pos = o;
+
+        hdr[0] = r->x;  hdr[1] = r->y;  hdr[2] = r->w;  hdr[3] = r->h;
+        o += sizeof(hdr);
+        len = r->w * bpp;
+        for (y = r->y; y < r->y + r->h; y++) {
+            /*
+                RLE 출력 뒤쪽을 line 버퍼로 사용.
+                RLE 결과는 입력보다 최대 len / 128 + 2 byte 길어지므로 읽기 전의 입력을 덮어쓰지 않음.
+            */
+            unsigned char *row = d + o + 4 + len / 128;
+
+            s = (unsigned char *)fb->data + y * fb->stride + r->x * bpp;
+            memcpy (row, s, bpp);
+            for (x = bpp; x < len; x++)
+                row[x] = s[x] ^ s[x - bpp];
+            o += _rle_enc (d + o, row, len);
+        }
+        hdr[4] = o - h_pos - sizeof(hdr);
+        memcpy (d + h_pos, hdr, sizeof(hdr));
+    }
+    return o;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    stream header (magic + 화면 정보), return : 기록한 byte 수
+*/
+int fb_cap_header (fb_info_t *fb, unsigned char *d)
+{
+    int hdr[4] = { fb->w, fb->h, fb->bpp, fb->is_bgr };
+
+    memcpy (d, FB_CAP_MAGIC, 8);
+    memcpy (d + 8, hdr, sizeof(hdr));
+    return 8 + sizeof(hdr);
+}
+
+//-----------------------------------------------------------------------------
+/*
+    현재 화면을 기록한다. (ui_present 후 또는 일정 주기마다 호출)
+    keyframe 이 아니면 fb 의 damage 영역만 이전 frame 과의 XOR 로 기록.
+    (damage 는 fb_present 에서 초기화되므로 present hook 에서 호출하면 frame 마다 변경분만 기록됨)
+    key = true 이거나 keyframe 간격이 되면 전체 화면을 기록.
+    return : 1 = 기록함, 0 = 변경 없음, -1 = error
+*/
+int fb_cap_frame (fb_cap_t *cap, bool key)
+{
+    fb_info_t *fb = cap->fb;
+    struct timespec now;
+    fb_rect_t full = { 0, 0, fb->w, fb->h };
+    int hdr[3], i, ret = 0;
+
+    if (!cap->frames || (cap->key_int && (cap->since_key >= cap->key_int)))
+        key = true;
+    if (!key && !fb->damage_cnt)
+        return 0;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    hdr[0] = key ? eFB_CAP_KEY : eFB_CAP_DELTA;
+    hdr[1] = (now.tv_sec - cap->t0.tv_sec) * 1000 + (now.tv_nsec - cap->t0.tv_nsec) / 1000000;
+    hdr[2] = key ? 1 : fb->damage_cnt;
+    fwrite (hdr, sizeof(int), 3, cap->fp);
+    cap->bytes += sizeof(hdr);
+
+    if (key)
+        ret = _cap_rect (cap, &full, true);
+    else
+        for (i = 0; (i < fb->damage_cnt) && !ret; i++)
+            ret = _cap_rect (cap, &fb->damage[i], false);
+
+    cap->frames++;
+    if (key) {
+        cap->keys++;
+        cap->since_key = 0;
+    }
+    cap->since_key++;
+
+    if (ret || fflush (cap->fp)) {
+        err("capture write fail!\n");
+        return -1;
+    }
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
+void fb_cap_close (fb_cap_t *cap)
+{
+    if (cap) {
+        if (cap->fp)    fclose (cap->fp);
+        if (cap->prev)  free (cap->prev);
+        if (cap->row)   free (cap->row);
+        if (cap->buf)   free (cap->buf);
+        free (cap);
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*
+    key_int : keyframe 간격 (frame 수, 0 = 첫 frame 만 keyframe)
+*/
+fb_cap_t *fb_cap_init (fb_info_t *fb, const char *fname, int key_int)
+{
+    fb_cap_t *cap;
+    int bpp = fb->bpp >> 3;
+
+    if ((cap = (fb_cap_t *)malloc(sizeof(fb_cap_t))) == NULL) {
+        err("capture malloc error!\n");
+        return NULL;
+    }
+    memset (cap, 0, sizeof(fb_cap_t));
+
+    cap->fb      = fb;
+    cap->key_int = (key_int < 0) ? FB_CAP_KEY_DEFAULT : key_int;
+    cap->prev    = (unsigned char *)malloc(fb->w * fb->h * bpp);
+    cap->row     = (unsigned char *)malloc(fb->w * bpp);
+    cap->buf     = (unsigned char *)malloc((size_t)RLE_MAX(fb->w * bpp) * fb->h);
+    if (!cap->prev || !cap->row || !cap->buf) {
+        err("capture buffer malloc error!\n");
+        goto out;
+    }
+    if ((cap->fp = fopen(fname, "wb")) == NULL) {
+        err("%s open fail!\n", fname);
+        goto out;
+    }
+    cap->bytes = fb_cap_header (fb, cap->buf);
+    fwrite (cap->buf, 1, cap->bytes, cap->fp);
+    clock_gettime (CLOCK_MONOTONIC, &cap->t0);
+    return cap;
+out:
+    fb_cap_close (cap);
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    다음 frame 을 읽어 rd->fb 에 반영한다.
+    return : 1 = frame 읽음, 0 = stream 끝, -1 = 잘못된 stream
+*/
+int fb_cap_read (fb_cap_rd_t *rd)
+{
+    fb_info_t *fb = rd->fb;
+    int bpp = fb->bpp >> 3, hdr[5], i, y, x, len, pos, n;
+    unsigned char *row;
+
+    if (fread (hdr, sizeof(int), 3, rd->fp) != 3)
+        return 0;
+    if ((hdr[0] != eFB_CAP_KEY) && (hdr[0] != eFB_CAP_DELTA))
+        return -1;
+    rd->type = hdr[0];
+    rd->msec = hdr[1];
+
+    for (i = 0, n = hdr[2]; i < n; i++) {
+        if (fread (hdr, sizeof(int), 5, rd->fp) != 5)
+            return -1;
+        if ((hdr[0] < 0) || (hdr[1] < 0) || (hdr[2] <= 0) || (hdr[3] <= 0) ||
+            (hdr[0] + hdr[2] > fb->w) || (hdr[1] + hdr[3] > fb->h) ||
+            (hdr[4] < 0) || (hdr[4] > rd->buf_size))
+            return -1;
+        if (fread (rd->buf, 1, hdr[4], rd->fp) != (size_t)hdr[4])
+            return -1;
+
+        len = hdr[2] * bpp;
+        row = rd->buf + rd->buf_size;
+        for (y = hdr[1], pos = 0; y < hdr[1] + hdr[3]; y++) {
+            unsigned char *d = (unsigned char *)fb->data + y * fb->stride + hdr[0] * bpp;
+
+            if ((x = _rle_dec (row, len, rd->buf + pos, hdr[4] - pos)) < 0)
+                return -1;
+            pos += x;
+            if (rd->type == eFB_CAP_KEY) {
+                memcpy (d, row, bpp);
+                for (x = bpp; x < len; x++)
+                    d[x] = row[x] ^ d[x - bpp];
+            }
+            else
+                for (x = 0; x < len; x++)
+                    d[x] ^= row[x];
+        }
+        /* 재생한 화면의 변경 영역 */
+        fb_damage_add (fb, hdr[0], hdr[1], hdr[2], hdr[3]);
+    }
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
+void fb_cap_rd_close (fb_cap_rd_t *rd)
+{
+    if (rd) {
+        if (rd->fp)     fclose (rd->fp);
+        if (rd->fb)     fb_close (rd->fb);
+        if (rd->buf)    free (rd->buf);
+        free (rd);
+    }
+}
+
+//-----------------------------------------------------------------------------
+static fb_cap_rd_t *_cap_rd_open (FILE *fp)
+{
+    fb_cap_rd_t *rd;
+    char magic[8];
+    int hdr[4];
+
+    if ((rd = (fb_cap_rd_t *)malloc(sizeof(fb_cap_rd_t))) == NULL) {
+        err("capture reader malloc error!\n");
+        fclose (fp);
+        return NULL;
+    }
+    memset (rd, 0, sizeof(fb_cap_rd_t));
+
+    rd->fp = fp;
+    if ((fread (magic, 1, 8, rd->fp) != 8) || memcmp (magic, FB_CAP_MAGIC, 8) ||
+        (fread (hdr, sizeof(int), 4, rd->fp) != 4)) {
+        err("not a capture stream!\n");
+        goto out;
+    }
+    if ((rd->fb = fb_surface_init (hdr[0], hdr[1], hdr[2], hdr[3])) == NULL)
+        goto out;
+
+    /* rect data 버퍼 + 1 line 버퍼 */
+    rd->buf_size = RLE_MAX(hdr[0] * (hdr[2] >> 3)) * hdr[1];
+    if ((rd->buf = (unsigned char *)malloc(rd->buf_size + hdr[0] * (hdr[2] >> 3))) == NULL) {
+        err("capture reader buffer malloc error!\n");
+        goto out;
+    }
+    return rd;
+out:
+    fb_cap_rd_close (rd);
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+fb_cap_rd_t *fb_cap_rd_init (const char *fname)
+{
+    FILE *fp;
+
+    if ((fp = fopen(fname, "rb")) == NULL) {
+        err("%s open fail!\n", fname);
+        return NULL;
+    }
+    return _cap_rd_open (fp);
+}
+
+//-----------------------------------------------------------------------------
+/*
+    socket, pipe 등 열려있는 stream 에서 읽음 (mirroring viewer). fd 는 rd_close 에서 닫힘.
+*/
+fb_cap_rd_t *fb_cap_rd_fdopen (int fd)
+{
+    FILE *fp;
+
+    if ((fp = fdopen(fd, "rb")) == NULL) {
+        err("fdopen");
+        return NULL;
+    }
+    return _cap_rd_open (fp);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,66 @@
+//-----------------------------------------------------------------------------
+//
+// frame capture stream (keyframe + XOR/RLE delta of damaged area)
+//
+//-----------------------------------------------------------------------------
+#ifndef __FB_CAP_H__
+#define __FB_CAP_H__
+
+//-----------------------------------------------------------------------------
+#define FB_CAP_MAGIC        "FBCAP001"
+/* keyframe 간격 (frame 수) 기본값 */
+#define FB_CAP_KEY_DEFAULT  100
+
+enum eFB_CAP_FRAME {
+    eFB_CAP_KEY = 'K',
+    eFB_CAP_DELTA = 'D',
+};
+
+/*
+    stream 형식 (host byte order)
+    header : magic[8], w, h, bpp, is_bgr
+    frame  : type(K/D), msec(capture 시작 기준), rect 개수
+             rect 마다 x, y, w, h, data 크기, data
+    data   : rect 의 line 별 PackBits RLE. keyframe 은 왼쪽 pixel 과의 XOR 값, delta 는 이전 frame 과의 XOR 값.
+*/
+typedef struct fb_cap__t {
+    FILE            *fp;
+    fb_info_t       *fb;
+    /* 마지막으로 기록한 화면 (w * bpp 단위로 빈틈없이 저장) */
+    unsigned char   *prev;
+    /* line XOR 버퍼, rect RLE 출력 버퍼 */
+    unsigned char   *row, *buf;
+    int             key_int, since_key;
+    struct timespec t0;
+    /* 기록한 frame 수, keyframe 수, 기록한 byte 수 */
+    unsigned long   frames, keys;
+    long long       bytes;
+}   fb_cap_t;
+
+typedef struct fb_cap_rd__t {
+    FILE            *fp;
+    /* stream 을 재생한 화면 */
+    fb_info_t       *fb;
+    unsigned char   *buf;
+    int             buf_size;
+    /* 마지막으로 읽은 frame 정보 */
+    int             type, msec;
+}   fb_cap_rd_t;
+
+//-----------------------------------------------------------------------------
+extern int          fb_cap_size     (fb_info_t *fb);
+extern int          fb_cap_enc      (fb_info_t *fb, int msec, fb_rect_t *r, int cnt,
+                                        unsigned char *d, int size);
+extern int          fb_cap_header   (fb_info_t *fb, unsigned char *d);
+extern int          fb_cap_frame    (fb_cap_t *cap, bool key);
+extern void         fb_cap_close    (fb_cap_t *cap);
+extern fb_cap_t     *fb_cap_init    (fb_info_t *fb, const char *fname, int key_int);
+extern int          fb_cap_read     (fb_cap_rd_t *rd);
+extern void         fb_cap_rd_close (fb_cap_rd_t *rd);
+extern fb_cap_rd_t  *fb_cap_rd_init (const char *fname);
+extern fb_cap_rd_t  *fb_cap_rd_fdopen (int fd);
+
+//-----------------------------------------------------------------------------
+#endif  // #define __FB_CAP_H__
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
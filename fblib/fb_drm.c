@@ -0,0 +1,593 @@
+//-----------------------------------------------------------------------------
+//
+// DRM/KMS dumb buffer backend (fbdev emulation 없이 page flip 으로 화면 반영)
+//
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#if __has_include(<drm/drm_mode.h>)
+#include <drm/drm.h>
+#include <drm/drm_mode.h>
+#elif __has_include(<libdrm/drm_mode.h>)
+#include <libdrm/drm.h>
+#include <libdrm/drm_mode.h>
+#else
+//-----------------------------------------------------------------------------
+/*
+    kernel uapi header (linux-libc-dev/libdrm-dev) 가 없는 system 에서도 build 하기 위해
+    사용하는 ioctl 만 정의함. (kernel ABI 이므로 drm_mode.h 와 같은 배치)
+*/
+//-----------------------------------------------------------------------------
+#include <linux/types.h>
+
+#define DRM_IOCTL_BASE              'd'
+#define DRM_IO(nr)                  _IO(DRM_IOCTL_BASE, nr)
+#define DRM_IOWR(nr, type)          _IOWR(DRM_IOCTL_BASE, nr, type)
+
+#define DRM_MODE_TYPE_PREFERRED     (1 << 3)
+#define DRM_MODE_CONNECTED          1
+#define DRM_MODE_PAGE_FLIP_EVENT    0x01
+#define DRM_EVENT_FLIP_COMPLETE     0x02
+
+struct drm_mode_modeinfo {
+    __u32   clock;
+    __u16   hdisplay, hsync_start, hsync_end, htotal, hskew;
+    __u16   vdisplay, vsync_start, vsync_end, vtotal, vscan;
+    __u32   vrefresh;
+    __u32   flags;
+    __u32   type;
+    char    name[32];
+};
+
+struct drm_mode_card_res {
+    __u64   fb_id_ptr;
+    __u64   crtc_id_ptr;
+    __u64   connector_id_ptr;
+    __u64   encoder_id_ptr;
+    __u32   count_fbs;
+    __u32   count_crtcs;
+    __u32   count_connectors;
+    __u32   count_encoders;
+    __u32   min_width, max_width;
+    __u32   min_height, max_height;
+};
+
+struct drm_mode_crtc {
+    __u64   set_connectors_ptr;
+    __u32   count_connectors;
+    __u32   crtc_id;
+    __u32   fb_id;
+    __u32   x, y;
+    __u32   gamma_size;
+    __u32   mode_valid;
+    struct drm_mode_modeinfo mode;
+};
+
+struct drm_mode_get_encoder {
+    __u32   encoder_id;
+    __u32   encoder_type;
+    __u32   crtc_id;
+    __u32   possible_crtcs;
+    __u32   possible_clones;
+};
+
+struct drm_mode_get_connector {
+    __u64   encoders_ptr;
+    __u64   modes_ptr;
+    __u64   props_ptr;
+    __u64   prop_values_ptr;
+    __u32   count_modes;
+    __u32   count_props;
+    __u32   count_encoders;
+    __u32   encoder_id;
+    __u32   connector_id;
+    __u32   connector_type;
+    __u32   connector_type_id;
+    __u32   connection;
+    __u32   mm_width, mm_height;
+    __u32   subpixel;
+    __u32   pad;
+};
+
+struct drm_mode_fb_cmd {
+    __u32   fb_id;
+    __u32   width, height;
+    __u32   pitch;
+    __u32   bpp;
+    __u32   depth;
+    __u32   handle;
+};
+
+struct drm_mode_crtc_page_flip {
+    __u32   crtc_id;
+    __u32   fb_id;
+    __u32   flags;
+    __u32   reserved;
+    __u64   user_data;
+};
+
+struct drm_mode_create_dumb {
+    __u32   height, width;
+    __u32   bpp;
+    __u32   flags;
+    __u32   handle;
+    __u32   pitch;
+    __u64   size;
+};
+
+struct drm_mode_map_dumb {
+    __u32   handle;
+    __u32   pad;
+    __u64   offset;
+};
+
+struct drm_mode_destroy_dumb {
+    __u32   handle;
+};
+
+struct drm_event {
+    __u32   type;
+    __u32   length;
+};
+
+struct drm_event_vblank {
+    struct drm_event base;
+    __u64   user_data;
+    __u32   tv_sec, tv_usec;
+    __u32   sequence;
+    __u32   crtc_id;
+};
+
+#define DRM_IOCTL_SET_MASTER            DRM_IO(0x1e)
+#define DRM_IOCTL_DROP_MASTER           DRM_IO(0x1f)
+#define DRM_IOCTL_MODE_GETRESOURCES     DRM_IOWR(0xA0, struct drm_mode_card_res)
+#define DRM_IOCTL_MODE_GETCRTC          DRM_IOWR(0xA1, struct drm_mode_crtc)
+#define DRM_IOCTL_MODE_SETCRTC          DRM_IOWR(0xA2, struct drm_mode_crtc)
+#define DRM_IOCTL_MODE_GETENCODER       DRM_IOWR(0xA6, struct drm_mode_get_encoder)
+#define DRM_IOCTL_MODE_GETCONNECTOR     DRM_IOWR(0xA7, struct drm_mode_get_connector)
+#define DRM_IOCTL_MODE_ADDFB            DRM_IOWR(0xAE, struct drm_mode_fb_cmd)
+#define DRM_IOCTL_MODE_RMFB             DRM_IOWR(0xAF, unsigned int)
+#define DRM_IOCTL_MODE_PAGE_FLIP        DRM_IOWR(0xB0, struct drm_mode_crtc_page_flip)
+#define DRM_IOCTL_MODE_CREATE_DUMB      DRM_IOWR(0xB2, struct drm_mode_create_dumb)
+#define DRM_IOCTL_MODE_MAP_DUMB         DRM_IOWR(0xB3, struct drm_mode_map_dumb)
+#define DRM_IOCTL_MODE_DESTROY_DUMB     DRM_IOWR(0xB4, struct drm_mode_destroy_dumb)
+#endif
+
+#include "fblib.h"
+#include "fb_drm.h"
+
+//-----------------------------------------------------------------------------
+typedef struct fb_drm_buf__t {
+    unsigned int    handle, fb_id;
+    char            *map;
+}   fb_drm_buf_t;
+
+struct fb_drm__t {
+    unsigned int                crtc_id, conn_id;
+    struct drm_mode_modeinfo    mode;
+    /* 시작할 때의 crtc 설정 (종료시 복구) */
+    struct drm_mode_crtc        save;
+    fb_drm_buf_t                buf[2];
+    /* fb->data 로 사용중인 back buffer index */
+    int                         back;
+    /* page flip 을 지원하지 않는 driver 는 SETCRTC 로 교체 */
+    bool                        use_flip;
+    /* flip 요청 후 완료 event 를 아직 받지 못함 */
+    bool                        pending;
+    /* flip timeout 으로 damage 복사를 건너뜀, 다음 flip 에서 전체 화면 복사 */
+    bool                        resync;
+    unsigned long               flips, timeouts;
+};
+
+//-----------------------------------------------------------------------------
+// Function prototype define.
+//-----------------------------------------------------------------------------
+static int          _drm_ioctl      (int fd, unsigned long req, void *arg);
+static int          _drm_crtc       (int fd, struct drm_mode_card_res *res,
+                                    struct drm_mode_get_connector *conn, uint32_t *enc);
+static int          _drm_connector  (struct fb_drm__t *d, int fd, struct drm_mode_card_res *res);
+static int          _drm_find       (struct fb_drm__t *d, int fd);
+static int          _drm_buf_init   (fb_info_t *fb, fb_drm_buf_t *b);
+static int          _drm_wait       (struct fb_drm__t *d, int fd);
+static int          _drm_set_crtc   (struct fb_drm__t *d, int fd, unsigned int fb_id);
+int                 fb_drm_open     (fb_info_t *fb, const char *path);
+int                 fb_drm_flip     (fb_info_t *fb);
+void                fb_drm_close    (fb_info_t *fb);
+
+//-----------------------------------------------------------------------------
+static int _drm_ioctl (int fd, unsigned long req, void *arg)
+{
+    int ret;
+
+    do {
+        ret = ioctl (fd, req, arg);
+    } while ((ret < 0) && ((errno == EINTR) || (errno == EAGAIN)));
+    return ret;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    connector 에 연결된 crtc 를 찾음. 현재 연결된 encoder 의 crtc 를 우선 사용하고
+    없으면 encoder 가 사용할 수 있는 첫번째 crtc. return : crtc id, 0 = 없음
+*/
+static int _drm_crtc (int fd, struct drm_mode_card_res *res,
+                    struct drm_mode_get_connector *conn, uint32_t *enc)
+{
+    uint32_t *crtcs = (uint32_t *)(uintptr_t)res->crtc_id_ptr;
+    struct drm_mode_get_encoder e;
+    unsigned int i, j;
+
+    memset (&e, 0, sizeof(e));
+    if ((e.encoder_id = conn->encoder_id) &&
+        !_drm_ioctl (fd, DRM_IOCTL_MODE_GETENCODER, &e) && e.crtc_id)
+        return e.crtc_id;
+
+    for (i = 0; i < conn->count_encoders; i++) {
+        memset (&e, 0, sizeof(e));
+        e.encoder_id = enc[i];
+        if (_drm_ioctl (fd, DRM_IOCTL_MODE_GETENCODER, &e) < 0)
+            continue;
+        for (j = 0; j < res->count_crtcs; j++) {
+            if (e.possible_crtcs & (1u << j))
+                return crtcs[j];
+        }
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    연결된 첫번째 connector 의 preferred mode (없으면 첫번째 mode) 와 crtc 를 선택.
+*/
+static int _drm_connector (struct fb_drm__t *d, int fd, struct drm_mode_card_res *res)
+{
+    uint32_t *conns = (uint32_t *)(uintptr_t)res->connector_id_ptr;
+    struct drm_mode_get_connector c;
+    struct drm_mode_modeinfo *modes;
+    uint32_t *enc;
+    unsigned int i, m, n_modes, n_enc;
+
+    for (i = 0; i < res->count_connectors; i++) {
+        /* count 를 0 으로 요청하면 개수만 돌려줌 (mode 는 이때 다시 읽음) */
+        memset (&c, 0, sizeof(c));
+        c.connector_id = conns[i];
+        if ((_drm_ioctl (fd, DRM_IOCTL_MODE_GETCONNECTOR, &c) < 0) ||
+            (c.connection != DRM_MODE_CONNECTED) || !c.count_modes)
+            continue;
+
+        n_modes = c.count_modes;
+        n_enc   = c.count_encoders;
+        modes   = (struct drm_mode_modeinfo *)malloc (sizeof(*modes) * n_modes);
+        enc     = (uint32_t *)malloc (sizeof(uint32_t) * (n_enc + 1));
+        if ((modes == NULL) || (enc == NULL)) {
+            free (modes);   free (enc);
+            err("drm connector malloc error!\n");
+            return -1;
+        }
+        memset (&c, 0, sizeof(c));
+        c.connector_id   = conns[i];
+        c.count_modes    = n_modes;
+        c.modes_ptr      = (uintptr_t)modes;
+        c.count_encoders = n_enc;
+        c.encoders_ptr   = (uintptr_t)enc;
+
+        /* 두번의 요청 사이에 mode 가 늘어난 경우 data 가 채워지지 않으므로 사용하지 않음 */
+        if (!_drm_ioctl (fd, DRM_IOCTL_MODE_GETCONNECTOR, &c) &&
+            c.count_modes && (c.count_modes <= n_modes) && (c.count_encoders <= n_enc) &&
+            (d->crtc_id = _drm_crtc (fd, res, &c, enc))) {
+            for (m = 0; m < c.count_modes; m++) {
+                if (modes[m].type & DRM_MODE_TYPE_PREFERRED)
+                    break;
+            }
+            memcpy (&d->mode, &modes[(m < c.count_modes) ? m : 0], sizeof(d->mode));
+            d->conn_id = conns[i];
+        }
+        free (modes);   free (enc);
+        if (d->conn_id)
+            return 0;
+    }
+    err("drm : connected connector not found!\n");
+    return -1;
+}
+
+//-----------------------------------------------------------------------------
+static int _drm_find (struct fb_drm__t *d, int fd)
+{
+    struct drm_mode_card_res res;
+    uint32_t *ids = NULL;
+    int ret = -1;
+
+    memset (&res, 0, sizeof(res));
+    if (_drm_ioctl (fd, DRM_IOCTL_MODE_GETRESOURCES, &res) < 0) {
+        err("ioctl(DRM_IOCTL_MODE_GETRESOURCES), not a KMS device?\n");
+        return -1;
+    }
+    if (!res.count_crtcs || !res.count_connectors) {
+        err("drm : no crtc/connector!\n");
+        return -1;
+    }
+
+    /* crtc, connector id 만 읽음 (fb, encoder 는 count 0) */
+    if ((ids = (uint32_t *)malloc (sizeof(uint32_t) *
+                (res.count_crtcs + res.count_connectors))) == NULL) {
+        err("drm resource malloc error!\n");
+        return -1;
+    }
+    res.count_fbs        = 0;
+    res.count_encoders   = 0;
+    res.crtc_id_ptr      = (uintptr_t)ids;
+    res.connector_id_ptr = (uintptr_t)(ids + res.count_crtcs);
+    if (_drm_ioctl (fd, DRM_IOCTL_MODE_GETRESOURCES, &res) < 0)
+        err("ioctl(DRM_IOCTL_MODE_GETRESOURCES)\n");
+    else
+        ret = _drm_connector (d, fd, &res);
+
+    free (ids);
+    return ret;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    XRGB8888 dumb buffer 를 만들어 scanout 용 fb 로 등록한 후 mmap.
+*/
+static int _drm_buf_init (fb_info_t *fb, fb_drm_buf_t *b)
+{
+    struct drm_mode_create_dumb cd;
+    struct drm_mode_map_dumb    md;
+    struct drm_mode_fb_cmd      fc;
+
+    memset (&cd, 0, sizeof(cd));
+    cd.width  = fb->w;
+    cd.height = fb->h;
+    cd.bpp    = 32;
+    if (_drm_ioctl (fb->fd, DRM_IOCTL_MODE_CREATE_DUMB, &cd) < 0) {
+        err("ioctl(DRM_IOCTL_MODE_CREATE_DUMB)\n");
+        return -1;
+    }
+    b->handle  = cd.handle;
+    fb->stride = cd.pitch;
+    fb->size   = cd.size;
+
+    memset (&fc, 0, sizeof(fc));
+    fc.width  = fb->w;
+    fc.height = fb->h;
+    fc.pitch  = cd.pitch;
+    fc.bpp    = 32;
+    fc.depth  = 24;
+    fc.handle = cd.handle;
+    if (_drm_ioctl (fb->fd, DRM_IOCTL_MODE_ADDFB, &fc) < 0) {
+        err("ioctl(DRM_IOCTL_MODE_ADDFB)\n");
+        return -1;
+    }
+    b->fb_id = fc.fb_id;
+
+    memset (&md, 0, sizeof(md));
+    md.handle = cd.handle;
+    if (_drm_ioctl (fb->fd, DRM_IOCTL_MODE_MAP_DUMB, &md) < 0) {
+        err("ioctl(DRM_IOCTL_MODE_MAP_DUMB)\n");
+        return -1;
+    }
+    b->map = (char *)mmap (NULL, cd.size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                            fb->fd, md.offset);
+    if (b->map == (char *)MAP_FAILED) {
+        b->map = NULL;
+        err("mmap");
+        return -1;
+    }
+    memset (b->map, 0x00, cd.size);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    요청한 page flip 의 완료 event (vblank) 를 기다림.
+    return : 0 = 완료, -1 = timeout 또는 error (pending 상태 유지, 다음 flip 전에 다시 기다림)
+*/
+static int _drm_wait (struct fb_drm__t *d, int fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    char buf[1024];
+    int ret, len, off;
+
+    while (d->pending) {
+        if ((ret = poll (&pfd, 1, FB_DRM_FLIP_TIMEOUT_MS)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (ret == 0)
+            return -1;
+        if ((len = read (fd, buf, sizeof(buf))) <= 0)
+            return -1;
+
+        for (off = 0; off + (int)sizeof(struct drm_event) <= len; ) {
+            struct drm_event *e = (struct drm_event *)(buf + off);
+
+            if (e->length < sizeof(struct drm_event))
+                break;
+            if (e->type == DRM_EVENT_FLIP_COMPLETE)
+                d->pending = false;
+            off += e->length;
+        }
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+static int _drm_set_crtc (struct fb_drm__t *d, int fd, unsigned int fb_id)
+{
+    struct drm_mode_crtc crtc;
+
+    memset (&crtc, 0, sizeof(crtc));
+    crtc.crtc_id            = d->crtc_id;
+    crtc.fb_id              = fb_id;
+    crtc.set_connectors_ptr = (uintptr_t)&d->conn_id;
+    crtc.count_connectors   = 1;
+    crtc.mode_valid         = 1;
+    memcpy (&crtc.mode, &d->mode, sizeof(crtc.mode));
+    return _drm_ioctl (fd, DRM_IOCTL_MODE_SETCRTC, &crtc);
+}
+
+//-----------------------------------------------------------------------------
+/*
+    "drm:/dev/dri/cardN" 으로 fb_init 에서 호출. 실패시 fb_close 에서 정리됨.
+    XRGB8888 은 memory 순서가 b,g,r,x 이므로 is_bgr 로 설정.
+*/
+int fb_drm_open (fb_info_t *fb, const char *path)
+{
+    struct fb_drm__t *d;
+
+    if ((d = (struct fb_drm__t *)malloc (sizeof(struct fb_drm__t))) == NULL) {
+        err("drm malloc error!\n");
+        return -1;
+    }
+    memset (d, 0, sizeof(struct fb_drm__t));
+    fb->drm = d;
+
+    if ((fb->fd = open (path, O_RDWR | O_CLOEXEC)) < 0) {
+        err("%s open fail!\n", path);
+        return -1;
+    }
+    /* 다른 process 가 master 인 경우 modeset 이 실패하므로 시도만 함 */
+    _drm_ioctl (fb->fd, DRM_IOCTL_SET_MASTER, NULL);
+
+    if (_drm_find (d, fb->fd) < 0)
+        return -1;
+
+    fb->w      = d->mode.hdisplay;
+    fb->h      = d->mode.vdisplay;
+    fb->bpp    = 32;
+    fb->is_bgr = true;
+    if (_drm_buf_init (fb, &d->buf[0]) || _drm_buf_init (fb, &d->buf[1]))
+        return -1;
+
+    d->save.crtc_id = d->crtc_id;
+    if (_drm_ioctl (fb->fd, DRM_IOCTL_MODE_GETCRTC, &d->save) < 0)
+        d->save.mode_valid = 0;
+
+    /* buf[0] 을 화면에 표시하고 buf[1] 에 그림 */
+    if (_drm_set_crtc (d, fb->fd, d->buf[0].fb_id) < 0) {
+        err("ioctl(DRM_IOCTL_MODE_SETCRTC)\n");
+        return -1;
+    }
+    d->use_flip = true;
+    d->back     = 1;
+    fb->base    = d->buf[1].map;
+    fb->data    = d->buf[1].map;
+    info("drm : %s, %dx%d@%d, crtc %u, connector %u\n",
+        path, fb->w, fb->h, d->mode.vrefresh, d->crtc_id, d->conn_id);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    fb_present 에서 호출. back buffer 를 vblank 에서 화면에 표시하고 완료될 때까지 기다린 후
+    이전 화면 buffer 에 이번 frame 의 damage 영역만 복사하여 다음 back buffer 로 사용.
+    (두 buffer 가 항상 같은 화면을 가지므로 그리는 쪽은 single buffer 처럼 변경 영역만 그림)
+*/
+int fb_drm_flip (fb_info_t *fb)
+{
+    struct fb_drm__t *d = fb->drm;
+    fb_drm_buf_t *cur = &d->buf[d->back], *next = &d->buf[d->back ^ 1];
+    struct drm_mode_crtc_page_flip f;
+    int i, y;
+
+    /* 이전 flip 이 timeout 된 경우 완료될 때까지 기다림 (표시중인 buffer 에 그리지 않도록) */
+    if (d->pending && _drm_wait (d, fb->fd) < 0) {
+        d->timeouts++;
+        return -1;
+    }
+
+    if (d->use_flip) {
+        memset (&f, 0, sizeof(f));
+        f.crtc_id   = d->crtc_id;
+        f.fb_id     = cur->fb_id;
+        f.flags     = DRM_MODE_PAGE_FLIP_EVENT;
+        f.user_data = (uintptr_t)d;
+        if (_drm_ioctl (fb->fd, DRM_IOCTL_MODE_PAGE_FLIP, &f) < 0) {
+            err("ioctl(DRM_IOCTL_MODE_PAGE_FLIP), use SETCRTC\n");
+            d->use_flip = false;
+        }
+        else {
+            d->pending = true;
+            /* next 가 아직 표시중이므로 교체하지 않고 현재 back buffer 를 계속 사용 */
+            if (_drm_wait (d, fb->fd) < 0) {
+                d->timeouts++;
+                d->resync = true;
+                return -1;
+            }
+        }
+    }
+    if (!d->use_flip && (_drm_set_crtc (d, fb->fd, cur->fb_id) < 0)) {
+        err("ioctl(DRM_IOCTL_MODE_SETCRTC)\n");
+        return -1;
+    }
+    d->flips++;
+
+    /* timeout 된 frame 의 damage 는 복사하지 못했으므로 전체 화면을 복사 */
+    if (d->resync) {
+        FB_COPY (fb, next->map, cur->map, fb->stride * fb->h);
+        d->resync = false;
+    }
+    for (i = 0; i < fb->damage_cnt; i++) {
+        fb_rect_t *r = &fb->damage[i];
+        int off = r->x * (fb->bpp >> 3), len = r->w * (fb->bpp >> 3);
+
+        for (y = r->y; y < r->y + r->h; y++)
+            FB_COPY (fb, next->map + y * fb->stride + off, cur->map + y * fb->stride + off, len);
+    }
+    d->back  ^= 1;
+    fb->base  = next->map;
+    fb->data  = next->map;
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+void fb_drm_close (fb_info_t *fb)
+{
+    struct fb_drm__t *d = fb->drm;
+    int i;
+
+    if (d == NULL)
+        return;
+
+    if (fb->fd >= 0) {
+        _drm_wait (d, fb->fd);
+        /* 시작할 때의 화면 (fbcon 등) 으로 복구 */
+        if (d->save.mode_valid && d->save.fb_id) {
+            d->save.set_connectors_ptr = (uintptr_t)&d->conn_id;
+            d->save.count_connectors   = 1;
+            _drm_ioctl (fb->fd, DRM_IOCTL_MODE_SETCRTC, &d->save);
+        }
+        for (i = 0; i < 2; i++) {
+            fb_drm_buf_t *b = &d->buf[i];
+
+            if (b->map)
+                munmap (b->map, fb->size);
+            if (b->fb_id)
+                _drm_ioctl (fb->fd, DRM_IOCTL_MODE_RMFB, &b->fb_id);
+            if (b->handle) {
+                struct drm_mode_destroy_dumb dd = { .handle = b->handle };
+                _drm_ioctl (fb->fd, DRM_IOCTL_MODE_DESTROY_DUMB, &dd);
+            }
+        }
+        _drm_ioctl (fb->fd, DRM_IOCTL_DROP_MASTER, NULL);
+        dbg("drm : flips %lu, timeouts %lu\n", d->flips, d->timeouts);
+    }
+    free (d);
+    fb->drm  = NULL;
+    fb->base = NULL;
+    fb->data = NULL;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
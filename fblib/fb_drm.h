@@ -0,0 +1,29 @@
+//-----------------------------------------------------------------------------
+//
+// DRM/KMS dumb buffer backend (fbdev emulation 없이 page flip 으로 화면 반영)
+//
+//-----------------------------------------------------------------------------
+#ifndef __FB_DRM_H__
+#define __FB_DRM_H__
+
+//-----------------------------------------------------------------------------
+/* "drm:" 만 사용하면 기본 장치 */
+#define FB_DRM_DEVICE           "/dev/dri/card0"
+
+/* flip 완료(vblank) event 를 기다리는 최대 시간 */
+#define FB_DRM_FLIP_TIMEOUT_MS  100
+
+//-----------------------------------------------------------------------------
+/*
+    연결된 첫번째 connector 의 preferred mode 로 crtc 를 설정하고 dumb buffer 2개를 할당.
+    fb->data 는 항상 화면에 표시되지 않는 back buffer 를 가리키며
+    fb_present 에서 fb_drm_flip 으로 교체함. (그리는 쪽은 fbdev 와 같은 fb_info_t API 사용)
+*/
+extern int          fb_drm_open     (fb_info_t *fb, const char *path);
+extern int          fb_drm_flip     (fb_info_t *fb);
+extern void         fb_drm_close    (fb_info_t *fb);
+
+//-----------------------------------------------------------------------------
+#endif  // #define __FB_DRM_H__
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
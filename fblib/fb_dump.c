@@ -0,0 +1,242 @@
+//-----------------------------------------------------------------------------
+//
+// frame dump (PPM / PNG image file)
+//
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "fblib.h"
+#include "fb_dump.h"
+
+//-----------------------------------------------------------------------------
+// Function prototype define.
+//-----------------------------------------------------------------------------
+static unsigned int _crc32      (unsigned int crc, const unsigned char *p, int len);
+static void         _put_be32   (unsigned char *p, unsigned int v);
+static void         _png_chunk  (FILE *fp, const char *type, const unsigned char *p, int len);
+static int          _png_block  (FILE *fp, unsigned int *crc, unsigned int *adler,
+                                    const unsigned char *p, int len, bool last);
+void                fb_dump_row (fb_info_t *fb, int y, unsigned char *rgb);
+unsigned int        fb_dump_crc (fb_info_t *fb);
+int                 fb_dump_ppm (fb_info_t *fb, const char *fname);
+int                 fb_dump_png (fb_info_t *fb, const char *fname);
+int                 fb_dump     (fb_info_t *fb, const char *fname);
+
+//-----------------------------------------------------------------------------
+/* zlib stored block 최대 크기 */
+#define PNG_BLOCK_MAX       65535
+
+//-----------------------------------------------------------------------------
+static unsigned int _crc32 (unsigned int crc, const unsigned char *p, int len)
+{
+    static unsigned int table[256];
+    unsigned int c;
+    int i, k;
+
+    if (table[1] == 0) {
+        for (i = 0; i < 256; i++) {
+            for (c = i, k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+    }
+    crc = ~crc;
+    while (len--)
+        crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+//-----------------------------------------------------------------------------
+static void _put_be32 (unsigned char *p, unsigned int v)
+{
+    p[0] = v >> 24;     p[1] = v >> 16;     p[2] = v >> 8;      p[3] = v;
+}
+
+//-----------------------------------------------------------------------------
+static void _png_chunk (FILE *fp, const char *type, const unsigned char *p, int len)
+{
+    unsigned char b[4];
+    unsigned int crc;
+
+    _put_be32 (b, len);                         fwrite (b, 1, 4, fp);
+    fwrite (type, 1, 4, fp);                    crc = _crc32 (0, (const unsigned char *)type, 4);
+    if (len) {
+        fwrite (p, 1, len, fp);                 crc = _crc32 (crc, p, len);
+    }
+    _put_be32 (b, crc);                         fwrite (b, 1, 4, fp);
+}
+
+//-----------------------------------------------------------------------------
+static int _png_block (FILE *fp, unsigned int *crc, unsigned int *adler,
+                        const unsigned char *p, int len, bool last)
+{
+    /* 압축하지 않은 deflate block (header 5 byte + data) */
+    unsigned char h[5];
+    unsigned int a = *adler & 0xFFFF, b = *adler >> 16;
+    int i;
+
+    h[0] = last ? 1 : 0;
+    h[1] = len;         h[2] = len >> 8;
+    h[3] = ~len;        h[4] = ~len >> 8;
+    fwrite (h, 1, 5, fp);       *crc = _crc32 (*crc, h, 5);
+    fwrite (p, 1, len, fp);     *crc = _crc32 (*crc, p, len);
+
+    for (i = 0; i < len; i++) {
+        a = (a + p[i]) % 65521;
+        b = (b + a)    % 65521;
+    }
+    *adler = (b << 16) | a;
+    return ferror (fp) ? -1 : 0;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    y line 을 R,G,B 순서의 byte 배열로 변환 (rgb 는 fb->w * 3 byte).
+*/
+void fb_dump_row (fb_info_t *fb, int y, unsigned char *rgb)
+{
+    int x, bpp = fb->bpp >> 3;
+    unsigned char *p = (unsigned char *)fb->data + y * fb->stride;
+
+    for (x = 0; x < fb->w; x++, p += bpp, rgb += 3) {
+        if (bpp == 2) {
+            /* 5/6 bit 값을 8 bit 로 확장 (상위 bit 를 하위에 반복) */
+            unsigned int v = *(unsigned short *)p, g = (v >> 5) & 0x3F;
+            unsigned int r = fb->is_bgr ? v >> 11 : v & 0x1F;
+            unsigned int b = fb->is_bgr ? v & 0x1F : v >> 11;
+
+            rgb[0] = (r << 3) | (r >> 2);
+            rgb[1] = (g << 2) | (g >> 4);
+            rgb[2] = (b << 3) | (b >> 2);
+        } else if (fb->is_bgr) {
+            rgb[0] = p[2];  rgb[1] = p[1];  rgb[2] = p[0];
+        } else {
+            rgb[0] = p[0];  rgb[1] = p[1];  rgb[2] = p[2];
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*
+    화면 memory 의 CRC32 (line 끝의 stride padding 제외). pixel 형식 그대로 계산하므로
+    같은 그림이라도 bpp, is_bgr 에 따라 값이 다름. (golden image 비교용)
+*/
+unsigned int fb_dump_crc (fb_info_t *fb)
+{
+    unsigned int crc = 0;
+    int y;
+
+    for (y = 0; y < fb->h; y++)
+        crc = _crc32 (crc, (unsigned char *)fb->data + y * fb->stride, fb->w * (fb->bpp >> 3));
+    return crc;
+}
+//-----------------------------------------------------------------------------
+int fb_dump_ppm (fb_info_t *fb, const char *fname)
+{
+    FILE *fp;
+    unsigned char *rgb;
+    int y, ret = 0;
+
+    if ((rgb = (unsigned char *)malloc(fb->w * 3)) == NULL) {
+        err("dump buffer malloc error!\n");
+        return -1;
+    }
+    if ((fp = fopen(fname, "wb")) == NULL) {
+        err("%s open fail!\n", fname);
+        free (rgb);
+        return -1;
+    }
+    fprintf (fp, "P6\n%d %d\n255\n", fb->w, fb->h);
+    for (y = 0; y < fb->h; y++) {
+        fb_dump_row (fb, y, rgb);
+        fwrite (rgb, 1, fb->w * 3, fp);
+    }
+    if (ferror (fp))
+        ret = -1;
+    if (fclose (fp))
+        ret = -1;
+    free (rgb);
+    return ret;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    zlib 없이 저장하기 위하여 압축하지 않은(stored) deflate block 으로 기록.
+    파일 크기는 raw 와 비슷하지만 일반 image viewer / 비교 tool 에서 바로 열 수 있음.
+*/
+int fb_dump_png (fb_info_t *fb, const char *fname)
+{
+    FILE *fp;
+    unsigned char *buf, hdr[13], b[4];
+    unsigned int crc, adler = 1;
+    long long raw = (long long)fb->h * (fb->w * 3 + 1), done = 0;
+    int blocks = (int)((raw + PNG_BLOCK_MAX - 1) / PNG_BLOCK_MAX);
+    int y, x, len = 0, ret = 0;
+
+    if ((buf = (unsigned char *)malloc(PNG_BLOCK_MAX + fb->w * 3 + 1)) == NULL) {
+        err("dump buffer malloc error!\n");
+        return -1;
+    }
+    if ((fp = fopen(fname, "wb")) == NULL) {
+        err("%s open fail!\n", fname);
+        free (buf);
+        return -1;
+    }
+    fwrite ("\x89PNG\r\n\x1a\n", 1, 8, fp);
+
+    /* IHDR : 8bit RGB, non-interlace */
+    _put_be32 (&hdr[0], fb->w);
+    _put_be32 (&hdr[4], fb->h);
+    hdr[8] = 8;     hdr[9] = 2;     hdr[10] = hdr[11] = hdr[12] = 0;
+    _png_chunk (fp, "IHDR", hdr, sizeof(hdr));
+
+    /* IDAT 은 크기를 미리 계산하여 1 개의 chunk 로 바로 기록 */
+    _put_be32 (b, 2 + blocks * 5 + raw + 4);        fwrite (b, 1, 4, fp);
+    fwrite ("IDAT\x78\x01", 1, 6, fp);
+    crc = _crc32 (0, (const unsigned char *)"IDAT\x78\x01", 6);
+
+    for (y = 0; y < fb->h; y++) {
+        /* line 마다 filter type 0 (none) */
+        buf[len++] = 0;
+        fb_dump_row (fb, y, &buf[len]);
+        len += fb->w * 3;
+
+        while ((len >= PNG_BLOCK_MAX) || ((y == fb->h - 1) && len)) {
+            x = (len > PNG_BLOCK_MAX) ? PNG_BLOCK_MAX : len;
+            done += x;
+            if (_png_block (fp, &crc, &adler, buf, x, done == raw))
+                ret = -1;
+            memmove (buf, &buf[x], len - x);
+            len -= x;
+        }
+    }
+    _put_be32 (b, adler);       fwrite (b, 1, 4, fp);   crc = _crc32 (crc, b, 4);
+    _put_be32 (b, crc);         fwrite (b, 1, 4, fp);
+    _png_chunk (fp, "IEND", NULL, 0);
+
+    if (ferror (fp))
+        ret = -1;
+    if (fclose (fp))
+        ret = -1;
+    free (buf);
+    return ret;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    파일 확장자가 .png 이면 PNG, 그 외에는 PPM 으로 저장.
+*/
+int fb_dump (fb_info_t *fb, const char *fname)
+{
+    const char *ext = strrchr (fname, '.');
+
+    if (ext && !strcasecmp (ext, ".png"))
+        return fb_dump_png (fb, fname);
+    return fb_dump_ppm (fb, fname);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
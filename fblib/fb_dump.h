@@ -0,0 +1,19 @@
+//-----------------------------------------------------------------------------
+//
+// frame dump (PPM / PNG image file)
+//
+//-----------------------------------------------------------------------------
+#ifndef __FB_DUMP_H__
+#define __FB_DUMP_H__
+
+//-----------------------------------------------------------------------------
+extern void         fb_dump_row     (fb_info_t *fb, int y, unsigned char *rgb);
+extern unsigned int fb_dump_crc     (fb_info_t *fb);
+extern int          fb_dump_ppm     (fb_info_t *fb, const char *fname);
+extern int          fb_dump_png     (fb_info_t *fb, const char *fname);
+extern int          fb_dump         (fb_info_t *fb, const char *fname);
+
+//-----------------------------------------------------------------------------
+#endif  // #define __FB_DUMP_H__
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
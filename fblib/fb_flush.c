@@ -0,0 +1,357 @@
+//-----------------------------------------------------------------------------
+//
+// 비동기 flush thread (RAM shadow buffer 에 그리고 화면 장치로의 복사는 별도 thread)
+//
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "fblib.h"
+#include "fb_flush.h"
+
+//-----------------------------------------------------------------------------
+/* fb_present 시점의 damage 목록과 해당 영역의 pixel (rect 순서, line 단위로 연속 저장) */
+typedef struct fb_flush_slot__t {
+    int             cnt;
+    fb_rect_t       rect[FB_DAMAGE_MAX];
+    char            *pix;
+    size_t          size;
+}   fb_flush_slot_t;
+
+struct fb_flush__t {
+    /* 화면 장치 memory (fb_flush_init 전의 fb->data), fb->data 로 사용하는 RAM buffer */
+    char            *dev;
+    char            *shadow;
+    size_t          shadow_size;
+    /* 장치 memory 에 대하여 선택된 fill kernel (종료시 복구) */
+    fb_fill32_f     fill32;
+
+    pthread_t       tid;
+    pthread_mutex_t mutex;
+    /* put = queue 에 frame 추가됨, get = flush thread 가 frame 을 장치에 복사함 */
+    pthread_cond_t  put, get;
+    bool            quit;
+
+    /* slot[head] 부터 cnt 개가 복사할 frame (복사가 끝나야 cnt 가 감소) */
+    int             depth, head, cnt;
+    fb_flush_slot_t slot[FB_FLUSH_DEPTH_MAX];
+    fb_flush_stat_t stat;
+};
+
+//-----------------------------------------------------------------------------
+// Function prototype define.
+//-----------------------------------------------------------------------------
+static unsigned long _flush_ns      (void);
+static int          _flush_pack     (fb_info_t *fb, fb_flush_slot_t *s);
+static size_t       _flush_copy     (struct fb_flush__t *f, fb_info_t *fb, fb_flush_slot_t *s);
+static void         _flush_direct   (struct fb_flush__t *f, fb_info_t *fb);
+static void         *_flush_thread  (void *arg);
+static int          _flush_shadow   (struct fb_flush__t *f, fb_info_t *fb);
+int                 fb_flush_init   (fb_info_t *fb, int depth);
+int                 fb_flush_queue  (fb_info_t *fb);
+void                fb_flush_sync   (fb_info_t *fb);
+void                fb_flush_remap  (fb_info_t *fb);
+int                 fb_flush_stat   (fb_info_t *fb, fb_flush_stat_t *s);
+void                fb_flush_close  (fb_info_t *fb);
+
+//-----------------------------------------------------------------------------
+static unsigned long _flush_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    damage 영역의 pixel 을 shadow buffer 에서 slot 으로 복사 (RAM 간 복사이므로 짧음).
+    이후 그리는 pixel 은 slot 에 영향이 없으므로 flush thread 는 이번 frame 을 그대로 복사함.
+*/
+static int _flush_pack (fb_info_t *fb, fb_flush_slot_t *s)
+{
+    size_t size = 0;
+    char *p;
+    int i, y, bpp = fb->bpp >> 3;
+
+    for (i = 0; i < fb->damage_cnt; i++)
+        size += (size_t)fb->damage[i].w * fb->damage[i].h * bpp;
+
+    if (size > s->size) {
+        if ((p = (char *)realloc (s->pix, size)) == NULL) {
+            err("flush slot malloc error!(size = %zu)\n", size);
+            return -1;
+        }
+        s->pix  = p;
+        s->size = size;
+    }
+    s->cnt = fb->damage_cnt;
+    memcpy (s->rect, fb->damage, sizeof(fb_rect_t) * fb->damage_cnt);
+
+    for (i = 0, p = s->pix; i < s->cnt; i++) {
+        fb_rect_t *r = &s->rect[i];
+        int len = r->w * bpp;
+
+        for (y = r->y; y < r->y + r->h; y++, p += len)
+            memcpy (p, fb->data + y * fb->stride + r->x * bpp, len);
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+static size_t _flush_copy (struct fb_flush__t *f, fb_info_t *fb, fb_flush_slot_t *s)
+{
+    char *p = s->pix;
+    int i, y, bpp = fb->bpp >> 3;
+
+    for (i = 0; i < s->cnt; i++) {
+        fb_rect_t *r = &s->rect[i];
+        int len = r->w * bpp;
+
+        for (y = r->y; y < r->y + r->h; y++, p += len)
+            FB_COPY (fb, f->dev + y * fb->stride + r->x * bpp, p, len);
+    }
+    return p - s->pix;
+}
+
+//-----------------------------------------------------------------------------
+static void _flush_direct (struct fb_flush__t *f, fb_info_t *fb)
+{
+    int i, y, bpp = fb->bpp >> 3;
+
+    for (i = 0; i < fb->damage_cnt; i++) {
+        fb_rect_t *r = &fb->damage[i];
+        int off = r->x * bpp, len = r->w * bpp;
+
+        for (y = r->y; y < r->y + r->h; y++)
+            FB_COPY (fb, f->dev + y * fb->stride + off, fb->data + y * fb->stride + off, len);
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void *_flush_thread (void *arg)
+{
+    fb_info_t *fb = (fb_info_t *)arg;
+    struct fb_flush__t *f = fb->flush;
+
+    size_t bytes;
+
+    pthread_mutex_lock (&f->mutex);
+    while (1) {
+        while (!f->cnt && !f->quit)
+            pthread_cond_wait (&f->put, &f->mutex);
+        /* 종료 요청 전에 queue 에 있는 frame 은 모두 복사 */
+        if (!f->cnt)
+            break;
+        pthread_mutex_unlock (&f->mutex);
+
+        bytes = _flush_copy (f, fb, &f->slot[f->head]);
+
+        pthread_mutex_lock (&f->mutex);
+        f->head = (f->head + 1) % f->depth;
+        f->cnt--;
+        f->stat.frames++;
+        f->stat.bytes += bytes;
+        pthread_cond_broadcast (&f->get);
+    }
+    pthread_mutex_unlock (&f->mutex);
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/* 현재 화면 장치의 내용으로 shadow buffer 를 만들고 fb->data 로 사용 */
+static int _flush_shadow (struct fb_flush__t *f, fb_info_t *fb)
+{
+    size_t size = (size_t)fb->stride * fb->h;
+    char *shadow;
+
+    shadow = (char *)mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (shadow == (char *)-1) {
+        err("mmap");
+        return -1;
+    }
+    if (f->shadow)
+        munmap (f->shadow, f->shadow_size);
+
+    memcpy (shadow, fb->data, size);
+    f->dev         = fb->data;
+    f->shadow      = shadow;
+    f->shadow_size = size;
+    fb->data       = shadow;
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+int fb_flush_init (fb_info_t *fb, int depth)
+{
+    struct fb_flush__t *f;
+
+    if (fb->drm || fb->flush) {
+        err("flush thread not available!(%s)\n", fb->drm ? "drm" : "already running");
+        return -1;
+    }
+    if (depth <= 0)
+        depth = FB_FLUSH_DEPTH;
+    if (depth > FB_FLUSH_DEPTH_MAX)
+        depth = FB_FLUSH_DEPTH_MAX;
+
+    if ((f = (struct fb_flush__t *)malloc (sizeof(struct fb_flush__t))) == NULL) {
+        err("flush malloc error!\n");
+        return -1;
+    }
+    memset (f, 0, sizeof(struct fb_flush__t));
+    f->depth = depth;
+
+    if (_flush_shadow (f, fb) < 0) {
+        free (f);
+        return -1;
+    }
+    pthread_mutex_init (&f->mutex, NULL);
+    pthread_cond_init  (&f->put, NULL);
+    pthread_cond_init  (&f->get, NULL);
+
+    /* 그리는 곳은 RAM 이므로 장치 memory 에 맞춘 fill kernel 은 사용하지 않음 (copy 는 장치 memory) */
+    fb->flush  = f;
+    f->fill32  = fb->fill32;
+    fb->fill32 = NULL;
+    if (pthread_create (&f->tid, NULL, _flush_thread, fb)) {
+        err("pthread_create error!\n");
+        fb->flush  = NULL;
+        fb->data   = f->dev;
+        fb->fill32 = f->fill32;
+        munmap (f->shadow, f->shadow_size);
+        pthread_cond_destroy (&f->put);
+        pthread_cond_destroy (&f->get);
+        pthread_mutex_destroy (&f->mutex);
+        free (f);
+        return -1;
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    fb_present 에서 hook 호출 후 이번 frame 의 damage 를 queue 에 추가.
+    queue 가 가득 찬 경우 flush thread 가 1 frame 을 복사할 때까지 기다림 (backpressure).
+    return : 0, -1 = slot 할당 실패 (장치에 바로 복사함)
+*/
+int fb_flush_queue (fb_info_t *fb)
+{
+    struct fb_flush__t *f = fb->flush;
+    fb_flush_slot_t *s;
+
+    pthread_mutex_lock (&f->mutex);
+    if (f->cnt == f->depth) {
+        unsigned long t = _flush_ns ();
+
+        while (f->cnt == f->depth)
+            pthread_cond_wait (&f->get, &f->mutex);
+        f->stat.stalls++;
+        f->stat.stall_ns += _flush_ns () - t;
+    }
+    /* flush thread 는 slot[head] 만 사용하므로 빈 slot 은 lock 없이 채움 */
+    s = &f->slot[(f->head + f->cnt) % f->depth];
+    pthread_mutex_unlock (&f->mutex);
+
+    if (_flush_pack (fb, s) < 0) {
+        /* 앞의 frame 을 덮어쓰지 않도록 queue 를 비운 후 복사 */
+        fb_flush_sync (fb);
+        _flush_direct (f, fb);
+        return -1;
+    }
+
+    pthread_mutex_lock (&f->mutex);
+    f->cnt++;
+    pthread_cond_signal (&f->put);
+    pthread_mutex_unlock (&f->mutex);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+/* queue 에 있는 모든 frame 이 화면 장치에 복사될 때까지 기다림 */
+void fb_flush_sync (fb_info_t *fb)
+{
+    struct fb_flush__t *f = fb->flush;
+
+    if (f == NULL)
+        return;
+
+    pthread_mutex_lock (&f->mutex);
+    while (f->cnt)
+        pthread_cond_wait (&f->get, &f->mutex);
+    pthread_mutex_unlock (&f->mutex);
+}
+
+//-----------------------------------------------------------------------------
+/*
+    화면 모드 변경으로 fb->data 가 새로운 장치 memory 로 바뀐 경우 호출 (fb_update_mode).
+    호출 전에 fb_flush_sync 로 이전 장치 memory 에 대한 복사가 끝나 있어야 함.
+*/
+void fb_flush_remap (fb_info_t *fb)
+{
+    struct fb_flush__t *f = fb->flush;
+
+    if ((f == NULL) || (fb->data == f->shadow))
+        return;
+
+    if (_flush_shadow (f, fb) < 0) {
+        /* shadow buffer 를 만들지 못하면 장치에 바로 그림 */
+        munmap (f->shadow, f->shadow_size);
+        f->shadow = NULL;
+        fb_flush_close (fb);
+    }
+}
+
+//-----------------------------------------------------------------------------
+int fb_flush_stat (fb_info_t *fb, fb_flush_stat_t *s)
+{
+    struct fb_flush__t *f = fb->flush;
+
+    if (f == NULL)
+        return -1;
+
+    pthread_mutex_lock (&f->mutex);
+    memcpy (s, &f->stat, sizeof(fb_flush_stat_t));
+    pthread_mutex_unlock (&f->mutex);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+void fb_flush_close (fb_info_t *fb)
+{
+    struct fb_flush__t *f = fb->flush;
+    int i;
+
+    if (f == NULL)
+        return;
+
+    /* queue 에 남은 frame 을 모두 복사한 후 종료 */
+    pthread_mutex_lock (&f->mutex);
+    f->quit = true;
+    pthread_cond_signal (&f->put);
+    pthread_mutex_unlock (&f->mutex);
+    pthread_join (f->tid, NULL);
+
+    dbg("flush : frames %lu, bytes %lu, stalls %lu (%lu us)\n",
+        f->stat.frames, f->stat.bytes, f->stat.stalls, f->stat.stall_ns / 1000);
+
+    if (fb->data == f->shadow)
+        fb->data = f->dev;
+    fb->fill32 = f->fill32;
+    if (f->shadow)
+        munmap (f->shadow, f->shadow_size);
+    for (i = 0; i < FB_FLUSH_DEPTH_MAX; i++)
+        free (f->slot[i].pix);
+    pthread_cond_destroy (&f->put);
+    pthread_cond_destroy (&f->get);
+    pthread_mutex_destroy (&f->mutex);
+    free (f);
+    fb->flush = NULL;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,40 @@
+//-----------------------------------------------------------------------------
+//
+// 비동기 flush thread (RAM shadow buffer 에 그리고 화면 장치로의 복사는 별도 thread)
+//
+//-----------------------------------------------------------------------------
+#ifndef __FB_FLUSH_H__
+#define __FB_FLUSH_H__
+
+//-----------------------------------------------------------------------------
+/* 화면 장치로 복사를 기다리는 frame 최대 개수 (가득 차면 fb_present 에서 대기) */
+#define FB_FLUSH_DEPTH      2
+#define FB_FLUSH_DEPTH_MAX  8
+
+//-----------------------------------------------------------------------------
+typedef struct fb_flush_stat__t {
+    /* 화면 장치로 복사한 frame 수, 복사한 byte 수 */
+    unsigned long   frames, bytes;
+    /* queue 가 가득 차서 fb_present 가 기다린 횟수 및 시간 */
+    unsigned long   stalls, stall_ns;
+}   fb_flush_stat_t;
+
+//-----------------------------------------------------------------------------
+/*
+    fb->data 를 RAM shadow buffer 로 바꾸고 flush thread 를 시작. (depth <= 0 이면 FB_FLUSH_DEPTH)
+    fb_present 는 damage 목록과 해당 pixel 을 queue 에 복사만 하고 바로 return 하며
+    flush thread 가 느린 화면 장치(SPI/USB 등)에 복사하는 동안 다음 frame 을 그림.
+    DRM 은 page flip 을 사용하므로 지원하지 않음.
+    damage 를 기록하지 않는 put_pixel 은 fb_damage_add 를 해야 화면에 반영됨.
+*/
+extern int          fb_flush_init   (fb_info_t *fb, int depth);
+extern int          fb_flush_queue  (fb_info_t *fb);
+extern void         fb_flush_sync   (fb_info_t *fb);
+extern void         fb_flush_remap  (fb_info_t *fb);
+extern int          fb_flush_stat   (fb_info_t *fb, fb_flush_stat_t *s);
+extern void         fb_flush_close  (fb_info_t *fb);
+
+//-----------------------------------------------------------------------------
+#endif  // #define __FB_FLUSH_H__
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
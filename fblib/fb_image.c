@@ -0,0 +1,539 @@
+//-----------------------------------------------------------------------------
+//
+// image (BMP, PPM, QOI) 읽기 및 cache (화면 pixel 형식으로 1번만 변환)
+//
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "fblib.h"
+#include "fb_stats.h"
+#include "fb_image.h"
+
+//-----------------------------------------------------------------------------
+// Function prototype define.
+//-----------------------------------------------------------------------------
+static unsigned int  _le16          (const unsigned char *p);
+static unsigned int  _le32          (const unsigned char *p);
+static unsigned int  _be32          (const unsigned char *p);
+static int          _image_dim      (const char *path, int w, int h);
+static int          _ppm_int        (const unsigned char **p, const unsigned char *e, int *val);
+static unsigned char *_ppm_decode   (const char *path, const unsigned char *buf, size_t len,
+                                    int *w, int *h);
+static int          _bmp_shift      (unsigned int mask, int *bits);
+static unsigned char *_bmp_decode   (const char *path, const unsigned char *buf, size_t len,
+                                    int *w, int *h);
+static unsigned char *_qoi_decode   (const char *path, const unsigned char *buf, size_t len,
+                                    int *w, int *h);
+static int          _image_native   (fb_image_t *img, const unsigned char *rgba);
+static fb_image_t   *_image_read    (fb_info_t *fb, const char *path);
+fb_image_t          *fb_image_load  (fb_info_t *fb, const char *path);
+void                fb_image_put    (fb_image_t *img);
+bool                fb_image_match  (fb_info_t *fb, fb_image_t *img);
+void                fb_image_draw   (fb_info_t *fb, fb_image_t *img, int x, int y);
+
+//-----------------------------------------------------------------------------
+/* 읽은 image 목록 (path, mtime, 변환된 형식이 같으면 공유) */
+static fb_image_t       *_img_list  = NULL;
+static pthread_mutex_t  _img_mutex  = PTHREAD_MUTEX_INITIALIZER;
+
+//-----------------------------------------------------------------------------
+static unsigned int _le16 (const unsigned char *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+//-----------------------------------------------------------------------------
+static unsigned int _le32 (const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+//-----------------------------------------------------------------------------
+static unsigned int _be32 (const unsigned char *p)
+{
+    return ((unsigned int)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+//-----------------------------------------------------------------------------
+static int _image_dim (const char *path, int w, int h)
+{
+    if ((w <= 0) || (h <= 0) || (w > FB_IMAGE_DIM_MAX) || (h > FB_IMAGE_DIM_MAX)) {
+        err("%s : invalid image size!(%d x %d)\n", path, w, h);
+        return -1;
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    decoder 는 file 내용을 r, g, b, a 순서의 pixel 로 변환 (malloc, 호출한 쪽에서 free).
+    error 인 경우 NULL.
+*/
+//-----------------------------------------------------------------------------
+static int _ppm_int (const unsigned char **p, const unsigned char *e, int *val)
+{
+    /* header 의 공백 및 '#' 주석을 건너뛰고 10진수 1개 */
+    const unsigned char *s = *p;
+    int v = 0, digits = 0;
+
+    while (s < e) {
+        if (*s == '#')
+            while ((s < e) && (*s != '\n'))
+                s++;
+        else if ((*s == ' ') || (*s == '\t') || (*s == '\r') || (*s == '\n'))
+            s++;
+        else
+            break;
+    }
+    for (; (s < e) && (*s >= '0') && (*s <= '9') && (v < 0x1000000); s++, digits++)
+        v = v * 10 + *s - '0';
+
+    *p   = s;
+    *val = v;
+    return digits ? 0 : -1;
+}
+
+//-----------------------------------------------------------------------------
+/* binary PPM (P6), maxval 255 이하 */
+static unsigned char *_ppm_decode (const char *path, const unsigned char *buf, size_t len,
+                                    int *w, int *h)
+{
+    const unsigned char *p = buf + 2, *e = buf + len;
+    unsigned char *rgba, *d;
+    int maxval, i;
+
+    if (_ppm_int (&p, e, w) || _ppm_int (&p, e, h) || _ppm_int (&p, e, &maxval) ||
+        (p >= e) || (maxval <= 0) || (maxval > 255)) {
+        err("%s : unsupported PPM header!\n", path);
+        return NULL;
+    }
+    if (_image_dim (path, *w, *h))
+        return NULL;
+
+    /* maxval 뒤의 공백 1개 다음부터 pixel */
+    p++;
+    if ((size_t)(e - p) < (size_t)*w * *h * 3) {
+        err("%s : PPM data too short!\n", path);
+        return NULL;
+    }
+    if ((rgba = (unsigned char *)malloc ((size_t)*w * *h * 4)) == NULL) {
+        err("%s : image malloc error!\n", path);
+        return NULL;
+    }
+    for (i = 0, d = rgba; i < *w * *h; i++, p += 3, d += 4) {
+        d[0] = p[0] * 255 / maxval;
+        d[1] = p[1] * 255 / maxval;
+        d[2] = p[2] * 255 / maxval;
+        d[3] = 0xFF;
+    }
+    return rgba;
+}
+
+//-----------------------------------------------------------------------------
+static int _bmp_shift (unsigned int mask, int *bits)
+{
+    int shift = 0;
+
+    for (*bits = 0; mask && !(mask & 1); mask >>= 1)
+        shift++;
+    for (; mask & 1; mask >>= 1)
+        (*bits)++;
+    return shift;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    압축하지 않은 BMP : 8bpp (palette), 24bpp, 32bpp (BI_RGB, BI_BITFIELDS).
+    높이가 음수이면 위쪽 line 부터 저장된 image.
+*/
+static unsigned char *_bmp_decode (const char *path, const unsigned char *buf, size_t len,
+                                    int *w, int *h)
+{
+    /* header 의 값은 신뢰할 수 없으므로 크기 계산은 size_t 로 하고 더하기 전에 범위 확인 */
+    size_t off, hdr, pal_cnt = 0;
+    unsigned int bpp, comp, mask[4] = { 0x00FF0000, 0x0000FF00, 0x000000FF, 0 };
+    unsigned long long div[4];
+    int shift[4], bits[4], stride, top_down, x, y, i;
+    const unsigned char *pal = NULL;
+    unsigned char *rgba, *d;
+
+    if (len < 54) {
+        err("%s : BMP header too short!\n", path);
+        return NULL;
+    }
+    off  = _le32 (buf + 10);
+    hdr  = _le32 (buf + 14);
+    *w   = (int)_le32 (buf + 18);
+    *h   = (int)_le32 (buf + 22);
+    bpp  = _le16 (buf + 28);
+    comp = _le32 (buf + 30);
+
+    /* INT_MIN 은 부호를 바꿀 수 없음 (_image_dim 에서 거부) */
+    if ((top_down = (*h < 0)) && (*h != INT_MIN))
+        *h = -*h;
+    if ((hdr < 40) || (hdr > len - 14) ||
+        !(((bpp == 8) && (comp == 0)) || ((bpp == 24) && (comp == 0)) ||
+          ((bpp == 32) && ((comp == 0) || (comp == 3))))) {
+        err("%s : unsupported BMP!(bpp = %u, compression = %u)\n", path, bpp, comp);
+        return NULL;
+    }
+    if (_image_dim (path, *w, *h))
+        return NULL;
+
+    if (bpp == 8) {
+        pal_cnt = _le32 (buf + 46) ? _le32 (buf + 46) : 256;
+        if ((pal_cnt > 256) || (pal_cnt * 4 > len - 14 - hdr)) {
+            err("%s : invalid BMP palette!\n", path);
+            return NULL;
+        }
+        pal     = buf + 14 + hdr;
+    }
+    /* BI_BITFIELDS : header 바로 뒤 (V4/V5 header 는 header 안) 에 r, g, b (a) mask */
+    if (comp == 3) {
+        if (54 + 12 > len)
+            return NULL;
+        for (i = 0; i < 3; i++)
+            mask[i] = _le32 (buf + 54 + i * 4);
+        mask[3] = ((hdr >= 56) && (54 + 16 <= len)) ? _le32 (buf + 54 + 12) : 0;
+    }
+    /* 32bit mask 도 있으므로 64bit 로 계산 */
+    for (i = 0; i < 4; i++) {
+        shift[i] = _bmp_shift (mask[i], &bits[i]);
+        div[i]   = (1ull << bits[i]) - 1;
+    }
+
+    stride = ((*w * bpp + 31) / 32) * 4;
+    if ((off > len) || ((size_t)stride * *h > len - off)) {
+        err("%s : BMP data too short!\n", path);
+        return NULL;
+    }
+    if ((rgba = (unsigned char *)malloc ((size_t)*w * *h * 4)) == NULL) {
+        err("%s : image malloc error!\n", path);
+        return NULL;
+    }
+
+    for (y = 0, d = rgba; y < *h; y++) {
+        const unsigned char *s = buf + off + (size_t)(top_down ? y : *h - 1 - y) * stride;
+
+        for (x = 0; x < *w; x++, d += 4) {
+            if (bpp == 8) {
+                /* palette 는 b, g, r, x */
+                const unsigned char *c = pal + ((s[x] < pal_cnt) ? s[x] : 0) * 4;
+
+                d[0] = c[2];    d[1] = c[1];    d[2] = c[0];    d[3] = 0xFF;
+            } else if (bpp == 24) {
+                d[0] = s[x * 3 + 2];    d[1] = s[x * 3 + 1];    d[2] = s[x * 3];
+                d[3] = 0xFF;
+            } else {
+                unsigned int v = _le32 (s + x * 4);
+
+                for (i = 0; i < 3; i++)
+                    d[i] = bits[i] ? ((v & mask[i]) >> shift[i]) * 255ull / div[i] : 0;
+                d[3] = bits[3] ? ((v & mask[3]) >> shift[3]) * 255ull / div[3] : 0xFF;
+            }
+        }
+    }
+    return rgba;
+}
+
+//-----------------------------------------------------------------------------
+/* QOI (https://qoiformat.org/qoi-specification.pdf), 3/4 channel */
+#define QOI_OP_INDEX    0x00
+#define QOI_OP_DIFF     0x40
+#define QOI_OP_LUMA     0x80
+#define QOI_OP_RUN      0xC0
+#define QOI_OP_RGB      0xFE
+#define QOI_OP_RGBA     0xFF
+#define QOI_MASK_2      0xC0
+#define QOI_HASH(c)     (((c)[0] * 3 + (c)[1] * 5 + (c)[2] * 7 + (c)[3] * 11) % 64)
+
+static unsigned char *_qoi_decode (const char *path, const unsigned char *buf, size_t len,
+                                    int *w, int *h)
+{
+    unsigned char index[64][4], px[4] = { 0, 0, 0, 0xFF }, *rgba, *d;
+    const unsigned char *p = buf + 14, *e;
+    size_t i, cnt;
+    int run = 0;
+
+    /* header 14 byte, 끝 표시 8 byte */
+    if (len < 14 + 8) {
+        err("%s : QOI header too short!\n", path);
+        return NULL;
+    }
+    *w = (int)_be32 (buf + 4);
+    *h = (int)_be32 (buf + 8);
+    if (((buf[12] != 3) && (buf[12] != 4)) || _image_dim (path, *w, *h))
+        return NULL;
+
+    if ((rgba = (unsigned char *)malloc ((size_t)*w * *h * 4)) == NULL) {
+        err("%s : image malloc error!\n", path);
+        return NULL;
+    }
+    memset (index, 0x00, sizeof(index));
+    e   = buf + len - 8;
+    cnt = (size_t)*w * *h;
+
+    for (i = 0, d = rgba; i < cnt; i++, d += 4) {
+        if (run)
+            run--;
+        else if (p < e) {
+            int b1 = *p++;
+
+            if (b1 == QOI_OP_RGB) {
+                if (p + 3 > e)  break;
+                px[0] = p[0];   px[1] = p[1];   px[2] = p[2];
+                p += 3;
+            } else if (b1 == QOI_OP_RGBA) {
+                if (p + 4 > e)  break;
+                px[0] = p[0];   px[1] = p[1];   px[2] = p[2];   px[3] = p[3];
+                p += 4;
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+                memcpy (px, index[b1], 4);
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+                px[0] += ((b1 >> 4) & 0x03) - 2;
+                px[1] += ((b1 >> 2) & 0x03) - 2;
+                px[2] += ( b1       & 0x03) - 2;
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+                int b2, vg;
+
+                if (p >= e)     break;
+                b2 = *p++;
+                vg = (b1 & 0x3F) - 32;
+                px[0] += vg - 8 + ((b2 >> 4) & 0x0F);
+                px[1] += vg;
+                px[2] += vg - 8 +  (b2       & 0x0F);
+            } else {
+                run = b1 & 0x3F;
+            }
+            memcpy (index[QOI_HASH(px)], px, 4);
+        }
+        else
+            break;
+        memcpy (d, px, 4);
+    }
+    if (i < cnt) {
+        err("%s : QOI data too short!\n", path);
+        free (rgba);
+        return NULL;
+    }
+    return rgba;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    r, g, b, a pixel 을 fb 의 pixel 형식으로 변환 (_draw_span 과 같은 byte 순서).
+    alpha 가 128 미만인 pixel 이 있으면 mask 를 만들어 그리지 않음 (layer 에서는 투명).
+*/
+static int _image_native (fb_image_t *img, const unsigned char *rgba)
+{
+    int i, n = img->w * img->h, bpp = img->bpp >> 3;
+    const unsigned char *s;
+    char *d;
+
+    img->stride = img->w * bpp;
+    if ((img->data = (char *)malloc ((size_t)img->stride * img->h)) == NULL)
+        return -1;
+
+    for (i = 0, s = rgba; i < n; i++, s += 4) {
+        if ((s[3] < 0x80) && (img->mask == NULL)) {
+            if ((img->mask = (unsigned char *)malloc (n)) == NULL)
+                return -1;
+            memset (img->mask, 1, n);
+        }
+        if (img->mask)
+            img->mask[i] = (s[3] >= 0x80);
+    }
+
+    for (i = 0, s = rgba, d = img->data; i < n; i++, s += 4, d += bpp) {
+        if (bpp == 2) {
+            unsigned short v = UINT_TO_565(RGB_TO_UINT(s[0], s[1], s[2]), img->is_bgr);
+
+            memcpy (d, &v, sizeof(v));
+            continue;
+        }
+        d[0] = img->is_bgr ? s[2] : s[0];
+        d[1] = s[1];
+        d[2] = img->is_bgr ? s[0] : s[2];
+        if (bpp == 4)
+            d[3] = 0xFF;
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+static fb_image_t *_image_read (fb_info_t *fb, const char *path)
+{
+    const unsigned char *buf;
+    unsigned char *rgba = NULL;
+    fb_image_t *img;
+    struct stat st;
+    int fd, w = 0, h = 0;
+
+    if ((fd = open (path, O_RDONLY)) < 0) {
+        err("%s open fail!\n", path);
+        return NULL;
+    }
+    if ((fstat (fd, &st) < 0) || (st.st_size < 4)) {
+        err("%s : invalid image file!\n", path);
+        close (fd);
+        return NULL;
+    }
+    buf = (const unsigned char *)mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    if (buf == MAP_FAILED) {
+        err("mmap");
+        return NULL;
+    }
+
+    if      (!memcmp (buf, "BM", 2))    rgba = _bmp_decode (path, buf, st.st_size, &w, &h);
+    else if (!memcmp (buf, "P6", 2))    rgba = _ppm_decode (path, buf, st.st_size, &w, &h);
+    else if (!memcmp (buf, "qoif", 4))  rgba = _qoi_decode (path, buf, st.st_size, &w, &h);
+    else
+        err("%s : unknown image format! (BMP, PPM(P6), QOI)\n", path);
+    munmap ((void *)buf, st.st_size);
+
+    if (rgba == NULL)
+        return NULL;
+
+    if ((img = (fb_image_t *)malloc (sizeof(fb_image_t))) == NULL) {
+        free (rgba);
+        return NULL;
+    }
+    memset (img, 0x00, sizeof(fb_image_t));
+    img->w        = w;
+    img->h        = h;
+    img->bpp      = fb->bpp;
+    img->is_bgr   = fb->is_bgr;
+    img->mtime    = st.st_mtim.tv_sec;
+    img->mtime_ns = st.st_mtim.tv_nsec;
+    img->ref      = 1;
+    strncpy (img->path, path, FB_IMAGE_PATH_MAX - 1);
+
+    if (_image_native (img, rgba) < 0) {
+        err("%s : image malloc error!\n", path);
+        free (img->data);
+        free (img->mask);
+        free (img);
+        img = NULL;
+    }
+    free (rgba);
+    return img;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    path 의 image 를 fb 형식으로 읽음. 같은 file(mtime 이 같음) 을 같은 형식으로 읽은 것이
+    cache 에 있으면 참조만 증가. file 이 변경된 경우 새로 읽음 (이전 image 는 참조가 없어지면 해제).
+    return : image (fb_image_put 으로 해제), NULL = error
+*/
+fb_image_t *fb_image_load (fb_info_t *fb, const char *path)
+{
+    fb_image_t *img;
+    struct stat st;
+
+    if (stat (path, &st) < 0) {
+        err("%s not found!\n", path);
+        return NULL;
+    }
+    pthread_mutex_lock (&_img_mutex);
+    for (img = _img_list; img; img = img->next) {
+        if (!strcmp (img->path, path) && fb_image_match (fb, img) &&
+            (img->mtime == st.st_mtim.tv_sec) && (img->mtime_ns == st.st_mtim.tv_nsec)) {
+            img->ref++;
+            pthread_mutex_unlock (&_img_mutex);
+            return img;
+        }
+    }
+    pthread_mutex_unlock (&_img_mutex);
+
+    /* decode 는 lock 없이 (다른 image 를 읽는 thread 를 막지 않도록) */
+    if ((img = _image_read (fb, path)) == NULL)
+        return NULL;
+
+    pthread_mutex_lock (&_img_mutex);
+    img->next = _img_list;
+    _img_list = img;
+    pthread_mutex_unlock (&_img_mutex);
+    return img;
+}
+
+//-----------------------------------------------------------------------------
+void fb_image_put (fb_image_t *img)
+{
+    fb_image_t **pp;
+
+    if (img == NULL)
+        return;
+
+    pthread_mutex_lock (&_img_mutex);
+    if (--img->ref > 0) {
+        pthread_mutex_unlock (&_img_mutex);
+        return;
+    }
+    for (pp = &_img_list; *pp; pp = &(*pp)->next) {
+        if (*pp == img) {
+            *pp = img->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock (&_img_mutex);
+
+    free (img->data);
+    free (img->mask);
+    free (img);
+}
+
+//-----------------------------------------------------------------------------
+/* image 가 fb 에 바로 복사할 수 있는 형식인지 (layer surface 는 fb 와 bpp 가 다를 수 있음) */
+bool fb_image_match (fb_info_t *fb, fb_image_t *img)
+{
+    return (img->bpp == fb->bpp) && (img->is_bgr == fb->is_bgr);
+}
+
+//-----------------------------------------------------------------------------
+/*
+    (x, y) 에 image 를 그림. 변환된 pixel 을 line 단위로 복사하며
+    투명 pixel 이 있는 image 는 연속된 불투명 pixel 단위로 복사.
+*/
+void fb_image_draw (fb_info_t *fb, fb_image_t *img, int x, int y)
+{
+    int c_x = x, c_y = y, w = img->w, h = img->h, bpp = img->bpp >> 3, i, j, k;
+
+    if (!fb_image_match (fb, img) || !fb_clip (fb, &c_x, &c_y, &w, &h))
+        return;
+
+    FB_STAT_BEGIN(t);
+    for (j = 0; j < h; j++) {
+        int sy = c_y - y + j, sx = c_x - x;
+        char *d = fb->data + (c_y + j) * fb->stride + c_x * bpp;
+        const char *s = img->data + sy * img->stride + sx * bpp;
+        const unsigned char *m;
+
+        if (img->mask == NULL) {
+            FB_COPY (fb, d, s, w * bpp);
+            continue;
+        }
+        for (i = 0, m = img->mask + sy * img->w + sx; i < w; i = k) {
+            for (; (i < w) && !m[i]; i++)
+                ;
+            for (k = i; (k < w) && m[k]; k++)
+                ;
+            if (k > i)
+                FB_COPY (fb, d + i * bpp, s + i * bpp, (k - i) * bpp);
+        }
+    }
+    FB_STAT_ADD(pixels, w * h);
+    fb_damage_add (fb, c_x, c_y, w, h);
+    FB_STAT_END(fill_ns, t);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,46 @@
+//-----------------------------------------------------------------------------
+//
+// image (BMP, PPM, QOI) 읽기 및 cache (화면 pixel 형식으로 1번만 변환)
+//
+//-----------------------------------------------------------------------------
+#ifndef __FB_IMAGE_H__
+#define __FB_IMAGE_H__
+
+#include <time.h>
+
+//-----------------------------------------------------------------------------
+/* image 최대 가로/세로 (잘못된 header 로 큰 memory 를 할당하지 않도록) */
+#define FB_IMAGE_DIM_MAX    8192
+#define FB_IMAGE_PATH_MAX   128
+
+//-----------------------------------------------------------------------------
+/*
+    fb 의 bpp, byte 순서로 변환된 image. 같은 file(path, mtime)과 형식은 cache 에서 공유하며
+    fb_image_put 으로 마지막 참조가 해제되면 free.
+*/
+typedef struct fb_image__t {
+    int                 w, h, bpp, stride;
+    bool                is_bgr;
+    /* fb 와 같은 형식의 pixel (stride = w * bpp / 8) */
+    char                *data;
+    /* 투명 pixel 이 있는 경우 pixel 별 표시 여부 (alpha >= 128), 없으면 NULL */
+    unsigned char       *mask;
+
+    /* cache key */
+    char                path[FB_IMAGE_PATH_MAX];
+    time_t              mtime;
+    long                mtime_ns;
+    int                 ref;
+    struct fb_image__t  *next;
+}   fb_image_t;
+
+//-----------------------------------------------------------------------------
+extern fb_image_t   *fb_image_load  (fb_info_t *fb, const char *path);
+extern void         fb_image_put    (fb_image_t *img);
+extern bool         fb_image_match  (fb_info_t *fb, fb_image_t *img);
+extern void         fb_image_draw   (fb_info_t *fb, fb_image_t *img, int x, int y);
+
+//-----------------------------------------------------------------------------
+#endif  // #define __FB_IMAGE_H__
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
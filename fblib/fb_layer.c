@@ -0,0 +1,278 @@
+//-----------------------------------------------------------------------------
+//
+// layer compositor (z-order / damage based recomposition)
+//
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fblib.h"
+#include "fb_layer.h"
+#include "fb_stats.h"
+
+//-----------------------------------------------------------------------------
+// Function prototype define.
+//-----------------------------------------------------------------------------
+static bool _rect_clip   (fb_rect_t *d, fb_rect_t *a, fb_rect_t *b);
+static void _rect_union  (fb_rect_t *d, fb_rect_t *s);
+static void _comp_sel    (unsigned int *row, const unsigned int *src,
+                            unsigned int a_mask, int n);
+static void _comp_rect   (fb_comp_t *comp, fb_rect_t *r);
+fb_info_t    *fb_comp_layer  (fb_comp_t *comp, int z);
+void         fb_comp_show    (fb_comp_t *comp, int z, bool visible);
+void         fb_comp_clear   (fb_comp_t *comp, int z, int x, int y, int w, int h);
+void         fb_comp_damage  (fb_comp_t *comp, int x, int y, int w, int h);
+int          fb_comp_present (fb_comp_t *comp);
+void         fb_comp_close   (fb_comp_t *comp);
+fb_comp_t    *fb_comp_init   (fb_info_t *fb, int cnt);
+
+//-----------------------------------------------------------------------------
+/*
+    각 layer 는 화면 크기의 메모리 surface 이며 일반 fb 와 같이 draw 함수로 그린다.
+    fb_comp_present 는 layer 들에 기록된 damage 영역만 아래 layer 부터 위 layer 순서로
+    합성하여 출력 fb 에 바로 쓴다. (위 layer 의 alpha = 0 인 pixel 은 아래 layer 가 보임)
+*/
+
+//-----------------------------------------------------------------------------
+static bool _rect_clip (fb_rect_t *d, fb_rect_t *a, fb_rect_t *b)
+{
+    int x2 = (a->x + a->w < b->x + b->w) ? a->x + a->w : b->x + b->w;
+    int y2 = (a->y + a->h < b->y + b->h) ? a->y + a->h : b->y + b->h;
+
+    d->x = (a->x > b->x) ? a->x : b->x;
+    d->y = (a->y > b->y) ? a->y : b->y;
+    d->w = x2 - d->x;
+    d->h = y2 - d->y;
+
+    return (d->w > 0) && (d->h > 0);
+}
+
+//-----------------------------------------------------------------------------
+static void _rect_union (fb_rect_t *d, fb_rect_t *s)
+{
+    int x2 = (d->x + d->w > s->x + s->w) ? d->x + d->w : s->x + s->w;
+    int y2 = (d->y + d->h > s->y + s->h) ? d->y + d->h : s->y + s->h;
+
+    d->x = (d->x < s->x) ? d->x : s->x;
+    d->y = (d->y < s->y) ? d->y : s->y;
+    d->w = x2 - d->x;
+    d->h = y2 - d->y;
+}
+
+//-----------------------------------------------------------------------------
+FB_CLONES static void _comp_sel (unsigned int *row, const unsigned int *src,
+                            unsigned int a_mask, int n)
+{
+    int i;
+
+    /* 조건 없이 저장해야 vectorize 됨 */
+    for (i = 0; i < n; i++)
+        row[i] = (src[i] & a_mask) ? src[i] : row[i];
+}
+
+//-----------------------------------------------------------------------------
+static void _comp_rect (fb_comp_t *comp, fb_rect_t *r)
+{
+    fb_info_t *fb = comp->fb;
+    fb_layer_t *l;
+    fb_rect_t c;
+    int y, i, z, base, top;
+    int zl[FB_LAYER_MAX], zcnt = 0;
+
+    /* 가장 아래에 보이는 layer 는 배경으로 그대로 복사 */
+    for (base = 0; base < comp->cnt; base++)
+        if (comp->layer[base].visible)
+            break;
+
+    /* 이 영역과 겹치는 내용이 있는 위쪽 layer 만 합성 */
+    for (z = base + 1; z < comp->cnt; z++) {
+        l = &comp->layer[z];
+        if (l->visible && _rect_clip (&c, &l->used, r))
+            zl[zcnt++] = z;
+    }
+
+    for (y = r->y; y < r->y + r->h; y++) {
+        unsigned int *row = comp->row;
+        char *dst = fb->data + y * fb->stride + r->x * (fb->bpp >> 3);
+
+        if (base < comp->cnt)
+            memcpy (row, comp->layer[base].surf->data +
+                        y * comp->layer[base].surf->stride + r->x * 4, r->w * 4);
+        else
+            memset (row, 0x00, r->w * 4);
+
+        for (top = 0; top < zcnt; top++) {
+            unsigned int *src = (unsigned int *)(comp->layer[zl[top]].surf->data +
+                        y * comp->layer[zl[top]].surf->stride) + r->x;
+
+            _comp_sel (row, src, comp->a_mask, r->w);
+        }
+
+        if (fb->bpp == 32)
+            FB_COPY (fb, dst, row, r->w * 4);
+        else if (fb->bpp == 16) {
+            /* layer 는 fb 와 같은 byte 순서로 그려져 있음 */
+            unsigned char *s = (unsigned char *)row;
+            for (i = 0; i < r->w; i++, s += 4) {
+                int c = fb->is_bgr ? RGB_TO_UINT(s[2], s[1], s[0]) : RGB_TO_UINT(s[0], s[1], s[2]);
+                ((unsigned short *)dst)[i] = UINT_TO_565(c, fb->is_bgr);
+            }
+        }
+        else {
+            unsigned char *s = (unsigned char *)row;
+            for (i = 0; i < r->w; i++, dst += 3, s += 4) {
+                dst[0] = s[0];  dst[1] = s[1];  dst[2] = s[2];
+            }
+        }
+    }
+    fb_damage_add (fb, r->x, r->y, r->w, r->h);
+}
+
+//-----------------------------------------------------------------------------
+fb_info_t *fb_comp_layer (fb_comp_t *comp, int z)
+{
+    if ((z < 0) || (z >= comp->cnt))
+        z = 0;
+    return comp->layer[z].surf;
+}
+
+//-----------------------------------------------------------------------------
+void fb_comp_show (fb_comp_t *comp, int z, bool visible)
+{
+    fb_layer_t *l;
+
+    if ((z < 0) || (z >= comp->cnt))
+        return;
+
+    l = &comp->layer[z];
+    if (l->visible != visible) {
+        l->visible = visible;
+        /* 그려진 내용이 있는 영역만 다시 합성 */
+        if (l->used.w && l->used.h)
+            fb_comp_damage (comp, l->used.x, l->used.y, l->used.w, l->used.h);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void fb_comp_clear (fb_comp_t *comp, int z, int x, int y, int w, int h)
+{
+    fb_info_t *surf;
+    int dy;
+
+    if ((z < 0) || (z >= comp->cnt))
+        return;
+
+    /* 영역을 투명(alpha = 0)으로 지움 */
+    surf = comp->layer[z].surf;
+    if (x < 0)              {   w += x;     x = 0;  }
+    if (y < 0)              {   h += y;     y = 0;  }
+    if (x + w > surf->w)        w = surf->w - x;
+    if (y + h > surf->h)        h = surf->h - y;
+    if ((w <= 0) || (h <= 0))
+        return;
+
+    for (dy = y; dy < y + h; dy++)
+        memset (surf->data + dy * surf->stride + x * 4, 0x00, w * 4);
+
+    if ((x == 0) && (y == 0) && (w == surf->w) && (h == surf->h))
+        memset (&comp->layer[z].used, 0x00, sizeof(fb_rect_t));
+
+    fb_damage_add (surf, x, y, w, h);
+}
+
+//-----------------------------------------------------------------------------
+void fb_comp_damage (fb_comp_t *comp, int x, int y, int w, int h)
+{
+    fb_rect_t r = { x, y, w, h }, s = { 0, 0, comp->fb->w, comp->fb->h };
+
+    /* 화면 범위 안의 영역만 다음 present 에서 다시 합성 */
+    if (_rect_clip (&r, &r, &s))
+        fb_rect_merge (comp->damage, &comp->damage_cnt, FB_DAMAGE_MAX, &r);
+}
+
+//-----------------------------------------------------------------------------
+int fb_comp_present (fb_comp_t *comp)
+{
+    fb_layer_t *l;
+    int z, i, cnt;
+    FB_STAT_BEGIN(t);
+
+    /* 각 layer 에서 변경된 영역을 모음 */
+    for (z = 0; z < comp->cnt; z++) {
+        l = &comp->layer[z];
+        for (i = 0; i < l->surf->damage_cnt; i++) {
+            fb_rect_t *r = &l->surf->damage[i];
+
+            if (l->used.w && l->used.h)
+                _rect_union (&l->used, r);
+            else
+                l->used = *r;
+
+            if (l->visible)
+                fb_rect_merge (comp->damage, &comp->damage_cnt, FB_DAMAGE_MAX, r);
+        }
+        fb_damage_clear (l->surf);
+    }
+
+    for (i = 0; i < comp->damage_cnt; i++) {
+        _comp_rect (comp, &comp->damage[i]);
+        FB_STAT_ADD(pixels, comp->damage[i].w * comp->damage[i].h);
+    }
+
+    cnt = comp->damage_cnt;
+    comp->damage_cnt = 0;
+    FB_STAT_END(flush_ns, t);
+    return cnt;
+}
+
+//-----------------------------------------------------------------------------
+void fb_comp_close (fb_comp_t *comp)
+{
+    int z;
+
+    if (comp) {
+        for (z = 0; z < comp->cnt; z++)
+            fb_close (comp->layer[z].surf);
+        if (comp->row)
+            free (comp->row);
+        free (comp);
+    }
+}
+
+//-----------------------------------------------------------------------------
+fb_comp_t *fb_comp_init (fb_info_t *fb, int cnt)
+{
+    fb_comp_t *comp;
+    int z;
+
+    if ((cnt <= 0) || (cnt > FB_LAYER_MAX)) {
+        err("layer count error!(cnt = %d)\n", cnt);
+        return NULL;
+    }
+    if ((comp = (fb_comp_t *)malloc(sizeof(fb_comp_t))) == NULL) {
+        err("compositor malloc error!\n");
+        return NULL;
+    }
+    memset (comp, 0x00, sizeof(fb_comp_t));
+    comp->fb = fb;
+
+    /* alpha 는 pixel 의 4번째 byte */
+    ((unsigned char *)&comp->a_mask)[3] = 0xFF;
+
+    if ((comp->row = (unsigned int *)malloc(fb->w * 4)) == NULL)
+        goto out;
+
+    for (z = 0; z < cnt; z++, comp->cnt++) {
+        if ((comp->layer[z].surf = fb_surface_init (fb->w, fb->h, 32, fb->is_bgr)) == NULL)
+            goto out;
+        comp->layer[z].visible = true;
+    }
+    return comp;
+out:
+    fb_comp_close (comp);
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,47 @@
+//-----------------------------------------------------------------------------
+//
+// layer compositor (z-order / damage based recomposition)
+//
+//-----------------------------------------------------------------------------
+#ifndef __FB_LAYER_H__
+#define __FB_LAYER_H__
+
+//-----------------------------------------------------------------------------
+#define FB_LAYER_MAX        4
+
+//-----------------------------------------------------------------------------
+typedef struct fb_layer__t {
+	/* 32bpp 메모리 surface, alpha = 0 인 pixel 은 투명 */
+	fb_info_t	*surf;
+	bool		visible;
+	/* 그려진 내용이 있는 영역, 겹치지 않는 layer 는 합성에서 제외 */
+	fb_rect_t	used;
+}	fb_layer_t;
+
+typedef struct fb_comp__t {
+	/* 합성 결과를 출력할 fb */
+	fb_info_t	*fb;
+	/* layer[0] 이 가장 아래 (배경) */
+	int			cnt;
+	fb_layer_t	layer[FB_LAYER_MAX];
+	/* 다시 합성할 영역 (layer 표시/숨김, 투명 영역 등) */
+	int			damage_cnt;
+	fb_rect_t	damage[FB_DAMAGE_MAX];
+	/* 1 line 합성 버퍼 */
+	unsigned int	*row;
+	unsigned int	a_mask;
+}	fb_comp_t;
+
+//-----------------------------------------------------------------------------
+extern fb_info_t    *fb_comp_layer  (fb_comp_t *comp, int z);
+extern void         fb_comp_show    (fb_comp_t *comp, int z, bool visible);
+extern void         fb_comp_clear   (fb_comp_t *comp, int z, int x, int y, int w, int h);
+extern void         fb_comp_damage  (fb_comp_t *comp, int x, int y, int w, int h);
+extern int          fb_comp_present (fb_comp_t *comp);
+extern void         fb_comp_close   (fb_comp_t *comp);
+extern fb_comp_t    *fb_comp_init   (fb_info_t *fb, int cnt);
+
+//-----------------------------------------------------------------------------
+#endif  // #define __FB_LAYER_H__
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,284 @@
+//-----------------------------------------------------------------------------
+//
+// framebuffer mirroring server (unix domain socket, damage 영역 전송)
+//
+//-----------------------------------------------------------------------------
+#define _GNU_SOURCE     /* accept4 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+
+#include "fblib.h"
+#include "fb_cap.h"
+#include "fb_mirror.h"
+
+//-----------------------------------------------------------------------------
+// Function prototype define.
+//-----------------------------------------------------------------------------
+static void         _mirror_drop    (fb_mirror_t *m, fb_mirror_client_t *c);
+static void         _mirror_wait    (fb_mirror_t *m, fb_mirror_client_t *c, bool out);
+static void         _mirror_send    (fb_mirror_t *m, fb_mirror_client_t *c);
+static void         _mirror_accept  (fb_mirror_t *m);
+static void         _mirror_hook    (fb_info_t *fb, void *arg);
+int                 fb_mirror_fd    (fb_mirror_t *m);
+int                 fb_mirror_poll  (fb_mirror_t *m, int timeout_ms);
+void                fb_mirror_close (fb_mirror_t *m);
+fb_mirror_t         *fb_mirror_init (fb_info_t *fb, const char *path);
+int                 fb_mirror_connect (const char *path);
+
+//-----------------------------------------------------------------------------
+static void _mirror_drop (fb_mirror_t *m, fb_mirror_client_t *c)
+{
+    epoll_ctl (m->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close (c->fd);
+    free (c->buf);
+    memset (c, 0, sizeof(fb_mirror_client_t));
+    c->fd = -1;
+}
+
+//-----------------------------------------------------------------------------
+static void _mirror_wait (fb_mirror_t *m, fb_mirror_client_t *c, bool out)
+{
+    /* 보낼 data 가 남아있는 경우에만 EPOLLOUT 을 기다림 */
+    struct epoll_event ev;
+
+    memset (&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN | (out ? EPOLLOUT : 0);
+    ev.data.ptr = c;
+    epoll_ctl (m->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+//-----------------------------------------------------------------------------
+static void _mirror_send (fb_mirror_t *m, fb_mirror_client_t *c)
+{
+    struct timespec now;
+    int n;
+
+    while (1) {
+        if (c->off == c->len) {
+            /* 이전 frame 전송 완료, 모아둔 변경 영역이 있으면 현재 화면으로 새로운 frame 생성 */
+            c->off = c->len = 0;
+            if (!c->damage_cnt)
+                break;
+            clock_gettime (CLOCK_MONOTONIC, &now);
+            c->len = fb_cap_enc (m->fb,
+                        (now.tv_sec - m->t0.tv_sec) * 1000 + (now.tv_nsec - m->t0.tv_nsec) / 1000000,
+                        c->damage, c->damage_cnt, c->buf, m->buf_size);
+            c->damage_cnt = 0;
+            if (c->len < 0) {
+                _mirror_drop (m, c);
+                return;
+            }
+            m->frames++;
+        }
+        n = send (c->fd, c->buf + c->off, c->len - c->off, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                break;
+            if (errno == EINTR)
+                continue;
+            _mirror_drop (m, c);
+            return;
+        }
+        c->off += n;
+    }
+    _mirror_wait (m, c, c->off != c->len);
+}
+
+//-----------------------------------------------------------------------------
+static void _mirror_accept (fb_mirror_t *m)
+{
+    fb_mirror_client_t *c = NULL;
+    struct epoll_event ev;
+    fb_rect_t full = { 0, 0, m->fb->w, m->fb->h };
+    int fd, i;
+
+    while ((fd = accept4 (m->lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        for (i = 0; i < FB_MIRROR_CLIENT_MAX; i++)
+            if (m->client[i].fd < 0) {
+                c = &m->client[i];
+                break;
+            }
+        if ((i == FB_MIRROR_CLIENT_MAX) ||
+            ((c->buf = (unsigned char *)malloc(m->buf_size)) == NULL)) {
+            err("mirror client refused!\n");
+            close (fd);
+            continue;
+        }
+        c->fd = fd;
+        memset (&ev, 0, sizeof(ev));
+        ev.events   = EPOLLIN;
+        ev.data.ptr = c;
+        epoll_ctl (m->epfd, EPOLL_CTL_ADD, fd, &ev);
+
+        /* stream header 후 첫 frame 은 전체 화면 */
+        c->len = fb_cap_header (m->fb, c->buf);
+        c->damage_cnt = 0;
+        fb_rect_merge (c->damage, &c->damage_cnt, FB_DAMAGE_MAX, &full);
+        _mirror_send (m, c);
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void _mirror_hook (fb_info_t *fb, void *arg)
+{
+    /* fb_present 에서 호출. 변경 영역을 client 별로 모으고 보낼 수 있는 client 에만 바로 전송 */
+    fb_mirror_t *m = (fb_mirror_t *)arg;
+    int i, j;
+
+    for (i = 0; i < FB_MIRROR_CLIENT_MAX; i++) {
+        fb_mirror_client_t *c = &m->client[i];
+
+        if (c->fd < 0)
+            continue;
+        if (c->damage_cnt || (c->off != c->len))
+            m->merged++;
+        for (j = 0; j < fb->damage_cnt; j++)
+            fb_rect_merge (c->damage, &c->damage_cnt, FB_DAMAGE_MAX, &fb->damage[j]);
+        if (c->off == c->len)
+            _mirror_send (m, c);
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*
+    scheduler 등에서 기다릴 fd. 읽을 수 있으면 fb_mirror_poll(m, 0) 호출.
+*/
+int fb_mirror_fd (fb_mirror_t *m)
+{
+    return m->epfd;
+}
+
+//-----------------------------------------------------------------------------
+int fb_mirror_poll (fb_mirror_t *m, int timeout_ms)
+{
+    struct epoll_event ev[FB_MIRROR_CLIENT_MAX + 1];
+    char tmp[64];
+    int i, n;
+
+    if ((n = epoll_wait (m->epfd, ev, FB_MIRROR_CLIENT_MAX + 1, timeout_ms)) < 0)
+        return (errno == EINTR) ? 0 : -1;
+
+    for (i = 0; i < n; i++) {
+        fb_mirror_client_t *c = (fb_mirror_client_t *)ev[i].data.ptr;
+
+        if (c == NULL) {
+            _mirror_accept (m);
+            continue;
+        }
+        if (c->fd < 0)
+            continue;
+        /* client 는 data 를 보내지 않음, 읽을 data 가 있다면 버리고 종료 여부만 확인 */
+        if (ev[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            int r = recv (c->fd, tmp, sizeof(tmp), MSG_DONTWAIT);
+            if ((r == 0) || ((r < 0) && (errno != EAGAIN) && (errno != EINTR))) {
+                _mirror_drop (m, c);
+                continue;
+            }
+        }
+        if (ev[i].events & EPOLLOUT)
+            _mirror_send (m, c);
+    }
+    return n;
+}
+
+//-----------------------------------------------------------------------------
+void fb_mirror_close (fb_mirror_t *m)
+{
+    int i;
+
+    if (m) {
+        fb_hook_del (m->fb, _mirror_hook, m);
+        for (i = 0; i < FB_MIRROR_CLIENT_MAX; i++)
+            if (m->client[i].fd >= 0)
+                _mirror_drop (m, &m->client[i]);
+        if (m->lfd >= 0) {
+            close (m->lfd);
+            unlink (m->path);
+        }
+        if (m->epfd >= 0)
+            close (m->epfd);
+        free (m);
+    }
+}
+
+//-----------------------------------------------------------------------------
+fb_mirror_t *fb_mirror_init (fb_info_t *fb, const char *path)
+{
+    fb_mirror_t *m;
+    struct sockaddr_un addr;
+    struct epoll_event ev;
+    int i;
+
+    if ((m = (fb_mirror_t *)malloc(sizeof(fb_mirror_t))) == NULL) {
+        err("mirror malloc error!\n");
+        return NULL;
+    }
+    memset (m, 0, sizeof(fb_mirror_t));
+    for (i = 0; i < FB_MIRROR_CLIENT_MAX; i++)
+        m->client[i].fd = -1;
+    m->fb       = fb;
+    m->buf_size = fb_cap_size (fb);
+    clock_gettime (CLOCK_MONOTONIC, &m->t0);
+
+    memset (&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy (addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    memcpy (m->path, addr.sun_path, sizeof(m->path));
+
+    m->epfd = epoll_create1 (EPOLL_CLOEXEC);
+    m->lfd  = socket (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if ((m->epfd < 0) || (m->lfd < 0)) {
+        err("mirror socket create error!\n");
+        goto out;
+    }
+    unlink (m->path);
+    if ((bind (m->lfd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+        (listen (m->lfd, FB_MIRROR_CLIENT_MAX) < 0)) {
+        err("%s bind/listen error!\n", m->path);
+        goto out;
+    }
+    memset (&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN;
+    ev.data.ptr = NULL;
+    if ((epoll_ctl (m->epfd, EPOLL_CTL_ADD, m->lfd, &ev) < 0) ||
+        (fb_hook_add (fb, _mirror_hook, m) < 0))
+        goto out;
+    return m;
+out:
+    fb_mirror_close (m);
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    viewer 에서 사용. 연결된 socket 은 fb_cap_rd_fdopen 으로 읽음.
+*/
+int fb_mirror_connect (const char *path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if ((fd = socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+        err("socket");
+        return -1;
+    }
+    memset (&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy (addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (connect (fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        err("%s connect fail!\n", path);
+        close (fd);
+        return -1;
+    }
+    return fd;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,50 @@
+//-----------------------------------------------------------------------------
+//
+// framebuffer mirroring server (unix domain socket, damage 영역 전송)
+//
+//-----------------------------------------------------------------------------
+#ifndef __FB_MIRROR_H__
+#define __FB_MIRROR_H__
+
+//-----------------------------------------------------------------------------
+#define FB_MIRROR_CLIENT_MAX    4
+
+//-----------------------------------------------------------------------------
+/*
+    client 로 전송하는 data 는 capture stream(fb_cap) 과 같은 형식이며 모든 frame 이 keyframe 형식.
+    이전 frame 을 아직 보내지 못한 느린 client 는 damage 만 모아두었다가
+    socket 에 쓸 수 있을 때 현재 화면으로 한번에 보냄. (render 는 socket 때문에 대기하지 않음)
+*/
+typedef struct fb_mirror_client__t {
+    int             fd;
+    /* 전송중인 data (len byte 중 off 까지 전송함) */
+    unsigned char   *buf;
+    int             len, off;
+    /* 아직 보내지 않은 변경 영역 */
+    int             damage_cnt;
+    fb_rect_t       damage[FB_DAMAGE_MAX];
+}   fb_mirror_client_t;
+
+typedef struct fb_mirror__t {
+    fb_info_t           *fb;
+    /* listen socket 과 client socket 을 기다리는 epoll fd */
+    int                 epfd, lfd;
+    char                path[108];
+    int                 buf_size;
+    struct timespec     t0;
+    fb_mirror_client_t  client[FB_MIRROR_CLIENT_MAX];
+    /* 보낸 frame 수, 느린 client 로 인하여 합쳐진 frame 수 */
+    unsigned long       frames, merged;
+}   fb_mirror_t;
+
+//-----------------------------------------------------------------------------
+extern int          fb_mirror_fd    (fb_mirror_t *m);
+extern int          fb_mirror_poll  (fb_mirror_t *m, int timeout_ms);
+extern void         fb_mirror_close (fb_mirror_t *m);
+extern fb_mirror_t  *fb_mirror_init (fb_info_t *fb, const char *path);
+extern int          fb_mirror_connect (const char *path);
+
+//-----------------------------------------------------------------------------
+#endif  // #define __FB_MIRROR_H__
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,404 @@
+//-----------------------------------------------------------------------------
+//
+// 화면 장치 memory 쓰기 속도 측정 및 fill/copy kernel 선택
+//
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FB_PROBE_NT
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define FB_PROBE_NT
+#endif
+
+#include "fblib.h"
+#include "fb_stats.h"
+#include "fb_probe.h"
+
+//-----------------------------------------------------------------------------
+// Function prototype define.
+//-----------------------------------------------------------------------------
+static void         _fill_byte      (unsigned int *p, unsigned int v, int n);
+static void         _fill_word      (unsigned int *p, unsigned int v, int n);
+static void         _fill_vec       (unsigned int *p, unsigned int v, int n);
+static void         _copy_byte      (void *d, const void *s, int n);
+static void         _copy_word      (void *d, const void *s, int n);
+static void         _copy_vec       (void *d, const void *s, int n);
+#if defined(FB_PROBE_NT)
+static void         _fill_nt        (unsigned int *p, unsigned int v, int n);
+static void         _copy_nt        (void *d, const void *s, int n);
+#endif
+static unsigned long _probe_ns      (void);
+static unsigned int _probe_mbs      (fb_info_t *fb, int kern, const char *src, int rows, int len);
+static int          _probe_best     (const unsigned int *mbs);
+static void         _probe_key      (fb_info_t *fb, char *key, int size);
+static int          _probe_load     (fb_info_t *fb, fb_probe_t *p, const char *cache);
+static void         _probe_save     (fb_info_t *fb, fb_probe_t *p, const char *cache);
+const char          *fb_probe_name  (int kern);
+void                fb_probe_apply  (fb_info_t *fb, const fb_probe_t *p);
+int                 fb_probe_run    (fb_info_t *fb, fb_probe_t *p);
+int                 fb_probe        (fb_info_t *fb, const char *cache);
+
+//-----------------------------------------------------------------------------
+/*
+    장치 memory 는 mapping 방식(write-combine, uncached)에 따라 같은 저장이라도 속도가 크게 다름.
+    byte/word kernel 은 volatile 로 compiler 가 묶거나 vectorize 하지 못하게 함.
+*/
+//-----------------------------------------------------------------------------
+static void _fill_byte (unsigned int *p, unsigned int v, int n)
+{
+    volatile unsigned char *d = (volatile unsigned char *)p;
+    unsigned char b[4];
+
+    memcpy (b, &v, sizeof(b));
+    for (; n > 0; n--, d += 4) {
+        d[0] = b[0];    d[1] = b[1];    d[2] = b[2];    d[3] = b[3];
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void _fill_word (unsigned int *p, unsigned int v, int n)
+{
+    volatile unsigned int *d = p;
+
+    for (; n > 0; n--)
+        *d++ = v;
+}
+
+//-----------------------------------------------------------------------------
+FB_CLONES static void _fill_vec (unsigned int *p, unsigned int v, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        p[i] = v;
+}
+
+//-----------------------------------------------------------------------------
+static void _copy_byte (void *d, const void *s, int n)
+{
+    volatile unsigned char *vd = (volatile unsigned char *)d;
+    const unsigned char *vs = (const unsigned char *)s;
+
+    for (; n > 0; n--)
+        *vd++ = *vs++;
+}
+
+//-----------------------------------------------------------------------------
+static void _copy_word (void *d, const void *s, int n)
+{
+    /* 장치 memory 에는 정렬된 32bit 저장만 사용 (uncached mapping 은 unaligned 저장 불가) */
+    volatile unsigned char *bd = (volatile unsigned char *)d;
+    const unsigned char *bs = (const unsigned char *)s;
+    unsigned int v;
+
+    for (; n && ((uintptr_t)bd & 3); n--)
+        *bd++ = *bs++;
+    for (; n >= 4; n -= 4, bd += 4, bs += 4) {
+        memcpy (&v, bs, sizeof(v));
+        *(volatile unsigned int *)bd = v;
+    }
+    for (; n > 0; n--)
+        *bd++ = *bs++;
+}
+
+//-----------------------------------------------------------------------------
+static void _copy_vec (void *d, const void *s, int n)
+{
+    memcpy (d, s, n);
+}
+
+#if defined(FB_PROBE_NT)
+//-----------------------------------------------------------------------------
+static void _fill_nt (unsigned int *p, unsigned int v, int n)
+{
+    for (; n && ((uintptr_t)p & 15); n--)
+        *p++ = v;
+#if defined(__aarch64__)
+    uint32x4_t q = vdupq_n_u32 (v);
+
+    for (; n >= 8; n -= 8, p += 8)
+        __asm__ volatile ("stnp %q1, %q1, [%0]" : : "r" (p), "w" (q) : "memory");
+#else
+    __m128i q = _mm_set1_epi32 ((int)v);
+
+    for (; n >= 4; n -= 4, p += 4)
+        _mm_stream_si128 ((__m128i *)p, q);
+    _mm_sfence ();
+#endif
+    for (; n > 0; n--)
+        *p++ = v;
+}
+
+//-----------------------------------------------------------------------------
+static void _copy_nt (void *d, const void *s, int n)
+{
+    unsigned char *bd = (unsigned char *)d;
+    const unsigned char *bs = (const unsigned char *)s;
+
+    for (; n && ((uintptr_t)bd & 15); n--)
+        *bd++ = *bs++;
+#if defined(__aarch64__)
+    for (; n >= 32; n -= 32, bd += 32, bs += 32) {
+        uint8x16_t a = vld1q_u8 (bs), b = vld1q_u8 (bs + 16);
+
+        __asm__ volatile ("stnp %q1, %q2, [%0]" : : "r" (bd), "w" (a), "w" (b) : "memory");
+    }
+#else
+    for (; n >= 16; n -= 16, bd += 16, bs += 16)
+        _mm_stream_si128 ((__m128i *)bd, _mm_loadu_si128 ((const __m128i *)bs));
+    _mm_sfence ();
+#endif
+    if (n > 0)
+        memcpy (bd, bs, n);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+static const fb_fill32_f _fill_kern[eFB_KERN_END] = {
+    _fill_byte, _fill_word, _fill_vec,
+#if defined(FB_PROBE_NT)
+    _fill_nt,
+#else
+    NULL,
+#endif
+};
+
+static const fb_copy_f _copy_kern[eFB_KERN_END] = {
+    _copy_byte, _copy_word, _copy_vec,
+#if defined(FB_PROBE_NT)
+    _copy_nt,
+#else
+    NULL,
+#endif
+};
+
+static const char *_kern_name[eFB_KERN_END] = { "byte", "word", "vec", "nt" };
+
+//-----------------------------------------------------------------------------
+static unsigned long _probe_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    화면 memory 의 위쪽 rows line 에 FB_PROBE_MS 동안 반복하여 쓰고 MB/s 를 계산.
+    src 가 있으면 copy kernel (src 는 RAM), 없으면 fill kernel (32bpp) 을 측정.
+*/
+static unsigned int _probe_mbs (fb_info_t *fb, int kern, const char *src, int rows, int len)
+{
+    unsigned long t, ns, bytes = 0;
+    int y, pass;
+
+    if (src ? (_copy_kern[kern] == NULL) : (_fill_kern[kern] == NULL))
+        return 0;
+
+    /* 첫번째 pass 는 page fault, cache 등의 영향을 제외하기 위해 측정하지 않음 */
+    for (pass = 0, t = 0; ; pass++) {
+        if (pass == 1)
+            t = _probe_ns ();
+        for (y = 0; y < rows; y++) {
+            char *d = fb->data + y * fb->stride;
+
+            if (src)
+                _copy_kern[kern] (d, src + y * len, len);
+            else
+                _fill_kern[kern] ((unsigned int *)d, 0, len / 4);
+        }
+        if (pass) {
+            bytes += (unsigned long)rows * len;
+            if ((ns = _probe_ns () - t) >= FB_PROBE_MS * 1000000UL)
+                break;
+        }
+    }
+    return (unsigned int)(bytes * 1000 / ns);
+}
+
+//-----------------------------------------------------------------------------
+static int _probe_best (const unsigned int *mbs)
+{
+    int i, best = -1;
+
+    for (i = 0; i < eFB_KERN_END; i++)
+        if (mbs[i] && ((best < 0) || (mbs[i] > mbs[best])))
+            best = i;
+    return best;
+}
+
+//-----------------------------------------------------------------------------
+/* 같은 장치라도 mode 가 다르면 mapping 이 다를 수 있으므로 화면 정보로 구분 */
+static void _probe_key (fb_info_t *fb, char *key, int size)
+{
+    snprintf (key, size, "%s:%dx%dx%d/%d",
+        fb->drm ? "drm" : fb->is_mem ? "mem" : "fb", fb->w, fb->h, fb->bpp, fb->stride);
+}
+
+//-----------------------------------------------------------------------------
+static int _probe_load (fb_info_t *fb, fb_probe_t *p, const char *cache)
+{
+    char line[256], key[64], f_key[64];
+    unsigned int *f = p->fill_mbs, *c = p->copy_mbs;
+    FILE *fp;
+    int ret = -1;
+
+    if ((fp = fopen (cache, "r")) == NULL)
+        return -1;
+
+    _probe_key (fb, key, sizeof(key));
+    while (fgets (line, sizeof(line), fp)) {
+        if ((line[0] == '#') ||
+            (sscanf (line, "%63s %u %u %u %u %u %u %u %u", f_key,
+                &f[0], &f[1], &f[2], &f[3], &c[0], &c[1], &c[2], &c[3]) != 9) ||
+            strcmp (key, f_key))
+            continue;
+        p->fill   = _probe_best (p->fill_mbs);
+        p->copy   = _probe_best (p->copy_mbs);
+        p->cached = true;
+        ret = 0;
+        break;
+    }
+    fclose (fp);
+    return ret;
+}
+
+//-----------------------------------------------------------------------------
+static void _probe_save (fb_info_t *fb, fb_probe_t *p, const char *cache)
+{
+    /*
+        cache 는 장치/mode 별 1 line. 같은 key 의 line 만 바꾸고 나머지는 유지하며
+        임시 파일에 기록 후 rename (기록 중에 다른 process 가 읽어도 깨진 파일을 보지 않음)
+    */
+    unsigned int *f = p->fill_mbs, *c = p->copy_mbs;
+    char key[64], f_key[64], line[256], tmp[PATH_MAX];
+    FILE *fp, *old;
+
+    /* 임시 파일은 process 별 (동시에 측정한 process 가 서로의 임시 파일을 덮어쓰지 않음) */
+    if (snprintf (tmp, sizeof(tmp), "%s.%d", cache, (int)getpid ()) >= (int)sizeof(tmp))
+        return;
+    if ((fp = fopen (tmp, "w")) == NULL) {
+        err("%s write fail!\n", tmp);
+        return;
+    }
+    _probe_key (fb, key, sizeof(key));
+    fprintf (fp, "# fb_probe : key, fill MB/s (byte word vec nt), copy MB/s (byte word vec nt)\n");
+
+    if ((old = fopen (cache, "r")) != NULL) {
+        while (fgets (line, sizeof(line), old)) {
+            if ((line[0] == '#') || (sscanf (line, "%63s", f_key) != 1) || !strcmp (key, f_key))
+                continue;
+            fputs (line, fp);
+        }
+        fclose (old);
+    }
+    fprintf (fp, "%s %u %u %u %u %u %u %u %u\n", key,
+        f[0], f[1], f[2], f[3], c[0], c[1], c[2], c[3]);
+
+    if ((fclose (fp) != 0) || (rename (tmp, cache) < 0)) {
+        err("%s write fail!\n", cache);
+        unlink (tmp);
+    }
+}
+
+//-----------------------------------------------------------------------------
+const char *fb_probe_name (int kern)
+{
+    return ((kern >= 0) && (kern < eFB_KERN_END)) ? _kern_name[kern] : "default";
+}
+
+//-----------------------------------------------------------------------------
+/* 측정 결과를 fb 의 fill/copy kernel 로 설정하고 stats 에 기록 */
+void fb_probe_apply (fb_info_t *fb, const fb_probe_t *p)
+{
+    fb->fill32 = (p->fill >= 0) ? _fill_kern[p->fill] : NULL;
+    fb->copy   = (p->copy >= 0) ? _copy_kern[p->copy] : NULL;
+
+    fb_stats_probe (p->fill >= 0 ? p->fill_mbs[p->fill] : 0, fb_probe_name (p->fill),
+                    p->copy >= 0 ? p->copy_mbs[p->copy] : 0, fb_probe_name (p->copy));
+}
+
+//-----------------------------------------------------------------------------
+/*
+    화면 memory 에 kernel 별로 FB_PROBE_MS 동안 써서 속도를 측정. (화면 내용은 측정 후 복구)
+    fill 은 32bpp 에서만 사용하므로 다른 bpp 는 copy 만 측정.
+    return : 0, -1 = 측정 불가
+*/
+int fb_probe_run (fb_info_t *fb, fb_probe_t *p)
+{
+    int rows = FB_PROBE_BYTES / fb->stride, len = fb->w * (fb->bpp >> 3), y, k;
+    char *save;
+
+    memset (p, 0x00, sizeof(fb_probe_t));
+    p->fill = p->copy = -1;
+
+    if (rows > fb->h)
+        rows = fb->h;
+    if ((fb->data == NULL) || (rows <= 0))
+        return -1;
+
+    /* 측정에 사용하는 영역의 화면 내용 (copy 의 source 로도 사용) */
+    if ((save = (char *)malloc ((size_t)rows * len)) == NULL) {
+        err("probe malloc error!\n");
+        return -1;
+    }
+    for (y = 0; y < rows; y++)
+        memcpy (save + y * len, fb->data + y * fb->stride, len);
+
+    for (k = 0; k < eFB_KERN_END; k++) {
+        if (fb->bpp == 32)
+            p->fill_mbs[k] = _probe_mbs (fb, k, NULL, rows, len);
+        p->copy_mbs[k] = _probe_mbs (fb, k, save, rows, len);
+    }
+
+    for (y = 0; y < rows; y++)
+        memcpy (fb->data + y * fb->stride, save + y * len, len);
+    free (save);
+
+    p->fill = _probe_best (p->fill_mbs);
+    p->copy = _probe_best (p->copy_mbs);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    fb_init 에서 호출 (cache = FB_PROBE 환경변수).
+    NULL 또는 "0" = 사용 안함, "1" = 측정, 그 외 = cache file 에 같은 화면의 결과가 있으면 사용,
+    없으면 측정 후 저장. return : 0 = kernel 설정, -1 = 기본 kernel 사용
+*/
+int fb_probe (fb_info_t *fb, const char *cache)
+{
+    fb_probe_t p;
+    bool use_cache;
+
+    if ((cache == NULL) || !*cache || !strcmp (cache, "0"))
+        return -1;
+
+    use_cache = strcmp (cache, "1") != 0;
+    if (!use_cache || _probe_load (fb, &p, cache)) {
+        if (fb_probe_run (fb, &p))
+            return -1;
+        if (use_cache)
+            _probe_save (fb, &p, cache);
+    }
+    fb_probe_apply (fb, &p);
+
+    info("fb_probe : fill = %s (%u MB/s), copy = %s (%u MB/s)%s\n",
+        fb_probe_name (p.fill), p.fill >= 0 ? p.fill_mbs[p.fill] : 0,
+        fb_probe_name (p.copy), p.copy >= 0 ? p.copy_mbs[p.copy] : 0,
+        p.cached ? " (cached)" : "");
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,53 @@
+//-----------------------------------------------------------------------------
+//
+// 화면 장치 memory 쓰기 속도 측정 및 fill/copy kernel 선택
+//
+//-----------------------------------------------------------------------------
+#ifndef __FB_PROBE_H__
+#define __FB_PROBE_H__
+
+//-----------------------------------------------------------------------------
+/*
+    fb_init 에서 읽는 환경변수. 없거나 "0" 이면 측정하지 않음 (기본 kernel),
+    "1" 이면 실행할 때마다 측정, 그 외는 측정 결과를 저장/재사용할 cache file 경로.
+*/
+#define FB_PROBE_ENV        "FB_PROBE"
+
+/* kernel 1개당 측정 시간, 측정에 사용하는 화면 memory 최대 크기 */
+#define FB_PROBE_MS         10
+#define FB_PROBE_BYTES      (4 * 1024 * 1024)
+
+//-----------------------------------------------------------------------------
+/*
+    byte   : 1 byte 씩 저장
+    word   : 32bit 씩 저장
+    vec    : SIMD 저장 (fill = AVX2/SSE2/NEON vectorize, copy = libc memcpy)
+    nt     : non-temporal(streaming) 저장, cache 를 거치지 않음 (x86 SSE2, aarch64)
+*/
+enum eFB_KERN {
+    eFB_KERN_BYTE = 0,
+    eFB_KERN_WORD,
+    eFB_KERN_VEC,
+    eFB_KERN_NT,
+    eFB_KERN_END
+};
+
+typedef struct fb_probe__t {
+    /* 선택된 kernel (-1 = 측정하지 않음) */
+    int             fill, copy;
+    /* kernel 별 측정값 (MB/s, 사용할 수 없는 kernel 은 0) */
+    unsigned int    fill_mbs[eFB_KERN_END], copy_mbs[eFB_KERN_END];
+    /* cache file 에서 읽은 경우 */
+    bool            cached;
+}   fb_probe_t;
+
+//-----------------------------------------------------------------------------
+extern const char   *fb_probe_name  (int kern);
+extern void         fb_probe_apply  (fb_info_t *fb, const fb_probe_t *p);
+extern int          fb_probe_run    (fb_info_t *fb, fb_probe_t *p);
+extern int          fb_probe        (fb_info_t *fb, const char *cache);
+
+//-----------------------------------------------------------------------------
+#endif  // #define __FB_PROBE_H__
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,233 @@
+//-----------------------------------------------------------------------------
+//
+// runtime counters / per-frame timing
+//
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+
+#include "fblib.h"
+#include "fb_stats.h"
+
+//-----------------------------------------------------------------------------
+// Function prototype define.
+//-----------------------------------------------------------------------------
+static void  _fb_stats_sig  (int signo);
+int          fb_stats_get   (fb_stats_t *s);
+void         fb_stats_reset (void);
+void         fb_stats_frame (void);
+void         fb_stats_take  (fb_frame_stat_t *f);
+void         fb_stats_add   (const fb_frame_stat_t *f);
+void         fb_stats_probe (unsigned int fill_mbs, const char *fill_kern,
+                            unsigned int copy_mbs, const char *copy_kern);
+void         fb_stats_dump  (FILE *fp);
+void         fb_stats_poll  (void);
+int          fb_stats_signal(int signo);
+
+//-----------------------------------------------------------------------------
+/*
+    draw 함수의 pixel/span/glyph 개수와 fill, text, flush(합성 + present) 시간을 기록한다.
+    frame 구분은 fb_present. signal 에서는 flag 만 설정하고 다음 fb_present 또는
+    fb_stats_poll 에서 출력한다. FB_STATS 가 없으면 API 만 남고 기록은 하지 않음.
+*/
+static volatile sig_atomic_t _fb_stats_req = 0;
+
+/* fb_probe 결과는 FB_STATS 와 관계없이 기록, fb_stats_reset 으로 지우지 않음 */
+static unsigned int _fb_fill_mbs = 0, _fb_copy_mbs = 0;
+static const char   *_fb_fill_kern = NULL, *_fb_copy_kern = NULL;
+
+#if defined(FB_STATS)
+static fb_stats_t   _fb_stats;
+FB_TLS fb_frame_stat_t  _fb_frame;
+static FB_TLS int       _fb_stat_depth = 0;
+
+//-----------------------------------------------------------------------------
+unsigned long _fb_stat_begin (void)
+{
+    struct timespec ts;
+
+    if (_fb_stat_depth++)
+        return 0;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+//-----------------------------------------------------------------------------
+void _fb_stat_end (unsigned long *f, unsigned long t)
+{
+    struct timespec ts;
+
+    if (--_fb_stat_depth || !t)
+        return;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    *f += ts.tv_sec * 1000000000UL + ts.tv_nsec - t;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+static void _fb_stats_sig (int signo)
+{
+    (void)signo;
+    _fb_stats_req = 1;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    현재까지의 통계를 복사. return : 0, FB_STATS 없이 build 된 경우 -1
+*/
+int fb_stats_get (fb_stats_t *s)
+{
+#if defined(FB_STATS)
+    memcpy (s, &_fb_stats, sizeof(fb_stats_t));
+#else
+    memset (s, 0x00, sizeof(fb_stats_t));
+#endif
+    s->fill_mbs  = _fb_fill_mbs;     s->fill_kern = _fb_fill_kern;
+    s->copy_mbs  = _fb_copy_mbs;     s->copy_kern = _fb_copy_kern;
+#if defined(FB_STATS)
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+void fb_stats_reset (void)
+{
+#if defined(FB_STATS)
+    memset (&_fb_stats, 0x00, sizeof(fb_stats_t));
+    memset (&_fb_frame, 0x00, sizeof(fb_frame_stat_t));
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*
+    fb_present 에서 호출, 이번 frame 의 값을 누적하고 다음 frame 을 시작.
+*/
+void fb_stats_frame (void)
+{
+#if defined(FB_STATS)
+    fb_frame_stat_t *f = &_fb_frame, *w = &_fb_stats.worst;
+
+    _fb_stats.frames++;
+    _fb_stats.pixels   += f->pixels;
+    _fb_stats.spans    += f->spans;
+    _fb_stats.glyphs   += f->glyphs;
+    _fb_stats.fill_ns  += f->fill_ns;
+    _fb_stats.text_ns  += f->text_ns;
+    _fb_stats.flush_ns += f->flush_ns;
+    _fb_stats.last = *f;
+    if (f->fill_ns + f->text_ns + f->flush_ns > w->fill_ns + w->text_ns + w->flush_ns)
+        *w = *f;
+    memset (f, 0x00, sizeof(fb_frame_stat_t));
+#endif
+    fb_stats_poll ();
+}
+
+//-----------------------------------------------------------------------------
+/*
+    현재 thread 의 frame 값을 f 로 가져오고 초기화 (다른 thread 에서 그린 값을 합칠 때 사용).
+*/
+void fb_stats_take (fb_frame_stat_t *f)
+{
+#if defined(FB_STATS)
+    *f = _fb_frame;
+    memset (&_fb_frame, 0x00, sizeof(fb_frame_stat_t));
+#else
+    memset (f, 0x00, sizeof(fb_frame_stat_t));
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*
+    f 를 현재 thread 의 frame 값에 더함. 시간은 thread 별 시간의 합이므로 frame 시간보다 클 수 있음.
+*/
+void fb_stats_add (const fb_frame_stat_t *f)
+{
+#if defined(FB_STATS)
+    _fb_frame.pixels   += f->pixels;
+    _fb_frame.spans    += f->spans;
+    _fb_frame.glyphs   += f->glyphs;
+    _fb_frame.fill_ns  += f->fill_ns;
+    _fb_frame.text_ns  += f->text_ns;
+    _fb_frame.flush_ns += f->flush_ns;
+#else
+    (void)f;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*
+    fb_probe 에서 측정한 장치 memory 쓰기 속도와 선택된 kernel 을 기록.
+*/
+void fb_stats_probe (unsigned int fill_mbs, const char *fill_kern,
+                    unsigned int copy_mbs, const char *copy_kern)
+{
+    _fb_fill_mbs  = fill_mbs;     _fb_fill_kern = fill_kern;
+    _fb_copy_mbs  = copy_mbs;     _fb_copy_kern = copy_kern;
+}
+
+//-----------------------------------------------------------------------------
+void fb_stats_dump (FILE *fp)
+{
+#if defined(FB_STATS)
+    fb_stats_t *s = &_fb_stats;
+    unsigned long n = s->frames ? s->frames : 1;
+
+    fprintf(fp, "[FB_STATS] frames = %lu, pixels = %lu, spans = %lu, glyphs = %lu\n",
+        s->frames, s->pixels, s->spans, s->glyphs);
+    fprintf(fp, "[FB_STATS] avg  : fill = %lu us, text = %lu us, flush = %lu us\n",
+        s->fill_ns / n / 1000, s->text_ns / n / 1000, s->flush_ns / n / 1000);
+    fprintf(fp, "[FB_STATS] last : fill = %lu us, text = %lu us, flush = %lu us, "
+        "pixels = %lu, glyphs = %lu\n",
+        s->last.fill_ns / 1000, s->last.text_ns / 1000, s->last.flush_ns / 1000,
+        s->last.pixels, s->last.glyphs);
+    fprintf(fp, "[FB_STATS] worst: fill = %lu us, text = %lu us, flush = %lu us, "
+        "pixels = %lu, glyphs = %lu\n",
+        s->worst.fill_ns / 1000, s->worst.text_ns / 1000, s->worst.flush_ns / 1000,
+        s->worst.pixels, s->worst.glyphs);
+#else
+    fprintf(fp, "[FB_STATS] disabled (build with -DFB_STATS)\n");
+#endif
+    if (_fb_copy_kern)
+        fprintf(fp, "[FB_STATS] probe: fill = %s (%u MB/s), copy = %s (%u MB/s)\n",
+            _fb_fill_kern, _fb_fill_mbs, _fb_copy_kern, _fb_copy_mbs);
+    fflush (fp);
+}
+
+//-----------------------------------------------------------------------------
+/*
+    signal 로 요청된 dump 를 출력. frame 이 없는 idle 상태에서는 main loop 에서 호출.
+*/
+void fb_stats_poll (void)
+{
+    if (_fb_stats_req) {
+        _fb_stats_req = 0;
+        fb_stats_dump (stderr);
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*
+    signo 를 받으면 stderr 로 통계를 출력하도록 등록. (ex SIGUSR1)
+*/
+int fb_stats_signal (int signo)
+{
+    struct sigaction sa;
+
+    memset (&sa, 0x00, sizeof(sa));
+    sa.sa_handler = _fb_stats_sig;
+    sigemptyset (&sa.sa_mask);
+    /* epoll_wait 등이 EINTR 로 돌아와 main loop 에서 fb_stats_poll 을 호출할 수 있도록 */
+    sa.sa_flags = 0;
+    if (sigaction (signo, &sa, NULL) < 0) {
+        err("sigaction error!\n");
+        return -1;
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,60 @@
+//-----------------------------------------------------------------------------
+//
+// runtime counters / per-frame timing (FB_STATS 를 정의하지 않으면 제외)
+//
+//-----------------------------------------------------------------------------
+#ifndef __FB_STATS_H__
+#define __FB_STATS_H__
+
+//-----------------------------------------------------------------------------
+typedef struct fb_frame_stat__t {
+    unsigned long   pixels, spans, glyphs;
+    /* draw_fill_rect/draw_rect/draw_line, draw_text, 합성 + present hook */
+    unsigned long   fill_ns, text_ns, flush_ns;
+}   fb_frame_stat_t;
+
+typedef struct fb_stats__t {
+    /* 누적값 (마지막 fb_present 까지) */
+    unsigned long   frames, pixels, spans, glyphs;
+    unsigned long   fill_ns, text_ns, flush_ns;
+    /* 마지막 frame, 가장 오래 걸린 frame */
+    fb_frame_stat_t last, worst;
+    /* fb_probe 로 측정한 장치 memory 쓰기 속도 (MB/s) 및 선택된 kernel (측정하지 않으면 0) */
+    unsigned int    fill_mbs, copy_mbs;
+    const char      *fill_kern, *copy_kern;
+}   fb_stats_t;
+
+//-----------------------------------------------------------------------------
+#if defined(FB_STATS)
+    /* 현재 frame 의 값은 draw 하는 thread 별로 기록 (fb_tile worker 는 fb_stats_take/add 로 합침) */
+    extern FB_TLS fb_frame_stat_t  _fb_frame;
+
+    /* 중첩된 구간(draw_text_diff 안의 fill 등)은 바깥 구간에만 포함 */
+    #define FB_STAT_ADD(f, n)       (_fb_frame.f += (n))
+    #define FB_STAT_BEGIN(t)        unsigned long t = _fb_stat_begin ()
+    #define FB_STAT_END(f, t)       _fb_stat_end (&_fb_frame.f, t)
+
+    extern unsigned long    _fb_stat_begin  (void);
+    extern void             _fb_stat_end    (unsigned long *f, unsigned long t);
+#else
+    #define FB_STAT_ADD(f, n)       do {} while (0)
+    #define FB_STAT_BEGIN(t)        do {} while (0)
+    #define FB_STAT_END(f, t)       do {} while (0)
+#endif
+
+//-----------------------------------------------------------------------------
+extern int          fb_stats_get    (fb_stats_t *s);
+extern void         fb_stats_reset  (void);
+extern void         fb_stats_frame  (void);
+extern void         fb_stats_take   (fb_frame_stat_t *f);
+extern void         fb_stats_add    (const fb_frame_stat_t *f);
+extern void         fb_stats_probe  (unsigned int fill_mbs, const char *fill_kern,
+                                    unsigned int copy_mbs, const char *copy_kern);
+extern void         fb_stats_dump   (FILE *fp);
+extern void         fb_stats_poll   (void);
+extern int          fb_stats_signal (int signo);
+
+//-----------------------------------------------------------------------------
+#endif  // #define __FB_STATS_H__
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
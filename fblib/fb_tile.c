@@ -0,0 +1,268 @@
+//-----------------------------------------------------------------------------
+//
+// tile 단위 병렬 rasterize (고정 thread pool, work stealing)
+//
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fblib.h"
+#include "fb_stats.h"
+#include "fb_tile.h"
+
+//-----------------------------------------------------------------------------
+// Function prototype define.
+//-----------------------------------------------------------------------------
+static int          _tile_pop       (fb_tile_worker_t *w);
+static int          _tile_steal     (fb_tile_t *t, fb_tile_worker_t *w);
+static void         _tile_work      (fb_tile_t *t, fb_tile_worker_t *w);
+static void         *_tile_thread   (void *arg);
+void                fb_tile_rect    (fb_tile_t *t, int tile, fb_rect_t *r);
+void                fb_tile_view    (fb_info_t *view, fb_info_t *fb);
+void                fb_tile_merge   (fb_info_t *fb, fb_info_t *view);
+int                 fb_tile_run     (fb_tile_t *t, fb_tile_f func, void *arg);
+void                fb_tile_close   (fb_tile_t *t);
+fb_tile_t           *fb_tile_init   (int w, int h, int threads);
+
+//-----------------------------------------------------------------------------
+#define RANGE(s, e)     (((unsigned long long)(s) << 32) | (unsigned int)(e))
+#define RANGE_S(v)      ((int)((v) >> 32))
+#define RANGE_E(v)      ((int)((v) & 0xFFFFFFFF))
+
+//-----------------------------------------------------------------------------
+static int _tile_pop (fb_tile_worker_t *w)
+{
+    /* 자신의 범위 앞에서 1개 */
+    unsigned long long v = atomic_load (&w->range);
+
+    do {
+        if (RANGE_S(v) >= RANGE_E(v))
+            return -1;
+    } while (!atomic_compare_exchange_weak (&w->range, &v, RANGE(RANGE_S(v) + 1, RANGE_E(v))));
+    return RANGE_S(v);
+}
+
+//-----------------------------------------------------------------------------
+/*
+    가장 많이 남은 worker 의 범위 뒤쪽 절반을 가져와 자신의 범위로 사용.
+    return : 바로 그릴 tile, -1 = 남은 tile 없음
+*/
+static int _tile_steal (fb_tile_t *t, fb_tile_worker_t *w)
+{
+    unsigned long long v;
+    fb_tile_worker_t *victim;
+    int i, s, e, n, max;
+
+    while (1) {
+        for (i = 0, max = 0, victim = NULL; i < t->threads; i++) {
+            v = atomic_load (&t->worker[i].range);
+            if ((n = RANGE_E(v) - RANGE_S(v)) > max) {
+                max = n;    victim = &t->worker[i];
+            }
+        }
+        if (victim == NULL)
+            return -1;
+
+        v = atomic_load (&victim->range);
+        s = RANGE_S(v);     e = RANGE_E(v);
+        if (s >= e)
+            continue;
+        n = (e - s + 1) / 2;
+        if (!atomic_compare_exchange_strong (&victim->range, &v, RANGE(s, e - n)))
+            continue;
+
+        /* 자신의 범위는 비어있으므로 다른 worker 가 가져간 것은 없음 */
+        atomic_store (&w->range, RANGE(e - n + 1, e));
+        w->steals++;
+        return e - n;
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void _tile_work (fb_tile_t *t, fb_tile_worker_t *w)
+{
+    int id = w - t->worker, tile;
+    fb_rect_t r;
+
+    while (((tile = _tile_pop (w)) >= 0) || ((tile = _tile_steal (t, w)) >= 0)) {
+        fb_tile_rect (t, tile, &r);
+        t->func (t, id, tile, &r, t->arg);
+        w->tiles++;
+    }
+    /* 호출한 thread(0) 는 자신의 frame 통계에 바로 기록됨 */
+    if (id)
+        fb_stats_take (&w->stat);
+}
+
+//-----------------------------------------------------------------------------
+static void *_tile_thread (void *arg)
+{
+    fb_tile_worker_t *w = (fb_tile_worker_t *)arg;
+    fb_tile_t *t = w->t;
+    unsigned long gen = 0;
+
+    pthread_mutex_lock (&t->mutex);
+    while (1) {
+        while (!t->quit && (t->gen == gen))
+            pthread_cond_wait (&t->start, &t->mutex);
+        if (t->quit)
+            break;
+        gen = t->gen;
+        pthread_mutex_unlock (&t->mutex);
+
+        _tile_work (t, w);
+
+        pthread_mutex_lock (&t->mutex);
+        if (--t->busy == 0)
+            pthread_cond_signal (&t->done);
+    }
+    pthread_mutex_unlock (&t->mutex);
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+void fb_tile_rect (fb_tile_t *t, int tile, fb_rect_t *r)
+{
+    r->x = (tile % t->cols) * t->tile_w;
+    r->y = (tile / t->cols) * t->tile_h;
+    r->w = (r->x + t->tile_w > t->w) ? t->w - r->x : t->tile_w;
+    r->h = (r->y + t->tile_h > t->h) ? t->h - r->y : t->tile_h;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    fb 와 같은 memory 에 그리는 worker 용 fb. damage 는 view 에 따로 기록되며
+    (fb_tile_merge 로 합침) present hook, DRM 등은 복사하지 않음. clip 은 tile 마다 설정.
+*/
+void fb_tile_view (fb_info_t *view, fb_info_t *fb)
+{
+    memcpy (view, fb, sizeof(fb_info_t));
+    view->damage_cnt = 0;
+    view->hook_cnt   = 0;
+    view->drm        = NULL;
+    view->flush      = NULL;
+    memset (&view->clip, 0x00, sizeof(fb_rect_t));
+}
+
+//-----------------------------------------------------------------------------
+void fb_tile_merge (fb_info_t *fb, fb_info_t *view)
+{
+    int i;
+
+    for (i = 0; i < view->damage_cnt; i++)
+        fb_damage_add (fb, view->damage[i].x, view->damage[i].y,
+                        view->damage[i].w, view->damage[i].h);
+    view->damage_cnt = 0;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    모든 tile 에 대하여 func 를 호출하고 끝날 때까지 기다림 (호출한 thread 도 같이 그림).
+    처음에는 tile 을 thread 수로 나누어 연속된 범위로 할당하고, 먼저 끝난 thread 는
+    다른 thread 의 남은 범위를 가져감. worker 의 draw 통계는 호출한 thread 의 frame 에 더함.
+    return : 그린 tile 수
+*/
+int fb_tile_run (fb_tile_t *t, fb_tile_f func, void *arg)
+{
+    int i, n = t->threads;
+
+    t->func = func;
+    t->arg  = arg;
+    for (i = 0; i < n; i++)
+        atomic_store (&t->worker[i].range,
+                        RANGE((long)t->cnt * i / n, (long)t->cnt * (i + 1) / n));
+
+    pthread_mutex_lock (&t->mutex);
+    t->busy = n - 1;
+    t->gen++;
+    pthread_cond_broadcast (&t->start);
+    pthread_mutex_unlock (&t->mutex);
+
+    _tile_work (t, &t->worker[0]);
+
+    pthread_mutex_lock (&t->mutex);
+    while (t->busy)
+        pthread_cond_wait (&t->done, &t->mutex);
+    pthread_mutex_unlock (&t->mutex);
+
+    for (i = 1; i < n; i++)
+        fb_stats_add (&t->worker[i].stat);
+    return t->cnt;
+}
+
+//-----------------------------------------------------------------------------
+void fb_tile_close (fb_tile_t *t)
+{
+    int i;
+
+    if (t == NULL)
+        return;
+
+    pthread_mutex_lock (&t->mutex);
+    t->quit = true;
+    pthread_cond_broadcast (&t->start);
+    pthread_mutex_unlock (&t->mutex);
+
+    for (i = 1; i < t->threads; i++)
+        pthread_join (t->worker[i].tid, NULL);
+
+    pthread_cond_destroy (&t->start);
+    pthread_cond_destroy (&t->done);
+    pthread_mutex_destroy (&t->mutex);
+    free (t);
+}
+
+//-----------------------------------------------------------------------------
+/*
+    w x h 화면을 FB_TILE_SIZE tile 로 나누고 threads - 1 개의 worker thread 를 생성.
+    threads <= 0 이면 online CPU 수.
+*/
+fb_tile_t *fb_tile_init (int w, int h, int threads)
+{
+    fb_tile_t *t;
+    int i;
+
+    if ((w <= 0) || (h <= 0)) {
+        err("invalid tile area!(w = %d, h = %d)\n", w, h);
+        return NULL;
+    }
+    if (threads <= 0)
+        threads = (int)sysconf (_SC_NPROCESSORS_ONLN);
+    if (threads < 1)
+        threads = 1;
+    if (threads > FB_TILE_THREAD_MAX)
+        threads = FB_TILE_THREAD_MAX;
+
+    if ((t = (fb_tile_t *)malloc (sizeof(fb_tile_t))) == NULL) {
+        err("fb_tile malloc error!\n");
+        return NULL;
+    }
+    memset (t, 0x00, sizeof(fb_tile_t));
+
+    t->w      = w;              t->h      = h;
+    t->tile_w = FB_TILE_SIZE;   t->tile_h = FB_TILE_SIZE;
+    t->cols   = (w + t->tile_w - 1) / t->tile_w;
+    t->rows   = (h + t->tile_h - 1) / t->tile_h;
+    t->cnt    = t->cols * t->rows;
+
+    pthread_mutex_init (&t->mutex, NULL);
+    pthread_cond_init  (&t->start, NULL);
+    pthread_cond_init  (&t->done,  NULL);
+
+    t->threads = 1;
+    t->worker[0].t = t;
+    for (i = 1; i < threads; i++) {
+        t->worker[i].t = t;
+        if (pthread_create (&t->worker[i].tid, NULL, _tile_thread, &t->worker[i])) {
+            err("pthread_create error! (threads = %d)\n", i);
+            break;
+        }
+        t->threads++;
+    }
+    return t;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,71 @@
+//-----------------------------------------------------------------------------
+//
+// tile 단위 병렬 rasterize (고정 thread pool, work stealing)
+//
+//-----------------------------------------------------------------------------
+#ifndef __FB_TILE_H__
+#define __FB_TILE_H__
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "fb_stats.h"
+
+//-----------------------------------------------------------------------------
+/* 호출한 thread 를 포함한 최대 thread 수 */
+#define FB_TILE_THREAD_MAX  16
+
+/* tile 크기 (pixel), 32bpp 에서 1 tile 이 L2 cache 에 들어가는 크기 */
+#define FB_TILE_SIZE        128
+
+//-----------------------------------------------------------------------------
+struct fb_tile__t;
+
+/*
+    tile 1개를 그림. worker = 0 ~ threads - 1 (0 = fb_tile_run 을 호출한 thread).
+    다른 thread 와 같은 pixel 을 쓰지 않도록 r 영역 안에만 그려야 함. (fb_tile_view 사용)
+*/
+typedef void (*fb_tile_f) (struct fb_tile__t *t, int worker, int tile, fb_rect_t *r, void *arg);
+
+typedef struct fb_tile_worker__t {
+    struct fb_tile__t   *t;
+    pthread_t           tid;
+    /*
+        아직 그리지 않은 tile 범위 (상위 32bit = 시작, 하위 32bit = 끝).
+        자신은 앞에서 1개씩, 일이 없는 worker 는 뒤에서 절반을 가져감 (CAS)
+    */
+    _Atomic unsigned long long  range;
+    /* 이번 run 에서 그린 draw 통계 */
+    fb_frame_stat_t     stat;
+    unsigned long       tiles, steals;
+}   fb_tile_worker_t;
+
+typedef struct fb_tile__t {
+    /* 화면 크기, tile 크기 및 개수 */
+    int                 w, h, tile_w, tile_h, cols, rows, cnt;
+    int                 threads;
+
+    pthread_mutex_t     mutex;
+    pthread_cond_t      start, done;
+    /* run 번호 (변경되면 worker 시작), 작업중인 worker 수 (호출한 thread 제외) */
+    unsigned long       gen;
+    int                 busy;
+    bool                quit;
+
+    fb_tile_f           func;
+    void                *arg;
+    fb_tile_worker_t    worker[FB_TILE_THREAD_MAX];
+}   fb_tile_t;
+
+//-----------------------------------------------------------------------------
+extern void         fb_tile_rect    (fb_tile_t *t, int tile, fb_rect_t *r);
+extern void         fb_tile_view    (fb_info_t *view, fb_info_t *fb);
+extern void         fb_tile_merge   (fb_info_t *fb, fb_info_t *view);
+extern int          fb_tile_run     (fb_tile_t *t, fb_tile_f func, void *arg);
+extern void         fb_tile_close   (fb_tile_t *t);
+extern fb_tile_t    *fb_tile_init   (int w, int h, int threads);
+
+//-----------------------------------------------------------------------------
+#endif  // #define __FB_TILE_H__
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -3,6 +3,7 @@
 // 2022.03.23 framebuffer graphic library(chalres-park)
 //
 //-----------------------------------------------------------------------------
+#define _GNU_SOURCE     /* memfd_create */
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdlib.h>
@@ -27,57 +28,83 @@
 #include "FontHanboot.h"
 #include "FontHangodic.h"
 #include "FontHanpil.h"
-#include "FontHangodic.h"
 #include "FontAscii_8x16.h"
 
 #include "fblib.h"
+#include "fb_stats.h"
+#include "fb_drm.h"
+#include "fb_flush.h"
+#include "fb_probe.h"
 
 //-----------------------------------------------------------------------------
 // Function prototype define.
 //-----------------------------------------------------------------------------
 static void make_image  (unsigned char is_first,
                         unsigned char *dest,
-                        unsigned char *src);
+                        const unsigned char *src);
 static unsigned char *get_hangul_image( unsigned char HAN1,
                                         unsigned char HAN2,
                                         unsigned char HAN3);
 static void draw_hangul_bitmap (fb_info_t *fb,
-                    int x, int y, unsigned char *p_img,
+                    int x, int y, const unsigned char *p_img,
                     int f_color, int b_color, int scale);
 static void draw_ascii_bitmap (fb_info_t *fb,
-                    int x, int y, unsigned char *p_img,
+                    int x, int y, const unsigned char *p_img,
                     int f_color, int b_color, int scale);
-static void _draw_text (fb_info_t *fb, int x, int y, char *p_str,
+static int  _draw_text (fb_info_t *fb, int x, int y, char *p_str,
+                        int f_color, int b_color, int scale);
+static void _fill32 (unsigned int *p, unsigned int v, int n);
+static void _fill16 (unsigned short *p, unsigned short v, int n);
+static void _draw_span (fb_info_t *fb, int x, int y, int w, int color);
+int          fb_clip (fb_info_t *fb, int *x, int *y, int *w, int *h);
+static int  _glyph_len (char *p_str);
+static void _draw_glyph (fb_info_t *fb, int x, int y, char *p_str,
                         int f_color, int b_color, int scale);
 void         put_pixel (fb_info_t *fb, int x, int y, int color);
 void         draw_text (fb_info_t *fb, int x, int y,
                      int f_color, int b_color, int scale, char *fmt, ...);
+int          draw_text_diff (fb_info_t *fb, int x, int y,
+                     int f_color, int b_color, int scale, char *o_str, char *n_str);
 void         draw_line (fb_info_t *fb, int x, int y, int w, int color);
 void         draw_rect (fb_info_t *fb, int x, int y, int w, int h, int lw, int color);
 void         draw_fill_rect (fb_info_t *fb, int x, int y, int w, int h, int color);
+void         fb_shift_area (fb_info_t *fb, int x, int y, int w, int h, int dx);
+void         fb_scroll_area (fb_info_t *fb, int x, int y, int w, int h, int dy);
 void         set_font(enum eFONTS_HANGUL s_font);
+static void  _fb_rect_union (fb_rect_t *d, fb_rect_t *s);
+void         fb_rect_merge (fb_rect_t *list, int *cnt, int max, fb_rect_t *r);
+void         fb_damage_add (fb_info_t *fb, int x, int y, int w, int h);
+void         fb_damage_clear (fb_info_t *fb);
+int          fb_hook_add (fb_info_t *fb, fb_hook_f func, void *arg);
+void         fb_hook_del (fb_info_t *fb, fb_hook_f func, void *arg);
+int          fb_present (fb_info_t *fb);
 void         fb_clear (fb_info_t *fb);
 void         fb_close (fb_info_t *fb);
+static int   _fb_mode (fb_info_t *fb, bool check);
+int          fb_update_mode (fb_info_t *fb);
+static int   _fb_mem (fb_info_t *fb, const char *spec);
 fb_info_t    *fb_init (const char *DEVICE_NAME);
+fb_info_t    *fb_surface_init (int w, int h, int bpp, bool is_bgr);
 
 //-----------------------------------------------------------------------------
 // hangul image base 16x16
 //-----------------------------------------------------------------------------
-static unsigned char HANFontImage[32] = {0,};
+static FB_TLS unsigned char HANFontImage[32] = {0,};
 
-const char D_ML[22] = { 0, 0, 2, 0, 2, 1, 2, 1, 2, 3, 0, 2, 1, 3, 3, 1, 2, 1, 3, 3, 1, 1 																	};
-const char D_FM[40] = { 1, 3, 0, 2, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 0, 2, 1, 3, 1, 3, 1, 3 			};
-const char D_MF[44] = { 0, 0, 0, 5, 0, 5, 0, 5, 0, 5, 0, 5, 0, 5, 0, 5, 0, 5, 1, 6, 3, 7, 3, 7, 3, 7, 1, 6, 2, 6, 4, 7, 4, 7, 4, 7, 2, 6, 1, 6, 3, 7, 0, 5 };
+/* 초성/중성/종성 조합에 따른 글꼴 벌 선택 (font table 과 같이 .rodata) */
+static const unsigned char D_ML[22] = { 0, 0, 2, 0, 2, 1, 2, 1, 2, 3, 0, 2, 1, 3, 3, 1, 2, 1, 3, 3, 1, 1 																	};
+static const unsigned char D_FM[40] = { 1, 3, 0, 2, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 0, 2, 1, 3, 1, 3, 1, 3 			};
+static const unsigned char D_MF[44] = { 0, 0, 0, 5, 0, 5, 0, 5, 0, 5, 0, 5, 0, 5, 0, 5, 0, 5, 1, 6, 3, 7, 3, 7, 3, 7, 1, 6, 2, 6, 4, 7, 4, 7, 4, 7, 2, 6, 1, 6, 3, 7, 0, 5 };
 
-static unsigned char *HANFONT1 = (unsigned char *)FONT_HANGUL1;
-static unsigned char *HANFONT2 = (unsigned char *)FONT_HANGUL2;
-static unsigned char *HANFONT3 = (unsigned char *)FONT_HANGUL3;
+static FB_TLS const unsigned char *HANFONT1 = FONT_HANGUL1;
+static FB_TLS const unsigned char *HANFONT2 = FONT_HANGUL2;
+static FB_TLS const unsigned char *HANFONT3 = FONT_HANGUL3;
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 static void make_image  (unsigned char is_first,
                         unsigned char *dest,
-                        unsigned char *src)
+                        const unsigned char *src)
 {
     int i;
     if (is_first)   for (i = 0; i < 32; i++)    dest[i]  = src[i];
@@ -129,8 +156,18 @@ void put_pixel (fb_info_t *fb, int x, int y, int color)
     fb_color_u c;
     int offset = (y * fb->stride) + (x * (fb->bpp >> 3));
 
-    if ((x < fb->w) && (y < fb->h)) {
+    /* tile 영역 밖은 다른 thread 가 그림 */
+    if (fb->clip.w && ((x < fb->clip.x) || (y < fb->clip.y) ||
+        (x >= fb->clip.x + fb->clip.w) || (y >= fb->clip.y + fb->clip.h)))
+        return;
+
+    if ((x >= 0) && (y >= 0) && (x < fb->w) && (y < fb->h)) {
         c.uint = color;
+        FB_STAT_ADD(pixels, 1);
+        if (fb->bpp == 16) {
+            *(unsigned short *)(fb->data + offset) = UINT_TO_565(color, fb->is_bgr);
+            return;
+        }
         if (fb->is_bgr) {
             *(fb->data + offset) = c.bits.b;  offset++;
             *(fb->data + offset) = c.bits.g;  offset++;
@@ -148,9 +185,83 @@ void put_pixel (fb_info_t *fb, int x, int y, int color)
     }
 }
 
+//-----------------------------------------------------------------------------
+FB_CLONES static void _fill32 (unsigned int *p, unsigned int v, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        p[i] = v;
+}
+
+//-----------------------------------------------------------------------------
+FB_CLONES static void _fill16 (unsigned short *p, unsigned short v, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        p[i] = v;
+}
+
+//-----------------------------------------------------------------------------
+static void _draw_span (fb_info_t *fb, int x, int y, int w, int color)
+{
+    /* 가로 1 line 을 화면(clip) 범위로 잘라서 채움 (damage 는 호출하는 쪽에서 기록) */
+    fb_color_u c;
+    unsigned char px[4];
+    char *p;
+    int i, h = 1;
+
+    if (!fb_clip (fb, &x, &y, &w, &h))
+        return;
+
+    FB_STAT_ADD(spans, 1);
+    FB_STAT_ADD(pixels, w);
+    c.uint = color;
+    px[0] = fb->is_bgr ? c.bits.b : c.bits.r;
+    px[1] = c.bits.g;
+    px[2] = fb->is_bgr ? c.bits.r : c.bits.b;
+    px[3] = 0xFF;
+
+    p = fb->data + (y * fb->stride) + (x * (fb->bpp >> 3));
+    if (fb->bpp == 32) {
+        unsigned int v;
+        memcpy (&v, px, sizeof(v));
+        if (fb->fill32)
+            fb->fill32 ((unsigned int *)p, v, w);
+        else
+            _fill32 ((unsigned int *)p, v, w);
+    } else if (fb->bpp == 16) {
+        _fill16 ((unsigned short *)p, UINT_TO_565(color, fb->is_bgr), w);
+    } else {
+        for (i = 0; i < w; i++, p += 3) {
+            p[0] = px[0];   p[1] = px[1];   p[2] = px[2];
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*
+    영역을 화면 범위 및 clip 영역으로 자름. return : 남은 영역이 있으면 1
+*/
+int fb_clip (fb_info_t *fb, int *x, int *y, int *w, int *h)
+{
+    int x0 = 0, y0 = 0, x1 = fb->w, y1 = fb->h;
+
+    if (fb->clip.w) {
+        x0 = fb->clip.x;                y0 = fb->clip.y;
+        x1 = fb->clip.x + fb->clip.w;   y1 = fb->clip.y + fb->clip.h;
+    }
+    if (*x < x0)            {   *w -= x0 - *x;  *x = x0;    }
+    if (*y < y0)            {   *h -= y0 - *y;  *y = y0;    }
+    if (*x + *w > x1)           *w = x1 - *x;
+    if (*y + *h > y1)           *h = y1 - *y;
+    return (*w > 0) && (*h > 0);
+}
+
 //-----------------------------------------------------------------------------
 static void draw_hangul_bitmap (fb_info_t *fb,
-                    int x, int y, unsigned char *p_img,
+                    int x, int y, const unsigned char *p_img,
                     int f_color, int b_color, int scale)
 {
     int pos, i, j, mask, x_off, y_off, scale_y, scale_x;
@@ -178,7 +289,7 @@ static void draw_hangul_bitmap (fb_info_t *fb,
 
 //-----------------------------------------------------------------------------
 static void draw_ascii_bitmap (fb_info_t *fb,
-                    int x, int y, unsigned char *p_img,
+                    int x, int y, const unsigned char *p_img,
                     int f_color, int b_color, int scale)
 {
     int pos, mask, x_off, y_off, scale_y, scale_x;
@@ -200,33 +311,56 @@ static void draw_ascii_bitmap (fb_info_t *fb,
 }
 
 //-----------------------------------------------------------------------------
-static void _draw_text (fb_info_t *fb, int x, int y, char *p_str,
-                        int f_color, int b_color, int scale)
+static int _glyph_len (char *p_str)
 {
-    unsigned char *p_img;
-    unsigned char c1, c2, c3;
-
-    while(*p_str) { 
-        c1 = *(unsigned char *)p_str++;
+    /* 한글(UTF-8)은 3바이트, ASCII는 1바이트. 잘린 UTF-8 문자는 0을 반환. */
+    if (*(unsigned char *)p_str >= 0x80)
+        return (p_str[1] && p_str[2]) ? 3 : 0;
+    return 1;
+}
 
-        //---------- 한글 ---------
-        /* 모든 문자는 기본적으로 UTF-8형태로 저장되며 한글은 3바이트를 가진다. */
-        /* 한글은 3바이트를 일어 UTF8 to UTF16으로 변환후 초/중/종성을 분리하여 조합형으로 표시한다. */
-        if (c1 >= 0x80){
-            c2 = *(unsigned char *)p_str++;
-            c3 = *(unsigned char *)p_str++;
+//-----------------------------------------------------------------------------
+static void _draw_glyph (fb_info_t *fb, int x, int y, char *p_str,
+                        int f_color, int b_color, int scale)
+{
+    const unsigned char *p_img;
+    unsigned char *c = (unsigned char *)p_str;
+    int c_x = x, c_y = y, c_w = ((c[0] >= 0x80) ? 16 : 8) * scale, c_h = 16 * scale;
+
+    /* tile 로 나누어 그리는 경우 clip 영역 밖의 glyph 는 pixel 단위로 검사하지 않음 */
+    if (fb->clip.w && !fb_clip (fb, &c_x, &c_y, &c_w, &c_h))
+        return;
+
+    FB_STAT_ADD(glyphs, 1);
+
+    //---------- 한글 ---------
+    /* 모든 문자는 기본적으로 UTF-8형태로 저장되며 한글은 3바이트를 가진다. */
+    /* 한글은 3바이트를 일어 UTF8 to UTF16으로 변환후 초/중/종성을 분리하여 조합형으로 표시한다. */
+    if (c[0] >= 0x80) {
+        p_img = get_hangul_image(c[0], c[1], c[2]);
+        draw_hangul_bitmap(fb, x, y, p_img, f_color, b_color, scale);
+    }
+    //---------- ASCII ---------
+    else {
+        p_img = FONT_ASCII[c[0]];
+        draw_ascii_bitmap(fb, x, y, p_img, f_color, b_color, scale);
+    }
+}
 
-            p_img = get_hangul_image(c1, c2, c3);
-            draw_hangul_bitmap(fb, x, y, p_img, f_color, b_color, scale);
-            x = x + FONT_HANGUL_WIDTH * scale;
-        }
-        //---------- ASCII ---------
-        else {
-            p_img = (unsigned char *)FONT_ASCII[c1];
-            draw_ascii_bitmap(fb, x, y, p_img, f_color, b_color, scale);
-            x = x + FONT_ASCII_WIDTH * scale;
-        }
-    }  
+//-----------------------------------------------------------------------------
+static int _draw_text (fb_info_t *fb, int x, int y, char *p_str,
+                        int f_color, int b_color, int scale)
+{
+    int len;
+
+    while(*p_str) {
+        if ((len = _glyph_len(p_str)) == 0)
+            break;
+        _draw_glyph(fb, x, y, p_str, f_color, b_color, scale);
+        x += ((len == 3) ? FONT_HANGUL_WIDTH : FONT_ASCII_WIDTH) * scale;
+        p_str += len;
+    }
+    return x;
 }
 
 //-----------------------------------------------------------------------------
@@ -235,49 +369,163 @@ void draw_text (fb_info_t *fb, int x, int y,
 {
     char buf[256];
     va_list va;
+    FB_STAT_BEGIN(t);
 
     memset(buf, 0x00, sizeof(buf));
 
     va_start(va, fmt);
-    vsprintf(buf, fmt, va);
+    vsnprintf(buf, sizeof(buf), fmt, va);
     va_end(va);
 
-    _draw_text(fb, x, y, buf, f_color, b_color, scale);
+    fb_damage_add(fb, x, y, _draw_text(fb, x, y, buf, f_color, b_color, scale) - x,
+                    FONT_HEIGHT * scale);
+    FB_STAT_END(text_ns, t);
+}
+
+//-----------------------------------------------------------------------------
+/*
+    이전에 같은 위치(x, y), scale, font, 색상으로 그려진 문자열(o_str)을
+    새로운 문자열(n_str)로 변경한다.
+    같은 x 위치에 같은 glyph가 있는 경우 다시 그리지 않으며,
+    새 문자열이 덮지 못하는 이전 문자열의 뒷부분만 배경색으로 지운다.
+    return : 다시 그린 glyph 개수
+*/
+int draw_text_diff (fb_info_t *fb, int x, int y,
+                    int f_color, int b_color, int scale, char *o_str, char *n_str)
+{
+    int o_x = 0, n_x = 0, o_len = 0, n_len, cnt = 0, d_s = INT_MAX, d_e = 0;
+    FB_STAT_BEGIN(t);
+
+    while (*n_str) {
+        if ((n_len = _glyph_len(n_str)) == 0)
+            break;
+
+        /* 새 glyph 시작 위치보다 앞에 있는 이전 glyph는 건너뜀 */
+        while (*o_str && (o_x < n_x)) {
+            if ((o_len = _glyph_len(o_str)) == 0)
+                break;
+            o_x   += ((o_len == 3) ? FONT_HANGUL_WIDTH : FONT_ASCII_WIDTH) * scale;
+            o_str += o_len;
+        }
+
+        if ((o_x != n_x) || (_glyph_len(o_str) != n_len) ||
+            memcmp(o_str, n_str, n_len)) {
+            _draw_glyph(fb, x + n_x, y, n_str, f_color, b_color, scale);
+            cnt++;
+            d_s = (d_s < n_x) ? d_s : n_x;
+            d_e = n_x + ((n_len == 3) ? FONT_HANGUL_WIDTH : FONT_ASCII_WIDTH) * scale;
+        }
+        n_x   += ((n_len == 3) ? FONT_HANGUL_WIDTH : FONT_ASCII_WIDTH) * scale;
+        n_str += n_len;
+    }
+
+    /* 이전 문자열의 끝 위치 */
+    while (*o_str) {
+        if ((o_len = _glyph_len(o_str)) == 0)
+            break;
+        o_x   += ((o_len == 3) ? FONT_HANGUL_WIDTH : FONT_ASCII_WIDTH) * scale;
+        o_str += o_len;
+    }
+
+    if (o_x > n_x)
+        draw_fill_rect(fb, x + n_x, y, o_x - n_x, FONT_HEIGHT * scale, b_color);
+
+    /* 다시 그린 glyph 영역 */
+    if (d_s != INT_MAX)
+        fb_damage_add(fb, x + d_s, y, d_e - d_s, FONT_HEIGHT * scale);
+
+    FB_STAT_END(text_ns, t);
+    return cnt;
 }
 
 //-----------------------------------------------------------------------------
 void draw_line (fb_info_t *fb, int x, int y, int w, int color)
 {
-    int dx;
+    FB_STAT_BEGIN(t);
 
-    for (dx = 0; dx < w; dx++)
-        put_pixel(fb, x + dx, y, color);
+    _draw_span(fb, x, y, w, color);
+    fb_damage_add(fb, x, y, w, 1);
+    FB_STAT_END(fill_ns, t);
 }
 
 //-----------------------------------------------------------------------------
 void draw_rect (fb_info_t *fb, int x, int y, int w, int h, int lw, int color)
 {
 	int dy, i;
+    FB_STAT_BEGIN(t);
 
 	for (dy = 0; dy < h; dy++) {
         if (dy < lw || (dy > (h - lw -1)))
-            draw_line (fb, x, y + dy, w, color);
+            _draw_span (fb, x, y + dy, w, color);
         else {
-            for (i = 0; i < lw; i++) {
-                put_pixel (fb, x + 0    +i, y + dy, color);
-                put_pixel (fb, x + w -1 -i, y + dy, color);
-            }
+            i = (lw < w) ? lw : w;
+            _draw_span (fb, x,         y + dy, i, color);
+            _draw_span (fb, x + w - i, y + dy, i, color);
         }
 	}
+    fb_damage_add(fb, x, y, w, h);
+    FB_STAT_END(fill_ns, t);
 }
 
 //-----------------------------------------------------------------------------
 void draw_fill_rect (fb_info_t *fb, int x, int y, int w, int h, int color)
 {
 	int dy;
+    FB_STAT_BEGIN(t);
 
 	for (dy = 0; dy < h; dy++)
-        draw_line(fb, x, y + dy, w, color);
+        _draw_span(fb, x, y + dy, w, color);
+    fb_damage_add(fb, x, y, w, h);
+    FB_STAT_END(fill_ns, t);
+}
+
+//-----------------------------------------------------------------------------
+/*
+    (x, y, w, h) 영역의 내용을 가로로 dx pixel 이동한다. (dx < 0 : 왼쪽으로 이동)
+    이동후 비워지는 |dx| 폭의 영역은 이전 내용이 남아있으므로 호출하는 쪽에서 다시 그린다.
+*/
+void fb_shift_area (fb_info_t *fb, int x, int y, int w, int h, int dx)
+{
+    int dy, bpp = fb->bpp >> 3, len;
+    char *p;
+
+    if (!fb_clip (fb, &x, &y, &w, &h))
+        return;
+
+    if ((len = w - abs(dx)) > 0) {
+        p = fb->data + y * fb->stride + x * bpp;
+        for (dy = 0; dy < h; dy++, p += fb->stride) {
+            if (dx < 0)     memmove (p, p - dx * bpp, len * bpp);
+            else            memmove (p + dx * bpp, p, len * bpp);
+        }
+    }
+    fb_damage_add(fb, x, y, w, h);
+}
+
+//-----------------------------------------------------------------------------
+/*
+    영역을 dy 만큼 세로로 이동 (dy < 0 이면 위로). 비워진 row 는 호출한 쪽에서 다시 그림.
+*/
+void fb_scroll_area (fb_info_t *fb, int x, int y, int w, int h, int dy)
+{
+    int i, bpp = fb->bpp >> 3, cnt;
+    char *p;
+
+    if (!fb_clip (fb, &x, &y, &w, &h))
+        return;
+
+    if ((cnt = h - abs(dy)) > 0) {
+        p = fb->data + y * fb->stride + x * bpp;
+        /* 겹치는 영역을 덮어쓰지 않도록 위로 이동은 위에서부터, 아래로 이동은 아래에서부터 */
+        if (dy < 0) {
+            for (i = 0; i < cnt; i++)
+                memmove (p + i * fb->stride, p + (i - dy) * fb->stride, w * bpp);
+        } else {
+            for (i = cnt - 1; i >= 0; i--)
+                memmove (p + (i + dy) * fb->stride, p + i * fb->stride, w * bpp);
+        }
+    }
+    fb_damage_add(fb, x, y, w, h);
 }
 
 //-----------------------------------------------------------------------------
@@ -286,56 +534,302 @@ void set_font(enum eFONTS_HANGUL s_font)
     switch(s_font)
     {
         case    eFONT_HANBOOT:
-            HANFONT1 = (unsigned char *)FONT_HANBOOT1;
-            HANFONT2 = (unsigned char *)FONT_HANBOOT2;
-            HANFONT3 = (unsigned char *)FONT_HANBOOT3;
+            HANFONT1 = FONT_HANBOOT1;
+            HANFONT2 = FONT_HANBOOT2;
+            HANFONT3 = FONT_HANBOOT3;
         break;
         case    eFONT_HANGODIC:
-            HANFONT1 = (unsigned char *)FONT_HANGODIC1;
-            HANFONT2 = (unsigned char *)FONT_HANGODIC2;
-            HANFONT3 = (unsigned char *)FONT_HANGODIC3;
+            HANFONT1 = FONT_HANGODIC1;
+            HANFONT2 = FONT_HANGODIC2;
+            HANFONT3 = FONT_HANGODIC3;
         break;
         case    eFONT_HANPIL:
-            HANFONT1 = (unsigned char *)FONT_HANPIL1;
-            HANFONT2 = (unsigned char *)FONT_HANPIL2;
-            HANFONT3 = (unsigned char *)FONT_HANPIL3;
+            HANFONT1 = (const unsigned char *)FONT_HANPIL1;
+            HANFONT2 = (const unsigned char *)FONT_HANPIL2;
+            HANFONT3 = (const unsigned char *)FONT_HANPIL3;
         break;
         case    eFONT_HANSOFT:
-            HANFONT1 = (unsigned char *)FONT_HANSOFT1;
-            HANFONT2 = (unsigned char *)FONT_HANSOFT2;
-            HANFONT3 = (unsigned char *)FONT_HANSOFT3;
+            HANFONT1 = (const unsigned char *)FONT_HANSOFT1;
+            HANFONT2 = (const unsigned char *)FONT_HANSOFT2;
+            HANFONT3 = (const unsigned char *)FONT_HANSOFT3;
         break;
         case    eFONT_HAN_DEFAULT:
         default :
-            HANFONT1 = (unsigned char *)FONT_HANGUL1;
-            HANFONT2 = (unsigned char *)FONT_HANGUL2;
-            HANFONT3 = (unsigned char *)FONT_HANGUL3;
+            HANFONT1 = FONT_HANGUL1;
+            HANFONT2 = FONT_HANGUL2;
+            HANFONT3 = FONT_HANGUL3;
         break;
     }
 }
 
+//-----------------------------------------------------------------------------
+static void _fb_rect_union (fb_rect_t *d, fb_rect_t *s)
+{
+    int x2 = (d->x + d->w > s->x + s->w) ? d->x + d->w : s->x + s->w;
+    int y2 = (d->y + d->h > s->y + s->h) ? d->y + d->h : s->y + s->h;
+
+    d->x = (d->x < s->x) ? d->x : s->x;
+    d->y = (d->y < s->y) ? d->y : s->y;
+    d->w = x2 - d->x;
+    d->h = y2 - d->y;
+}
+
+//-----------------------------------------------------------------------------
+void fb_rect_merge (fb_rect_t *list, int *cnt, int max, fb_rect_t *r)
+{
+    fb_rect_t *d;
+    int i, best = 0;
+    long area, min = LONG_MAX;
+
+    /* 겹치거나 맞닿은 영역이 있으면 합침 */
+    for (i = 0, d = list; i < *cnt; i++, d++) {
+        if ((r->x <= d->x + d->w) && (d->x <= r->x + r->w) &&
+            (r->y <= d->y + d->h) && (d->y <= r->y + r->h)) {
+            _fb_rect_union (d, r);
+            return;
+        }
+    }
+    if (*cnt < max) {
+        list[(*cnt)++] = *r;
+        return;
+    }
+
+    /* 목록이 가득찬 경우 합쳤을 때 면적이 가장 작게 늘어나는 영역과 합침 */
+    for (i = 0, d = list; i < *cnt; i++, d++) {
+        fb_rect_t u = *d;
+        _fb_rect_union (&u, r);
+        area = (long)u.w * u.h - (long)d->w * d->h;
+        if (area < min) {
+            min = area;     best = i;
+        }
+    }
+    _fb_rect_union (&list[best], r);
+}
+
+//-----------------------------------------------------------------------------
+void fb_damage_add (fb_info_t *fb, int x, int y, int w, int h)
+{
+    fb_rect_t r;
+
+    /* 화면 범위로 자름 */
+    if (x < 0)              {   w += x;     x = 0;  }
+    if (y < 0)              {   h += y;     y = 0;  }
+    if (x + w > fb->w)          w = fb->w - x;
+    if (y + h > fb->h)          h = fb->h - y;
+    if ((w <= 0) || (h <= 0))
+        return;
+
+    r.x = x;    r.y = y;    r.w = w;    r.h = h;
+    fb_rect_merge (fb->damage, &fb->damage_cnt, FB_DAMAGE_MAX, &r);
+}
+
+//-----------------------------------------------------------------------------
+void fb_damage_clear (fb_info_t *fb)
+{
+    fb->damage_cnt = 0;
+}
+
+//-----------------------------------------------------------------------------
+int fb_hook_add (fb_info_t *fb, fb_hook_f func, void *arg)
+{
+    if (fb->hook_cnt >= FB_HOOK_MAX) {
+        err("too many present hooks!\n");
+        return -1;
+    }
+    fb->hook[fb->hook_cnt].func = func;
+    fb->hook[fb->hook_cnt].arg  = arg;
+    fb->hook_cnt++;
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+void fb_hook_del (fb_info_t *fb, fb_hook_f func, void *arg)
+{
+    int i;
+
+    for (i = 0; i < fb->hook_cnt; i++) {
+        if ((fb->hook[i].func == func) && (fb->hook[i].arg == arg)) {
+            memmove (&fb->hook[i], &fb->hook[i + 1], sizeof(fb_hook_t) * (fb->hook_cnt - i - 1));
+            fb->hook_cnt--;
+            return;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*
+    화면 반영 시점. 이번 frame 의 damage 목록을 hook 에 전달한 후 초기화한다.
+    변경이 없으면 hook 을 호출하지 않음. return : 전달한 damage 개수
+*/
+int fb_present (fb_info_t *fb)
+{
+    int i, cnt = fb->damage_cnt;
+
+    if (!cnt) {
+        fb_stats_poll ();
+        return 0;
+    }
+    FB_STAT_BEGIN(t);
+    for (i = 0; i < fb->hook_cnt; i++)
+        fb->hook[i].func (fb, fb->hook[i].arg);
+    FB_STAT_END(flush_ns, t);
+
+    /* DRM 은 vblank 에서 back buffer 를 표시 (flip 완료까지 대기) */
+    if (fb->drm)
+        fb_drm_flip (fb);
+    /* shadow buffer 의 damage 를 queue 에 넣고 바로 return (장치 복사는 flush thread) */
+    if (fb->flush)
+        fb_flush_queue (fb);
+
+    fb_damage_clear (fb);
+    /* 이번 frame 의 통계를 누적 (FB_STATS) */
+    fb_stats_frame ();
+    return cnt;
+}
+
 //-----------------------------------------------------------------------------
 void fb_clear (fb_info_t *fb)
 {
-    memset(fb->data, 0x00, (fb->w * fb->h * fb->bpp) / 8);
+    FB_STAT_BEGIN(t);
+
+    memset(fb->data, 0x00, fb->stride * fb->h);
+    FB_STAT_ADD(pixels, fb->w * fb->h);
+    fb_damage_add(fb, 0, 0, fb->w, fb->h);
+    FB_STAT_END(fill_ns, t);
 }
 
 //-----------------------------------------------------------------------------
 void fb_close (fb_info_t *fb)
 {
     if (fb) {
-        if (fb->fd)
+        if (fb->flush)
+            fb_flush_close (fb);
+        if (fb->drm)
+            fb_drm_close (fb);
+        if (fb->base)
+            munmap (fb->base, fb->size);
+        if (fb->fd > 0)
             close (fb->fd);
         free (fb);
     }
 }
 
+//-----------------------------------------------------------------------------
+/*
+    FBIOGET_VSCREENINFO / FBIOGET_FSCREENINFO 로 화면 모드를 읽어 fb 정보를 설정한다.
+    check = true 인 경우 현재 모드와 같으면 아무것도 하지 않음.
+    return : 1 = 모드 변경(다시 mmap 함), 0 = 변경 없음, -1 = error
+*/
+static int _fb_mode (fb_info_t *fb, bool check)
+{
+    struct fb_var_screeninfo fvsi;
+    struct fb_fix_screeninfo ffsi;
+    char *base;
+
+    if (ioctl(fb->fd, FBIOGET_VSCREENINFO, &fvsi) < 0) {
+        err("ioctl(FBIOGET_VSCREENINFO)");
+        return -1;
+    }
+    if (ioctl(fb->fd, FBIOGET_FSCREENINFO, &ffsi) < 0) {
+        err("ioctl(FBIOGET_FSCREENINFO)");
+        return -1;
+    }
+
+    if (check && (fb->w == (int)fvsi.xres) && (fb->h == (int)fvsi.yres) &&
+        (fb->bpp == (int)fvsi.bits_per_pixel) && (fb->stride == (int)ffsi.line_length) &&
+        (fb->size == (int)ffsi.smem_len))
+        return 0;
+
+    if (fvsi.red.length != 8 || fvsi.green.length != 8 || fvsi.blue.length != 8) {
+        err("mmap");
+        return -1;
+    }
+
+    base = (char *)mmap((caddr_t) NULL, ffsi.smem_len,
+                        PROT_READ | PROT_WRITE, MAP_SHARED, fb->fd, 0);
+
+    if (base == (char *)-1) {
+        err("mmap");
+        return -1;
+    }
+    if (fb->base)
+        munmap (fb->base, fb->size);
+
+    fb->w       = fvsi.xres;
+    fb->h       = fvsi.yres;
+    fb->bpp     = fvsi.bits_per_pixel;
+    fb->stride  = ffsi.line_length;
+    fb->size    = ffsi.smem_len;
+    fb->base    = base;
+    fb->data    = fb->base + ((unsigned long) ffsi.smem_start % (unsigned long) getpagesize());
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    HDMI 재연결 등으로 화면 모드가 변경되었는지 확인하고 변경된 경우 fb 정보를 갱신한다.
+    return : 1 = 모드 변경, 0 = 변경 없음, -1 = error
+*/
+int fb_update_mode (fb_info_t *fb)
+{
+    int ret;
+
+    /* 메모리 장치는 모드가 변경되지 않음, DRM 은 시작할 때의 mode 를 계속 사용 */
+    if (fb->is_mem || fb->drm)
+        return 0;
+    if (!fb->flush)
+        return _fb_mode (fb, true);
+
+    /* flush thread 가 이전 장치 memory 에 복사를 끝낸 후 다시 mmap, shadow buffer 도 새로 만듦 */
+    fb_flush_sync (fb);
+    if ((ret = _fb_mode (fb, true)) > 0)
+        fb_flush_remap (fb);
+    return ret;
+}
+
+//-----------------------------------------------------------------------------
+/*
+    "mem:WxHxBPP" : 화면 장치 대신 memfd 에 그림 (build server 에서 benchmark, 회귀 시험용).
+    fd 를 공유하면 다른 process 에서도 같은 화면 memory 를 mmap 할 수 있음.
+*/
+static int _fb_mem (fb_info_t *fb, const char *spec)
+{
+    int w, h, bpp;
+    char c;
+
+    if ((sscanf (spec, "%dx%dx%d%c", &w, &h, &bpp, &c) != 3) ||
+        (w <= 0) || (h <= 0) || ((bpp != 16) && (bpp != 24) && (bpp != 32))) {
+        err("invalid memory device!(%s%s)\n", FB_MEM_PREFIX, spec);
+        return -1;
+    }
+    fb->w       = w;
+    fb->h       = h;
+    fb->bpp     = bpp;
+    fb->stride  = w * (bpp >> 3);
+    fb->size    = fb->stride * h;
+    fb->is_mem  = true;
+
+    if ((fb->fd = memfd_create ("fb-mem", MFD_CLOEXEC)) < 0) {
+        err("memfd_create");
+        return -1;
+    }
+    if (ftruncate (fb->fd, fb->size) < 0) {
+        err("ftruncate");
+        return -1;
+    }
+    fb->base = (char *)mmap(NULL, fb->size, PROT_READ | PROT_WRITE, MAP_SHARED, fb->fd, 0);
+    if (fb->base == (char *)-1) {
+        fb->base = NULL;
+        err("mmap");
+        return -1;
+    }
+    fb->data = fb->base;
+    return 0;
+}
+
 //-----------------------------------------------------------------------------
 fb_info_t *fb_init (const char *DEVICE_NAME)
 {
-	struct fb_var_screeninfo fvsi;
-	struct fb_fix_screeninfo ffsi;
-    
     fb_info_t   *fb = (fb_info_t *)malloc(sizeof(fb_info_t));
 
     if (fb == NULL) {
@@ -344,43 +838,70 @@ fb_info_t *fb_init (const char *DEVICE_NAME)
     }
 	memset(fb, 0, sizeof(fb_info_t));
 
-	if ((fb->fd = open(DEVICE_NAME, O_RDWR)) < 0) {
-		err("open");
-        return NULL;
-	}
-	if (ioctl(fb->fd, FBIOGET_VSCREENINFO, &fvsi) < 0) {
-		err("ioctl(FBIOGET_VSCREENINFO)");
-        goto out;
-	}
-	if (ioctl(fb->fd, FBIOGET_FSCREENINFO, &ffsi) < 0) {
-		err("ioctl(FBIOGET_FSCREENINFO)");
-        goto out;
-	}
-
-	fb->w       = fvsi.xres;
-	fb->h       = fvsi.yres;
-	fb->bpp     = fvsi.bits_per_pixel;
-	fb->stride  = ffsi.line_length;
-
-	if (fvsi.red.length != 8 || fvsi.green.length != 8 || fvsi.blue.length != 8) {
-		err("mmap");
-        goto out;
-	}
-
-	fb->base = (char *)mmap((caddr_t) NULL, ffsi.smem_len,
-                        PROT_READ | PROT_WRITE, MAP_SHARED, fb->fd, 0);
+    if (!strncmp (DEVICE_NAME, FB_MEM_PREFIX, strlen(FB_MEM_PREFIX))) {
+        if (_fb_mem (fb, DEVICE_NAME + strlen(FB_MEM_PREFIX)) < 0)
+            goto out;
+    }
+    else if (!strncmp (DEVICE_NAME, FB_DRM_PREFIX, strlen(FB_DRM_PREFIX))) {
+        const char *path = DEVICE_NAME + strlen(FB_DRM_PREFIX);
 
-	if (fb->base == (char *)-1) {
-		err("mmap");
-        goto out;
-	}
+        if (fb_drm_open (fb, *path ? path : FB_DRM_DEVICE) < 0)
+            goto out;
+    }
+    else {
+        if ((fb->fd = open(DEVICE_NAME, O_RDWR)) < 0) {
+            err("open");
+            free (fb);
+            return NULL;
+        }
+        if (_fb_mode (fb, false) < 0)
+            goto out;
+    }
 
-    fb->data = fb->base + ((unsigned long) ffsi.smem_start % (unsigned long) getpagesize());
+    /* FB_PROBE 환경변수가 설정된 경우 장치 memory 에 가장 빠른 fill/copy kernel 선택 */
+    fb_probe (fb, getenv (FB_PROBE_ENV));
     return  fb;
 out:
     fb_close(fb);
     return  NULL;
 }
 
+//-----------------------------------------------------------------------------
+/*
+    화면 장치 없이 메모리에 그리기 위한 fb (layer, offscreen 용).
+    32bpp 인 경우 alpha 가 0 인 pixel 은 그려지지 않은(투명) pixel 로 사용.
+*/
+fb_info_t *fb_surface_init (int w, int h, int bpp, bool is_bgr)
+{
+    fb_info_t   *fb;
+
+    if ((w <= 0) || (h <= 0) || ((bpp != 16) && (bpp != 24) && (bpp != 32))) {
+        err("invalid surface size!(w = %d, h = %d, bpp = %d)\n", w, h, bpp);
+        return NULL;
+    }
+    if ((fb = (fb_info_t *)malloc(sizeof(fb_info_t))) == NULL) {
+        err("framebuffer malloc error!\n");
+        return NULL;
+    }
+    memset(fb, 0, sizeof(fb_info_t));
+
+    fb->fd      = -1;
+    fb->w       = w;
+    fb->h       = h;
+    fb->bpp     = bpp;
+    fb->stride  = w * (bpp >> 3);
+    fb->is_bgr  = is_bgr;
+    fb->size    = fb->stride * h;
+    fb->base    = (char *)mmap(NULL, fb->size, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (fb->base == (char *)-1) {
+        err("mmap");
+        free (fb);
+        return NULL;
+    }
+    fb->data    = fb->base;
+    return fb;
+}
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
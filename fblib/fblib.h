@@ -14,6 +14,13 @@
 #define UINT_TO_R(i)        ((i >> 16) & 0xFF)
 #define UINT_TO_G(i)        ((i >>  8) & 0xFF)
 #define UINT_TO_B(i)        ((i      ) & 0xFF)
+/*
+    16bpp : is_bgr 이면 blue 가 하위 bit (일반적인 RGB565), 아니면 red 가 하위 bit.
+    (24/32bpp 에서 is_bgr 이면 memory 순서가 b,g,r 인 것과 같은 배치)
+*/
+#define UINT_TO_565(i,bgr)  ((bgr) ? \
+        ((UINT_TO_R(i) >> 3) << 11) | ((UINT_TO_G(i) >> 2) << 5) | (UINT_TO_B(i) >> 3) : \
+        ((UINT_TO_B(i) >> 3) << 11) | ((UINT_TO_G(i) >> 2) << 5) | (UINT_TO_R(i) >> 3))
 /*
     https://www.rapidtables.com/web/color/RGB_Color.html
 */
@@ -37,6 +44,23 @@
 #define COLOR_TEAL          RGB_TO_UINT(0,128,128)
 #define COLOR_NAVY          RGB_TO_UINT(0,0,128)
 
+//-----------------------------------------------------------------------------
+/*
+    span kernel 을 실행하는 CPU 에 맞는 version 으로 선택 (gcc ifunc, x86 : AVX2 / SSE2).
+    aarch64 는 NEON 이 기본 명령어이므로 compiler vectorize 로 처리함.
+*/
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+    #define FB_CLONES   __attribute__((target_clones("avx2", "default")))
+#else
+    #define FB_CLONES
+#endif
+
+/*
+    draw 함수가 사용하는 전역 상태(선택된 font, 통계)는 thread 별로 가짐 (fb_tile).
+    libfb.so 에서도 __tls_get_addr 호출 없이 접근하도록 initial-exec model 사용.
+*/
+#define FB_TLS      __thread __attribute__((tls_model("initial-exec")))
+
 //-----------------------------------------------------------------------------
 // Frame buffer struct
 //-----------------------------------------------------------------------------
@@ -50,6 +74,38 @@ typedef union fb_color__u {
     unsigned int uint;
 }	fb_color_u;
 
+typedef struct fb_rect__t {
+	int			x, y, w, h;
+}	fb_rect_t;
+
+/* fb_init 에서 메모리 장치를 선택하는 이름 (mem:1920x1080x32) */
+#define FB_MEM_PREFIX       "mem:"
+
+/* DRM/KMS 장치를 선택하는 이름 (drm:/dev/dri/card0, "drm:" 만 사용하면 card0) */
+#define FB_DRM_PREFIX       "drm:"
+
+/* damage 목록 최대 개수, 초과시 가장 가까운 영역과 합침 */
+#define FB_DAMAGE_MAX       16
+
+/* fb_present 에서 호출할 hook 최대 개수 (capture, mirroring 등) */
+#define FB_HOOK_MAX         4
+
+struct fb_info__t;
+typedef void (*fb_hook_f) (struct fb_info__t *fb, void *arg);
+
+typedef struct fb_hook__t {
+	fb_hook_f	func;
+	void		*arg;
+}	fb_hook_t;
+
+/* 32bpp span fill, 화면 장치 memory 로의 복사 kernel (fb_probe.c) */
+typedef void (*fb_fill32_f) (unsigned int *p, unsigned int v, int n);
+typedef void (*fb_copy_f)   (void *d, const void *s, int n);
+
+/* damage 영역을 화면 장치 memory 로 복사 (fb_probe 로 선택된 kernel, 없으면 memcpy) */
+#define FB_COPY(fb, d, s, n) \
+	do { if ((fb)->copy) (fb)->copy (d, s, n); else memcpy (d, s, n); } while (0)
+
 typedef struct fb_info__t {
 	int			fd;
 	int			w;
@@ -59,6 +115,34 @@ typedef struct fb_info__t {
 	bool		is_bgr;
 	char		*base;
 	char		*data;
+	/* mmap size (smem_len) */
+	int			size;
+	/* "mem:WxHxBPP" 로 생성된 메모리 장치 (memfd, ioctl 없음) */
+	bool		is_mem;
+	/* "drm:" 으로 생성된 DRM/KMS 장치 (fb_drm.c, data 는 back buffer) */
+	struct fb_drm__t	*drm;
+	/*
+		fb_flush_init 으로 설정된 비동기 flush thread (fb_flush.c).
+		data 는 RAM shadow buffer 이며 fb_present 에서 damage 영역만 장치로 복사됨.
+	*/
+	struct fb_flush__t	*flush;
+
+	/*
+		draw 함수에서 변경된 영역을 기록함 (put_pixel 은 기록하지 않음).
+		사용하는 쪽에서 읽은 후 fb_damage_clear 로 초기화.
+	*/
+	int			damage_cnt;
+	fb_rect_t	damage[FB_DAMAGE_MAX];
+
+	/* fb_present 에서 damage 목록을 전달받는 hook */
+	int			hook_cnt;
+	fb_hook_t	hook[FB_HOOK_MAX];
+
+	/* pixel 을 쓸 수 있는 영역 (w = 0 이면 화면 전체), tile 별 rasterize 에서 사용 (fb_tile) */
+	fb_rect_t	clip;
+	/* 장치 memory 에 대하여 측정한 가장 빠른 kernel (NULL 이면 기본 kernel, fb_probe) */
+	fb_fill32_f	fill32;
+	fb_copy_f	copy;
 }	fb_info_t;
 
 //-----------------------------------------------------------------------------
@@ -80,13 +164,26 @@ enum eFONTS_HANGUL {
 extern void         put_pixel 	(fb_info_t *fb, int x, int y, int color);
 extern void         draw_text 	(fb_info_t *fb, int x, int y,
 									int f_color, int b_color, int scale, char *fmt, ...);
+extern int          draw_text_diff (fb_info_t *fb, int x, int y,
+									int f_color, int b_color, int scale, char *o_str, char *n_str);
 extern void         draw_line 	(fb_info_t *fb, int x, int y, int w, int color);
 extern void         draw_rect 	(fb_info_t *fb, int x, int y, int w, int h, int lw, int color);
 extern void         draw_fill_rect (fb_info_t *fb, int x, int y, int w, int h, int color);
+extern void         fb_shift_area  (fb_info_t *fb, int x, int y, int w, int h, int dx);
+extern void         fb_scroll_area (fb_info_t *fb, int x, int y, int w, int h, int dy);
 extern void         set_font	(enum eFONTS_HANGUL s_font);
+extern int          fb_clip         (fb_info_t *fb, int *x, int *y, int *w, int *h);
+extern void         fb_rect_merge   (fb_rect_t *list, int *cnt, int max, fb_rect_t *r);
+extern void         fb_damage_add   (fb_info_t *fb, int x, int y, int w, int h);
+extern void         fb_damage_clear (fb_info_t *fb);
+extern int          fb_hook_add     (fb_info_t *fb, fb_hook_f func, void *arg);
+extern void         fb_hook_del     (fb_info_t *fb, fb_hook_f func, void *arg);
+extern int          fb_present      (fb_info_t *fb);
 extern void         fb_clear 	(fb_info_t *fb);
 extern void         fb_close 	(fb_info_t *fb);
+extern int          fb_update_mode (fb_info_t *fb);
 extern fb_info_t    *fb_init 	(const char *DEVICE_NAME);
+extern fb_info_t    *fb_surface_init (int w, int h, int bpp, bool is_bgr);
 
 //------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------
@@ -47,25 +47,49 @@
 #include <sys/mman.h>
 #include <linux/fb.h>
 #include <getopt.h>
+#include <signal.h>
 
 #include "typedefs.h"
 #include "fblib/fblib.h"
+#include "fblib/fb_dump.h"
+#include "fblib/fb_stats.h"
+#include "fblib/fb_flush.h"
 
 #include "ui_parser.h"
+#include "ui_queue.h"
+#include "ui_sched.h"
+#include "ui_cmd.h"
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 const char *OPT_DEVICE_NAME = "/dev/fb0";
 const char *OPT_TEXT_STR = "FrameBuffer 테스트 프로그램입니다.";
+const char *OPT_DUMP_NAME = NULL;
+const char *OPT_DAEMON_PATH = NULL;
+const char *OPT_SCRIPT_NAME = NULL;
 unsigned int opt_x = 0, opt_y = 0, opt_width = 0, opt_height = 0, opt_color = 0;
 unsigned char opt_red = 0, opt_green = 0, opt_blue = 0, opt_thckness = 1, opt_scale = 1;
-unsigned char opt_clear = 0, opt_fill = 0, opt_info = 0, opt_font = 0;
+unsigned char opt_clear = 0, opt_fill = 0, opt_info = 0, opt_font = 0, opt_profile = 0;
+int opt_tile = -1, opt_queue = 0;
+
+/* -P : main 에서 첫 화면 반영까지 단계별 시간 */
+#define	STARTUP_STEP_MAX	8
+
+typedef struct startup_step__t {
+	const char	*name;
+	long		ns;
+}	startup_step_t;
+
+static startup_step_t	startup[STARTUP_STEP_MAX];
+static int				startup_cnt = 0;
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 static void print_usage(const char *prog)
 {
-	printf("Usage: %s [-DrgbxywhfntscCi]\n", prog);
+	printf("Usage: %s [-DrgbxywhfntscCiFOdSPTQ]\n", prog);
 	puts("  -D --device    device to use (default /dev/fb0)\n"
+	     "                 mem:WxHxBPP = memory device (ex mem:1920x1080x32)\n"
+	     "                 drm:[/dev/dri/cardN] = DRM/KMS page flip (default card0)\n"
 	     "  -r --red       pixel red hex value.(default = 0)\n"
 	     "  -g --green     pixel green hex value.(default = 0)\n"
 	     "  -b --blue      pixel blue hex value.(default = 0)\n"
@@ -86,6 +110,12 @@ static void print_usage(const char *prog)
 		 "                 2 HANGODIC\n"
 		 "                 3 HANPIL\n"
 		 "                 4 HANSOFT\n"
+	     "  -O --output    dump framebuffer to file before exit.(.png or .ppm)\n"
+	     "  -d --daemon    run as daemon, receive commands from unix socket or FIFO path.\n"
+	     "  -S --script    run daemon commands from file('-' = stdin), 'p' = present.\n"
+	     "  -P --profile   print startup time from main to first presented frame.\n"
+	     "  -T --tile      full repaint with N threads by screen tiles.(0 = all cpus)\n"
+	     "  -Q --queue     draw to RAM, copy to device on flush thread.(N frames queue)\n"
 	);
 	exit(1);
 }
@@ -111,11 +141,18 @@ static void parse_opts(int argc, char *argv[])
 			{ "clear",		0, 0, 'C' },
 			{ "info",		0, 0, 'i' },
 			{ "font",		1, 0, 'F' },
+			{ "output",		1, 0, 'O' },
+			{ "daemon",		1, 0, 'd' },
+			{ "script",		1, 0, 'S' },
+			{ "profile",	0, 0, 'P' },
+			{ "tile",		1, 0, 'T' },
+			{ "queue",		1, 0, 'Q' },
 			{ NULL, 0, 0, 0 },
 		};
 		int c;
+		long v;
 
-		c = getopt_long(argc, argv, "D:r:g:b:x:y:w:h:fn:t:s:c:CiF:", lopts, NULL);
+		c = getopt_long(argc, argv, "D:r:g:b:x:y:w:h:fn:t:s:c:CiF:O:d:S:PT:Q:", lopts, NULL);
 
 		if (c == -1)
 			break;
@@ -125,16 +162,16 @@ static void parse_opts(int argc, char *argv[])
 			OPT_DEVICE_NAME = optarg;
 			break;
 		case 'r':
-            opt_red = strtol(optarg, NULL, 16);
-			opt_red = opt_red > 255 ? 255 : opt_red;
+            v = strtol(optarg, NULL, 16);
+			opt_red = v > 255 ? 255 : v;
 			break;
 		case 'g':
-            opt_green = strtol(optarg, NULL, 16);
-			opt_green = opt_green > 255 ? 255 : opt_green;
+            v = strtol(optarg, NULL, 16);
+			opt_green = v > 255 ? 255 : v;
 			break;
 		case 'b':
-            opt_blue = strtol(optarg, NULL, 16);
-			opt_blue = opt_blue > 255 ? 255 : opt_blue;
+            v = strtol(optarg, NULL, 16);
+			opt_blue = v > 255 ? 255 : v;
 			break;
 		case 'x':
             opt_x = abs(atoi(optarg));
@@ -174,6 +211,25 @@ static void parse_opts(int argc, char *argv[])
 		case 'F':
 			opt_font = abs(atoi(optarg));
 			break;
+		case 'O':
+			OPT_DUMP_NAME = optarg;
+			break;
+		case 'd':
+			OPT_DAEMON_PATH = optarg;
+			break;
+		case 'S':
+			OPT_SCRIPT_NAME = optarg;
+			break;
+		case 'P':
+			opt_profile = 1;
+			break;
+		case 'T':
+			opt_tile = abs(atoi(optarg));
+			break;
+		case 'Q':
+			opt_queue = abs(atoi(optarg));
+			opt_queue = opt_queue ? opt_queue : FB_FLUSH_DEPTH;
+			break;
 		default:
 			print_usage(argv[0]);
 			break;
@@ -185,21 +241,67 @@ static void parse_opts(int argc, char *argv[])
 int disable_blink_cursor(void)
 {
     int fd;
-    char buf[10];
+    char buf[2];
 	/*
-		echo 1 > /sys/class/graphics/fbcon/cursor_blink
+		echo 0 > /sys/class/graphics/fbcon/cursor_blink
+		이미 0 이면 쓰지 않음 (sysfs 쓰기는 console 을 다시 그리므로 booting 시간에 포함됨)
 	*/
     if((fd = open("/sys/class/graphics/fbcon/cursor_blink", O_RDWR)) <0 )   {
         perror("/sys/class/graphics/fbcon/cursor_blink open fail!\n");
         return -1;
     }
-    memset(buf, 0x00, sizeof(buf));
-    sprintf(buf, "%c\n", '0');
-    write(fd, buf, sizeof(buf));
+    if ((read(fd, buf, 1) != 1) || (buf[0] != '0')) {
+        buf[0] = '0';   buf[1] = '\n';
+        if (pwrite(fd, buf, sizeof(buf), 0) < 0)
+            perror("cursor_blink write fail!\n");
+    }
     close(fd);
     return 0;
 }
 
+//------------------------------------------------------------------------------
+static void startup_mark (const char *name)
+{
+	struct timespec ts;
+
+	if (startup_cnt < STARTUP_STEP_MAX) {
+		clock_gettime (CLOCK_MONOTONIC, &ts);
+		startup[startup_cnt].name = name;
+		startup[startup_cnt].ns   = ts.tv_sec * 1000000000L + ts.tv_nsec;
+		startup_cnt++;
+	}
+}
+
+//------------------------------------------------------------------------------
+static void startup_hook (fb_info_t *fb, void *arg)
+{
+	/* fb_present 에서 호출, 첫 frame 만 기록 (hook 은 startup_report 에서 제거) */
+	bool *presented = (bool *)arg;
+
+	(void)fb;
+	if (!*presented) {
+		*presented = true;
+		startup_mark ("first present");
+	}
+}
+
+//------------------------------------------------------------------------------
+static void startup_report (fb_info_t *fb, bool *presented)
+{
+	int i;
+
+	fb_hook_del (fb, startup_hook, presented);
+	if (!opt_profile)
+		return;
+
+	info("startup profile (%s)\n", OPT_DEVICE_NAME);
+	for (i = 1; i < startup_cnt; i++)
+		info("  %-16s %9.3f ms (+%.3f ms)\n", startup[i].name,
+			(startup[i].ns - startup[0].ns) / 1e6, (startup[i].ns - startup[i - 1].ns) / 1e6);
+	if (!*presented)
+		info("  no frame presented\n");
+}
+
 //------------------------------------------------------------------------------
 void dump_fb_info (fb_info_t *fb)
 {
@@ -211,30 +313,155 @@ void dump_fb_info (fb_info_t *fb)
 	printf("bgr    : %d\n", fb->is_bgr);
 	printf("fb_base     : %p\n", fb->base);
 	printf("fb_data     : %p\n", fb->data);
+	{
+		fb_stats_t st;
+
+		/* FB_PROBE 로 측정한 경우 선택된 kernel 및 쓰기 속도 */
+		fb_stats_get (&st);
+		if (st.copy_kern)
+			printf("fb_kernel   : fill = %s (%u MB/s), copy = %s (%u MB/s)\n",
+				st.fill_kern, st.fill_mbs, st.copy_kern, st.copy_mbs);
+	}
 	printf("==================================\n");
 }
 
+//------------------------------------------------------------------------------
+/*
+	fb 와 ui_grp 을 유지한 상태로 command 를 받아 frame 단위로 처리 ('q' command 로 종료).
+*/
+int run_daemon (fb_info_t *fb, ui_grp_t *ui_grp, const char *path)
+{
+	ui_queue_t		*q;
+	ui_sched_t		*s = NULL;
+	ui_cmd_srv_t	*srv = NULL;
+	int ret = -1;
+
+	if ((q = ui_queue_init ()) == NULL)
+		return -1;
+	if ((s = ui_sched_init (fb, ui_grp, q, UI_SCHED_FPS_DEFAULT)) == NULL)
+		goto out;
+	if ((srv = ui_cmd_init (s, path)) == NULL)
+		goto out;
+
+	ui_sched_run (s);
+	info("daemon exit.(commands = %lu, frames = %lu, coalesced = %lu, errors = %lu, ring = %lu)\n",
+		srv->cmds, srv->frames, srv->coalesced, srv->errors, srv->ring_cmds);
+	ret = 0;
+out:
+	ui_cmd_close (srv);
+	ui_sched_close (s);
+	ui_queue_close (q);
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+/*
+	script 의 command(daemon 과 같은 형식) 를 1 process 에서 순서대로 처리.
+	'p' 에서만 present 하고 끝에 반영되지 않은 내용이 있으면 present. ('q' 로 중간 종료)
+*/
+int run_script (fb_info_t *fb, ui_grp_t *ui_grp, const char *fname)
+{
+	FILE		*fp;
+	ui_cmd_t	cmd;
+	char		line[UI_CMD_BUF_SIZE], *p;
+	int			line_no = 0, cnt = 0, presents = 0, errors = 0;
+
+	fp = strcmp (fname, "-") ? fopen (fname, "r") : stdin;
+	if (fp == NULL) {
+		err("%s open fail!\n", fname);
+		return -1;
+	}
+
+	while (fgets (line, sizeof(line), fp)) {
+		line_no++;
+		if ((p = strpbrk (line, "\r\n")) != NULL)
+			*p = 0;
+		if ((line[0] == 0) || (line[0] == '#'))
+			continue;
+		if (ui_cmd_parse (line, &cmd)) {
+			err("%s:%d unknown command : %s\n", fname, line_no, line);
+			errors++;
+			continue;
+		}
+		if (cmd.op == eUI_CMD_QUIT)
+			break;
+		if (cmd.op == eUI_CMD_PRESENT) {
+			ui_present (fb, ui_grp);
+			presents++;
+			cnt = 0;
+			continue;
+		}
+		cnt += ui_cmd_exec (fb, ui_grp, &cmd);
+	}
+	if (cnt) {
+		ui_present (fb, ui_grp);
+		presents++;
+	}
+	if (fp != stdin)
+		fclose (fp);
+
+	info("script end.(lines = %d, presents = %d, errors = %d)\n", line_no, presents, errors);
+	return errors ? -1 : 0;
+}
+
 //------------------------------------------------------------------------------
 int main(int argc, char **argv)
 {
 	fb_info_t	*pfb;
 	int f_color, b_color;
 	ui_grp_t 	*ui_grp;
+	bool		presented = false;
 
+	startup_mark ("main");
     parse_opts(argc, argv);
 
-    if (disable_blink_cursor ())
-		exit(1);
+	/* 메모리 장치, DRM (별도의 scanout buffer) 은 console cursor 와 관계 없음 */
+	if (strncmp (OPT_DEVICE_NAME, FB_MEM_PREFIX, strlen(FB_MEM_PREFIX)) &&
+		strncmp (OPT_DEVICE_NAME, FB_DRM_PREFIX, strlen(FB_DRM_PREFIX))) {
+		if (disable_blink_cursor ())
+			exit(1);
+		startup_mark ("cursor_blink");
+	}
 
     if ((pfb = fb_init (OPT_DEVICE_NAME)) == NULL) {
 		err("frame buffer init fail!\n");
 		exit(1);
 	}
+	startup_mark ("fb_init");
+
+	/* 느린 화면 장치 (SPI/USB) 는 장치 복사를 기다리지 않고 다음 frame 을 그림 */
+	if (opt_queue && fb_flush_init (pfb, opt_queue))
+		err("flush thread start fail! draw to device directly.\n");
+	fb_hook_add (pfb, startup_hook, &presented);
 
 	if ((ui_grp = ui_init (pfb, "ui.cfg")) == NULL) {
 		err("User interface create fail!\n");
 		exit(1);
 	}
+	/* ui_init 에서 전체 item 을 그린 후 반영하므로 첫 frame 은 ui_init 안에서 present 됨 */
+	startup_mark ("ui_init");
+	startup_report (pfb, &presented);
+
+	/* 이후 전체 다시 그리기(화면 모드 변경 등)는 tile 로 나누어 그림 */
+	if (opt_tile >= 0) {
+		info("ui tile threads = %d\n", ui_tile (pfb, ui_grp, opt_tile));
+		ui_update (pfb, ui_grp, -1);
+		ui_present (pfb, ui_grp);
+	}
+
+	/* kill -USR1 <pid> 로 draw 통계 출력 */
+	fb_stats_signal (SIGUSR1);
+
+	if (OPT_DAEMON_PATH || OPT_SCRIPT_NAME) {
+		int ret = OPT_DAEMON_PATH ?
+			run_daemon (pfb, ui_grp, OPT_DAEMON_PATH) : run_script (pfb, ui_grp, OPT_SCRIPT_NAME);
+
+		if (OPT_DUMP_NAME && fb_dump (pfb, OPT_DUMP_NAME))
+			err("%s dump fail!\n", OPT_DUMP_NAME);
+		fb_close (pfb);
+		ui_close (ui_grp);
+		return ret ? 1 : 0;
+	}
 	
 	f_color = RGB_TO_UINT(opt_red, opt_green, opt_blue);
 	b_color = COLOR_WHITE;
@@ -287,7 +514,16 @@ int main(int argc, char **argv)
             draw_line(pfb, opt_x, opt_y, opt_width, f_color);
     }
 
-	ui_update(pfb, ui_grp, -1);
+	/*
+		ui_init 에서 이미 전체 화면을 그렸으므로 다시 그리지 않음 (clear 한 경우만 다시 그림).
+		위에서 그린 text/rect 를 반영.
+	*/
+	if (opt_clear)
+		ui_update(pfb, ui_grp, -1);
+	ui_present(pfb, ui_grp);
+
+	if (OPT_DUMP_NAME && fb_dump (pfb, OPT_DUMP_NAME))
+		err("%s dump fail!\n", OPT_DUMP_NAME);
 	sleep(1);
 
 #if 0
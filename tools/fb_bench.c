@@ -0,0 +1,300 @@
+//------------------------------------------------------------------------------
+//
+// fblib primitive benchmark (메모리 장치에서 측정, median/p99 및 JSON 결과)
+//
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "../typedefs.h"
+#include "../fblib/fblib.h"
+#include "../ui_parser.h"
+
+//------------------------------------------------------------------------------
+/* 1 sample 에서 반복할 최소 시간, sample 수 */
+#define	BENCH_SAMPLE_NS		1000000L
+#define	BENCH_SAMPLES		31
+#define	BENCH_CASE_MAX		128
+
+#define	BENCH_STR_ASCII		"Bench123"
+#define	BENCH_STR_HANGUL	"한글폰트"
+
+typedef struct bench_case__t {
+	char			name[64];
+	/* 1 op 에서 그리는 pixel 수 */
+	long			pixels;
+	long			iters;
+	double			median, p99;
+}	bench_case_t;
+
+typedef struct bench__t {
+	fb_info_t		*fb;
+	ui_grp_t		*ui_grp;
+	int				samples;
+	long			sample_ns;
+	const char		*filter;
+	int				cnt;
+	bench_case_t	c[BENCH_CASE_MAX];
+}	bench_t;
+
+typedef struct text_arg__t {
+	int				scale;
+	const char		*str;
+}	text_arg_t;
+
+/* 측정 대상 op, i = 반복 번호 */
+typedef void (*bench_f) (bench_t *b, long i, void *arg);
+
+static const char *FONT_NAME[eFONT_END] = {
+	"myeongjo", "hanboot", "hangodic", "hanpil", "hansoft"
+};
+
+//------------------------------------------------------------------------------
+static void print_usage(const char *prog)
+{
+	printf("Usage: %s [-Dnsfcj]\n", prog);
+	puts("  -D --device    surface to draw (default mem:1280x720x32)\n"
+	     "  -n --samples   samples per case.(default 31)\n"
+	     "  -s --sample_us minimum time of one sample.(default 1000 us)\n"
+	     "  -f --filter    run only cases containing the string.\n"
+	     "  -c --config    ui config for ui_update case.(default ui.cfg)\n"
+	     "  -j --json      write results to json file.\n"
+	);
+	exit(1);
+}
+
+//------------------------------------------------------------------------------
+static long now_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static int cmp_double (const void *a, const void *b)
+{
+	double d = *(const double *)a - *(const double *)b;
+
+	return (d > 0) - (d < 0);
+}
+
+//------------------------------------------------------------------------------
+static long run_iters (bench_t *b, bench_f func, void *arg, long iters)
+{
+	long i, t = now_ns ();
+
+	for (i = 0; i < iters; i++)
+		func (b, i, arg);
+	/* damage 목록이 계속 합쳐지지 않도록 sample 마다 초기화 */
+	fb_damage_clear (b->fb);
+	return now_ns () - t;
+}
+
+//------------------------------------------------------------------------------
+/*
+	1 sample 이 sample_ns 이상 되도록 반복 횟수를 정한 후 samples 번 측정.
+	pixels 가 0 이면 op 1번의 damage 영역 크기를 사용.
+*/
+static void bench_run (bench_t *b, const char *name, bench_f func, void *arg, long pixels)
+{
+	bench_case_t *c;
+	double *ns;
+	long iters = 1;
+	int i;
+
+	if ((b->filter && !strstr (name, b->filter)) || (b->cnt >= BENCH_CASE_MAX))
+		return;
+	if ((ns = (double *)malloc (sizeof(double) * b->samples)) == NULL)
+		return;
+
+	c = &b->c[b->cnt++];
+	memset (c, 0x00, sizeof(bench_case_t));
+	strncpy (c->name, name, sizeof(c->name) - 1);
+
+	fb_damage_clear (b->fb);
+	func (b, 0, arg);
+	if (!pixels) {
+		for (i = 0; i < b->fb->damage_cnt; i++)
+			pixels += (long)b->fb->damage[i].w * b->fb->damage[i].h;
+	}
+	c->pixels = pixels;
+	fb_damage_clear (b->fb);
+
+	while ((run_iters (b, func, arg, iters) < b->sample_ns) && (iters < (1L << 30)))
+		iters <<= 1;
+	c->iters = iters;
+
+	for (i = 0; i < b->samples; i++)
+		ns[i] = (double)run_iters (b, func, arg, iters) / iters;
+
+	qsort (ns, b->samples, sizeof(double), cmp_double);
+	c->median = ns[b->samples / 2];
+	c->p99    = ns[(b->samples * 99 + 99) / 100 - 1];
+	free (ns);
+
+	printf("%-32s %12.1f %12.1f %12.2f\n", c->name, c->median, c->p99,
+		c->pixels / c->median * 1000.);
+}
+
+//------------------------------------------------------------------------------
+static void op_pixel (bench_t *b, long i, void *arg)
+{
+	(void)arg;
+	put_pixel (b->fb, i % b->fb->w, (i / b->fb->w) % b->fb->h, (int)i);
+}
+
+static void op_line (bench_t *b, long i, void *arg)
+{
+	(void)arg;
+	draw_line (b->fb, 0, i % b->fb->h, b->fb->w, (int)i);
+}
+
+static void op_fill (bench_t *b, long i, void *arg)
+{
+	int size = *(int *)arg;
+
+	draw_fill_rect (b->fb, (i * 7) % (b->fb->w - size), (i * 3) % (b->fb->h - size),
+		size, size, (int)i);
+}
+
+static void op_clear (bench_t *b, long i, void *arg)
+{
+	(void)i;	(void)arg;
+	fb_clear (b->fb);
+}
+
+static void op_text (bench_t *b, long i, void *arg)
+{
+	text_arg_t *t = (text_arg_t *)arg;
+
+	draw_text (b->fb, 0, 0, (int)i, COLOR_BLACK, t->scale, "%s", t->str);
+}
+
+static void op_ui_update (bench_t *b, long i, void *arg)
+{
+	(void)i;	(void)arg;
+	ui_update (b->fb, b->ui_grp, -1);
+}
+
+//------------------------------------------------------------------------------
+static int write_json (bench_t *b, const char *fname, const char *device)
+{
+	FILE *fp;
+	int i;
+
+	if ((fp = fopen (fname, "w")) == NULL) {
+		err("%s open fail!\n", fname);
+		return -1;
+	}
+	fprintf(fp, "{\n  \"device\": \"%s\",\n  \"samples\": %d,\n  \"sample_ns\": %ld,\n"
+		"  \"results\": [\n", device, b->samples, b->sample_ns);
+	for (i = 0; i < b->cnt; i++) {
+		bench_case_t *c = &b->c[i];
+
+		fprintf(fp, "    { \"name\": \"%s\", \"pixels\": %ld, \"iters\": %ld, "
+			"\"median_ns\": %.1f, \"p99_ns\": %.1f, \"pixels_per_sec\": %.0f }%s\n",
+			c->name, c->pixels, c->iters, c->median, c->p99,
+			c->pixels / c->median * 1e9, (i < b->cnt - 1) ? "," : "");
+	}
+	fprintf(fp, "  ]\n}\n");
+	fclose (fp);
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+	static const struct option lopts[] = {
+		{ "device",		1, 0, 'D' },
+		{ "samples",	1, 0, 'n' },
+		{ "sample_us",	1, 0, 's' },
+		{ "filter",		1, 0, 'f' },
+		{ "config",		1, 0, 'c' },
+		{ "json",		1, 0, 'j' },
+		{ NULL, 0, 0, 0 },
+	};
+	const char *device = "mem:1280x720x32", *cfg = "ui.cfg", *json = NULL;
+	static bench_t b;
+	char name[64];
+	text_arg_t t;
+	int c, font, size;
+	int sizes[] = { 16, 64, 256 };
+
+	b.samples   = BENCH_SAMPLES;
+	b.sample_ns = BENCH_SAMPLE_NS;
+
+	while ((c = getopt_long(argc, argv, "D:n:s:f:c:j:", lopts, NULL)) != -1) {
+		switch (c) {
+		case 'D':	device = optarg;							break;
+		case 'n':	b.samples = abs(atoi(optarg));				break;
+		case 's':	b.sample_ns = abs(atoi(optarg)) * 1000L;	break;
+		case 'f':	b.filter = optarg;							break;
+		case 'c':	cfg = optarg;								break;
+		case 'j':	json = optarg;								break;
+		default:	print_usage(argv[0]);						break;
+		}
+	}
+	if (b.samples < 1)
+		print_usage(argv[0]);
+
+	/* 실제 장치는 다른 process 의 영향을 받으므로 기본은 메모리 장치 */
+	if ((b.fb = fb_init (device)) == NULL) {
+		err("%s init fail!\n", device);
+		return 1;
+	}
+	if ((b.fb->w < 1024) || (b.fb->h < 256)) {
+		err("%s : surface must be at least 1024x256\n", device);
+		fb_close (b.fb);
+		return 1;
+	}
+
+	printf("%s, %d samples\n", device, b.samples);
+	printf("%-32s %12s %12s %12s\n", "case", "median(ns)", "p99(ns)", "Mpixels/s");
+
+	bench_run (&b, "put_pixel", op_pixel, NULL, 1);
+	bench_run (&b, "draw_line", op_line, NULL, 0);
+	for (size = 0; size < (int)(sizeof(sizes) / sizeof(sizes[0])); size++) {
+		snprintf (name, sizeof(name), "draw_fill_rect/%d", sizes[size]);
+		bench_run (&b, name, op_fill, &sizes[size], 0);
+	}
+	bench_run (&b, "fb_clear", op_clear, NULL, 0);
+
+	/* ascii 는 font 선택과 관계없이 같은 font 를 사용 */
+	for (t.str = BENCH_STR_ASCII, t.scale = 1; t.scale <= 16; t.scale++) {
+		snprintf (name, sizeof(name), "draw_text/ascii/s%d", t.scale);
+		bench_run (&b, name, op_text, &t, 0);
+	}
+	for (t.str = BENCH_STR_HANGUL, font = 0; font < eFONT_END; font++) {
+		set_font (font);
+		for (t.scale = 1; t.scale <= 16; t.scale++) {
+			snprintf (name, sizeof(name), "draw_text/hangul/%s/s%d", FONT_NAME[font], t.scale);
+			bench_run (&b, name, op_text, &t, 0);
+		}
+	}
+	set_font (eFONT_HAN_DEFAULT);
+
+	if ((b.ui_grp = ui_init (b.fb, cfg)) != NULL) {
+		bench_run (&b, "ui_update/all", op_ui_update, NULL, 0);
+		/* 같은 전체 다시 그리기를 CPU 수 만큼의 thread 에서 tile 로 나누어 그림 */
+		if (ui_tile (b.fb, b.ui_grp, 0) > 1)
+			bench_run (&b, "ui_update/all/tile", op_ui_update, NULL, 0);
+		ui_close (b.ui_grp);
+	}
+	else
+		err("%s load fail, skip ui_update\n", cfg);
+
+	if (json && write_json (&b, json, device))
+		return 1;
+
+	fb_close (b.fb);
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
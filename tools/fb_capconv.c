@@ -0,0 +1,81 @@
+//------------------------------------------------------------------------------
+//
+// capture stream(fb_cap) -> image file 변환 tool
+//
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "../typedefs.h"
+#include "../fblib/fblib.h"
+#include "../fblib/fb_dump.h"
+#include "../fblib/fb_cap.h"
+
+//------------------------------------------------------------------------------
+static void print_usage(const char *prog)
+{
+	printf("Usage: %s [-pki] <capture file> <output prefix>\n", prog);
+	puts("  -p --png       save png image.(default ppm)\n"
+	     "  -k --key       save keyframes only.\n"
+	     "  -i --info      print frame list only.\n"
+	     "  output file name : <output prefix>_<frame no>_<msec>.ppm\n"
+	);
+	exit(1);
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+	static const struct option lopts[] = {
+		{ "png",	0, 0, 'p' },
+		{ "key",	0, 0, 'k' },
+		{ "info",	0, 0, 'i' },
+		{ NULL, 0, 0, 0 },
+	};
+	bool opt_png = false, opt_key = false, opt_info = false;
+	fb_cap_rd_t *rd;
+	char fname[256];
+	int c, ret, frame = 0, saved = 0;
+
+	while ((c = getopt_long(argc, argv, "pki", lopts, NULL)) != -1) {
+		switch (c) {
+		case 'p':	opt_png  = true;	break;
+		case 'k':	opt_key  = true;	break;
+		case 'i':	opt_info = true;	break;
+		default:	print_usage(argv[0]);	break;
+		}
+	}
+	if (argc - optind < (opt_info ? 1 : 2))
+		print_usage(argv[0]);
+
+	if ((rd = fb_cap_rd_init (argv[optind])) == NULL)
+		exit(1);
+
+	/* delta frame 은 이전 frame 에 누적되므로 모든 frame 을 순서대로 재생 */
+	while ((ret = fb_cap_read (rd)) > 0) {
+		if (opt_info)
+			printf("%6d %c %8d ms\n", frame, rd->type, rd->msec);
+		else if (!opt_key || (rd->type == eFB_CAP_KEY)) {
+			snprintf (fname, sizeof(fname), "%s_%06d_%08d.%s",
+				argv[optind + 1], frame, rd->msec, opt_png ? "png" : "ppm");
+			if (fb_dump (rd->fb, fname)) {
+				fb_cap_rd_close (rd);
+				exit(1);
+			}
+			saved++;
+		}
+		frame++;
+	}
+	if (ret < 0)
+		err("%s : broken frame %d\n", argv[optind], frame);
+
+	printf("%d frames, %d images saved\n", frame, saved);
+	fb_cap_rd_close (rd);
+	return ret < 0 ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
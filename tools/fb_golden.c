@@ -0,0 +1,607 @@
+//------------------------------------------------------------------------------
+//
+// golden image 회귀 시험 (primitive 별 CRC 를 기록된 값과 비교)
+//
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/stat.h>
+
+#include "../typedefs.h"
+#include "../fblib/fblib.h"
+#include "../fblib/fb_dump.h"
+#include "../fblib/fb_layer.h"
+#include "../fblib/fb_cap.h"
+#include "../fblib/fb_image.h"
+#include "../ui_parser.h"
+
+//------------------------------------------------------------------------------
+#define	GOLDEN_W			320
+#define	GOLDEN_H			200
+#define	GOLDEN_CASE_MAX		512
+#define	GOLDEN_SCALE_MAX	8
+/* fb_cap_enc 출력 버퍼 뒤에 넘쳐 쓰는지 확인하는 영역 */
+#define	GOLDEN_GUARD		4096
+
+/* channel 이 바뀌면 값이 달라지도록 r, g, b 가 모두 다른 색 */
+#define	GOLDEN_FC			0xC08040
+#define	GOLDEN_BC			0x103870
+
+typedef struct golden_fmt__t {
+	const char		*name;
+	int				bpp;
+	bool			is_bgr;
+}	golden_fmt_t;
+
+typedef struct golden_case__t {
+	char			name[64];
+	unsigned int	crc;
+}	golden_case_t;
+
+/* 시험할 그림, arg = scale 또는 font */
+typedef void (*golden_f) (fb_info_t *fb, int arg);
+
+typedef struct golden__t {
+	const char		*diff_dir;
+	bool			update, verbose;
+	int				cnt, failed, missing;
+	golden_case_t	c[GOLDEN_CASE_MAX];
+	/* golden 파일에서 읽은 값 */
+	int				g_cnt;
+	golden_case_t	g[GOLDEN_CASE_MAX];
+}	golden_t;
+
+/* 기준 형식 (모든 형식은 이 형식의 결과와 같은 그림이어야 함) */
+static const golden_fmt_t FORMAT[] = {
+	{ "rgb32", 32, false },
+	{ "bgr32", 32, true  },
+	{ "rgb24", 24, false },
+	{ "bgr24", 24, true  },
+	{ "rgb16", 16, false },
+	{ "bgr16", 16, true  },
+};
+
+static const char *FONT_NAME[eFONT_END] = {
+	"myeongjo", "hanboot", "hangodic", "hanpil", "hansoft"
+};
+
+//------------------------------------------------------------------------------
+static void print_usage(const char *prog)
+{
+	printf("Usage: %s [-uov] <golden file>\n", prog);
+	puts("  -u --update    write current results to golden file.\n"
+	     "  -o --output    directory for mismatch images.(default golden_diff)\n"
+	     "  -v --verbose   print all cases.\n"
+	);
+	exit(1);
+}
+
+//------------------------------------------------------------------------------
+static void g_pixel (fb_info_t *fb, int arg)
+{
+	int x, y;
+
+	(void)arg;
+	for (y = -2; y < fb->h + 2; y += 7)
+		for (x = -3; x < fb->w + 3; x += 5)
+			put_pixel (fb, x, y, RGB_TO_UINT(x & 0xFF, y & 0xFF, ((x + y) & 0xFF)));
+}
+
+static void g_line (fb_info_t *fb, int arg)
+{
+	(void)arg;
+	draw_line (fb, 10, 10, 100, GOLDEN_FC);
+	draw_line (fb, -20, 20, 60, GOLDEN_BC);
+	draw_line (fb, fb->w - 30, 30, 60, COLOR_WHITE);
+	draw_line (fb, 5, fb->h - 1, fb->w, COLOR_CYAN);
+	draw_line (fb, 5, fb->h, 10, COLOR_RED);
+}
+
+static void g_rect (fb_info_t *fb, int arg)
+{
+	(void)arg;
+	draw_rect (fb, 10, 10, 80, 60, 1, GOLDEN_FC);
+	draw_rect (fb, 100, 10, 80, 60, 3, GOLDEN_BC);
+	draw_rect (fb, 200, 10, 4, 60, 3, COLOR_YELLOW);
+	draw_rect (fb, -10, 100, 50, 50, 2, COLOR_MAGENTA);
+	draw_rect (fb, fb->w - 40, fb->h - 40, 80, 80, 5, COLOR_WHITE);
+}
+
+static void g_fill (fb_info_t *fb, int arg)
+{
+	(void)arg;
+	draw_fill_rect (fb, 10, 10, 100, 50, GOLDEN_FC);
+	draw_fill_rect (fb, -30, 80, 60, 40, GOLDEN_BC);
+	draw_fill_rect (fb, fb->w - 20, fb->h - 20, 50, 50, COLOR_LIME);
+	draw_fill_rect (fb, 150, 150, 1, 1, COLOR_WHITE);
+}
+
+static void g_clear (fb_info_t *fb, int arg)
+{
+	(void)arg;
+	draw_fill_rect (fb, 0, 0, fb->w, fb->h, GOLDEN_FC);
+	fb_clear (fb);
+	draw_fill_rect (fb, 20, 20, 10, 10, GOLDEN_BC);
+}
+
+static void g_shift (fb_info_t *fb, int arg)
+{
+	(void)arg;
+	g_pixel (fb, 0);
+	draw_fill_rect (fb, 40, 40, 60, 30, GOLDEN_FC);
+	fb_shift_area (fb, 20, 20, 120, 80, 7);
+	fb_shift_area (fb, 150, 20, 120, 80, -5);
+	fb_scroll_area (fb, 20, 110, 200, 80, 6);
+	fb_scroll_area (fb, 220, 110, 80, 80, -9);
+}
+
+static void g_text_ascii (fb_info_t *fb, int scale)
+{
+	set_font (eFONT_HAN_DEFAULT);
+	draw_text (fb, 3, 2, GOLDEN_FC, GOLDEN_BC, scale, "Ag#%d", scale);
+	/* 화면 오른쪽에서 잘리는 문자열 */
+	draw_text (fb, fb->w - 12, fb->h - 16, GOLDEN_BC, GOLDEN_FC, 1, "XYZ");
+}
+
+static void g_text_hangul (fb_info_t *fb, int arg)
+{
+	/* arg = font * GOLDEN_SCALE_MAX + scale - 1 */
+	set_font (arg / GOLDEN_SCALE_MAX);
+	draw_text (fb, 3, 2, GOLDEN_FC, GOLDEN_BC, arg % GOLDEN_SCALE_MAX + 1, "한글");
+	set_font (eFONT_HAN_DEFAULT);
+}
+
+static void g_text_diff (fb_info_t *fb, int arg)
+{
+	(void)arg;
+	set_font (eFONT_HAN_DEFAULT);
+	draw_text (fb, 4, 4, GOLDEN_FC, GOLDEN_BC, 2, "Hello 한글 world");
+	draw_text_diff (fb, 4, 4, GOLDEN_FC, GOLDEN_BC, 2, "Hello 한글 world", "Help 한국");
+}
+
+static void g_layer (fb_info_t *fb, int arg)
+{
+	fb_comp_t *comp;
+
+	(void)arg;
+	if ((comp = fb_comp_init (fb, 2)) == NULL)
+		return;
+	draw_fill_rect (fb_comp_layer (comp, 0), 0, 0, fb->w, fb->h, GOLDEN_BC);
+	draw_fill_rect (fb_comp_layer (comp, 1), 50, 50, 100, 60, GOLDEN_FC);
+	draw_text (fb_comp_layer (comp, 1), 60, 120, COLOR_WHITE, GOLDEN_FC, 2, "Layer");
+	fb_comp_present (comp);
+	fb_comp_close (comp);
+}
+
+static void g_cap_overlap (fb_info_t *fb, int arg)
+{
+	/*
+		fb_rect_merge 결과는 서로 겹칠 수 있음 (면적 합 > 화면).
+		fb_cap_size 크기의 버퍼를 넘지 않고 기록되고 같은 화면으로 재생되어야 함.
+		실패하면 fb 를 그리지 않으므로 CRC 가 달라짐.
+	*/
+	fb_info_t *src;
+	fb_cap_rd_t *rd;
+	unsigned char *d;
+	unsigned int v = 12345;
+	FILE *fp;
+	int size, len, i, x, y;
+
+	(void)arg;
+	if ((src = fb_surface_init (fb->w, fb->h, fb->bpp, fb->is_bgr)) == NULL)
+		return;
+	for (y = 0; y < src->h; y++)
+		for (x = 0; x < src->w; x++) {
+			v = v * 1103515245 + 12345;
+			put_pixel (src, x, y, (v >> 8) & 0xFFFFFF);
+		}
+	fb_damage_clear (src);
+	for (i = 0; i < 15; i++)
+		fb_damage_add (src, 0, i * 13, src->w, 6);
+	fb_damage_add (src, 0, 1, src->w, src->h - 1);
+
+	size = fb_cap_size (src);
+	if ((d = (unsigned char *)malloc (size + GOLDEN_GUARD)) == NULL) {
+		fb_close (src);
+		return;
+	}
+	memset (d + size, 0xA5, GOLDEN_GUARD);
+
+	if ((fp = tmpfile ()) != NULL) {
+		fwrite (d, 1, fb_cap_header (src, d), fp);
+		len = fb_cap_enc (src, 0, src->damage, src->damage_cnt, d, size);
+		for (i = 0; (i < GOLDEN_GUARD) && (d[size + i] == 0xA5); i++)
+			;
+		if ((len > 0) && (i == GOLDEN_GUARD)) {
+			fwrite (d, 1, len, fp);
+			fflush (fp);
+			lseek (fileno (fp), 0, SEEK_SET);
+			if ((rd = fb_cap_rd_fdopen (dup (fileno (fp)))) != NULL) {
+				if (fb_cap_read (rd) == 1)
+					for (y = 0; y < fb->h; y++)
+						memcpy (fb->data + y * fb->stride, rd->fb->data + y * rd->fb->stride,
+							fb->w * (fb->bpp >> 3));
+				fb_cap_rd_close (rd);
+			}
+		}
+		fclose (fp);
+	}
+	free (d);
+	fb_close (src);
+}
+
+//------------------------------------------------------------------------------
+/* header 의 한 field 를 value 로 바꾸거나 (field = 0 이면 그대로) len 으로 자른 BMP */
+typedef struct golden_bmp__t {
+	int				bpp, field;
+	unsigned int	value;
+	int				len;
+}	golden_bmp_t;
+
+static const golden_bmp_t BMP_CASE[] = {
+	{  8,  0, 0, 0 },				/* 정상 8bpp */
+	{ 32,  0, 0, 0 },				/* 정상 32bpp, 32bit red mask */
+	{  8, 14, 0xFFFFFFF2, 0 },		/* header 크기 + 14 가 넘침 */
+	{  8, 14, 0x7FFFFFFF, 0 },		/* header 크기 > file */
+	{  8, 46, 0x40000001, 0 },		/* palette 개수 * 4 가 넘침 */
+	{  8, 46, 257, 0 },				/* palette 개수 > 256 */
+	{  8, 22, 0x80000000, 0 },		/* 높이 INT_MIN */
+	{  8, 18, 0x7FFFFFFF, 0 },		/* 너비 */
+	{  8, 10, 0xFFFFFFF0, 0 },		/* data offset > file */
+	{  8,  0, 0, 40 },				/* header 가 잘림 */
+	{  8,  0, 0, 60 },				/* palette 가 잘림 */
+	{ 32,  0, 0, 100 },				/* data 가 잘림 */
+	{ 32, 28, 16, 0 },				/* 지원하지 않는 bpp */
+};
+
+static void g_le32 (unsigned char *p, unsigned int v)
+{
+	p[0] = v;	p[1] = v >> 8;	p[2] = v >> 16;	p[3] = v >> 24;
+}
+
+static int g_bmp_make (unsigned char *b, int bpp)
+{
+	/* 4x4, 8bpp 는 palette 4 색, 32bpp 는 BI_BITFIELDS (r, g, b mask) */
+	int off = (bpp == 8) ? 54 + 16 : 54 + 12, len = off + 4 * 4 * (bpp >> 3), i;
+
+	memset (b, 0, len);
+	b[0] = 'B';	b[1] = 'M';
+	g_le32 (b +  2, len);
+	g_le32 (b + 10, off);
+	g_le32 (b + 14, 40);
+	g_le32 (b + 18, 4);
+	g_le32 (b + 22, 4);
+	b[26] = 1;	b[28] = bpp;
+	if (bpp == 8) {
+		g_le32 (b + 46, 4);
+		/* palette 는 b, g, r, x */
+		g_le32 (b + 54, GOLDEN_FC);
+		g_le32 (b + 58, GOLDEN_BC);
+		g_le32 (b + 62, COLOR_WHITE);
+		g_le32 (b + 66, COLOR_CYAN);
+		for (i = 0; i < 16; i++)
+			b[off + i] = (i + i / 4) & 3;
+	} else {
+		b[30] = 3;
+		g_le32 (b + 54, 0xFFFFFFFF);
+		g_le32 (b + 58, 0x0000FF00);
+		g_le32 (b + 62, 0x000000FF);
+		for (i = 0; i < 16; i++)
+			g_le32 (b + off + i * 4, 0x11111111u * i + 0x0F);
+	}
+	return len;
+}
+
+static void g_image_bad (fb_info_t *fb, int arg)
+{
+	/*
+		잘못된 header 의 BMP 는 crash 없이 NULL 이어야 함.
+		읽은 image 는 그리고 읽지 못한 경우 같은 위치에 표시.
+	*/
+	char path[] = "/tmp/fb_golden_XXXXXX";
+	unsigned char b[256];
+	fb_image_t *img;
+	int fd, efd, len, i, n = sizeof(BMP_CASE) / sizeof(BMP_CASE[0]);
+
+	(void)arg;
+	/* 실패 case 의 err() 출력은 버림 */
+	fflush (stderr);
+	efd = dup (2);
+	if ((fd = open ("/dev/null", O_WRONLY)) >= 0) {
+		dup2 (fd, 2);
+		close (fd);
+	}
+	for (i = 0; i < n; i++) {
+		const golden_bmp_t *c = &BMP_CASE[i];
+
+		len = g_bmp_make (b, c->bpp);
+		if (c->field)
+			g_le32 (b + c->field, c->value);
+		if (c->len)
+			len = c->len;
+		if ((fd = mkstemp (path)) < 0)
+			break;
+		img = (write (fd, b, len) == len) ? fb_image_load (fb, path) : NULL;
+		close (fd);
+		unlink (path);
+		strcpy (path + strlen (path) - 6, "XXXXXX");
+
+		if (img) {
+			fb_image_draw (fb, img, 10 + i * 20, 10);
+			fb_image_put (img);
+		}
+		else
+			draw_fill_rect (fb, 10 + i * 20, 10, 4, 4, GOLDEN_FC);
+	}
+	if (efd >= 0) {
+		dup2 (efd, 2);
+		close (efd);
+	}
+}
+
+//------------------------------------------------------------------------------
+/* 16진수 색은 0x, 0X 를 붙여도 같은 값 (이전 설정 파일 호환) */
+static const char *UI_HEX_CFG =
+	"ODROID-UI-CONFIG\n"
+	"C, %d, %sFFFFFF, %s808080, %s008000, 2\n"
+	"R, 0,  5, 5, 40, 40, %s2040C0, 3, -1\n"
+	"R, 1, 50, 5, 40, 40, -1, 2, %sC08040\n"
+	"S, 1, -1, -1, 2, %sFF0000, -1, HEX, -1\n";
+
+static void g_ui_cfg (fb_info_t *fb, const char *x, const char *X)
+{
+	char path[] = "/tmp/fb_golden_XXXXXX";
+	ui_grp_t *ui_grp;
+	FILE *fp;
+	int fd;
+
+	if ((fd = mkstemp (path)) < 0)
+		return;
+	if ((fp = fdopen (fd, "w")) == NULL) {
+		close (fd);
+		unlink (path);
+		return;
+	}
+	fprintf (fp, UI_HEX_CFG, fb->is_bgr, x, X, x, X, x, X);
+	fclose (fp);
+	if ((ui_grp = ui_init (fb, path)) != NULL) {
+		ui_update (fb, ui_grp, -1);
+		ui_close (ui_grp);
+	}
+	unlink (path);
+}
+
+static void g_ui_hex (fb_info_t *fb, int arg)
+{
+	/* 0x 를 붙인 설정과 붙이지 않은 설정이 다른 그림이면 표시 */
+	fb_info_t *ref;
+
+	(void)arg;
+	g_ui_cfg (fb, "0x", "0X");
+	if ((ref = fb_surface_init (fb->w, fb->h, fb->bpp, fb->is_bgr)) == NULL)
+		return;
+	g_ui_cfg (ref, "", "");
+	if (memcmp (fb->data, ref->data, fb->stride * fb->h))
+		draw_fill_rect (fb, 0, 0, 8, 8, COLOR_RED);
+	fb_close (ref);
+}
+
+//------------------------------------------------------------------------------
+static int golden_load (golden_t *g, const char *fname)
+{
+	FILE *fp;
+	char line[128];
+
+	if ((fp = fopen (fname, "r")) == NULL)
+		return -1;
+	while (fgets (line, sizeof(line), fp) && (g->g_cnt < GOLDEN_CASE_MAX)) {
+		golden_case_t *c = &g->g[g->g_cnt];
+
+		if ((line[0] == '#') || (sscanf (line, "%63s %x", c->name, &c->crc) != 2))
+			continue;
+		g->g_cnt++;
+	}
+	fclose (fp);
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static int golden_save (golden_t *g, const char *fname)
+{
+	FILE *fp;
+	int i;
+
+	if ((fp = fopen (fname, "w")) == NULL) {
+		err("%s open fail!\n", fname);
+		return -1;
+	}
+	fprintf(fp, "# fb_golden : %dx%d surface, case name / CRC32 of pixel memory\n",
+		GOLDEN_W, GOLDEN_H);
+	fprintf(fp, "# regenerate with 'tools/fb_golden -u %s' only after checking the images\n", fname);
+	for (i = 0; i < g->cnt; i++)
+		fprintf(fp, "%-40s %08x\n", g->c[i].name, g->c[i].crc);
+	fclose (fp);
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static golden_case_t *golden_find (golden_t *g, const char *name)
+{
+	int i;
+
+	for (i = 0; i < g->g_cnt; i++)
+		if (!strcmp (g->g[i].name, name))
+			return &g->g[i];
+	return NULL;
+}
+
+//------------------------------------------------------------------------------
+/*
+	ref(기준 형식) 와 비교. save 이면 그림과 비교 그림(다른 pixel 은 빨간색, 같은 pixel 은
+	어둡게 표시)을 저장. return : 다른 pixel 수
+*/
+static int golden_diff (golden_t *g, const char *name, fb_info_t *fb, fb_info_t *ref, bool save)
+{
+	fb_info_t *d;
+	unsigned char *a, *b;
+	char fname[256], *p;
+	int x, y, cnt = 0;
+
+	a = (unsigned char *)malloc (fb->w * 3);
+	b = (unsigned char *)malloc (fb->w * 3);
+	if ((d = fb_surface_init (fb->w, fb->h, 24, false)) == NULL || !a || !b) {
+		free (a);	free (b);	fb_close (d);
+		return -1;
+	}
+
+	for (y = 0; y < fb->h; y++) {
+		fb_dump_row (fb, y, a);
+		fb_dump_row (ref, y, b);
+		for (x = 0; x < fb->w; x++) {
+			unsigned char *pa = &a[x * 3], *pb = &b[x * 3];
+			/* 16bpp 는 기준 그림도 같은 bit 수로 줄여서 비교 */
+			int m = (fb->bpp == 16) ? 0xF8 : 0xFF, mg = (fb->bpp == 16) ? 0xFC : 0xFF;
+
+			if (((pa[0] & m) != (pb[0] & m)) || ((pa[1] & mg) != (pb[1] & mg)) ||
+				((pa[2] & m) != (pb[2] & m))) {
+				put_pixel (d, x, y, COLOR_RED);
+				cnt++;
+			} else
+				put_pixel (d, x, y, RGB_TO_UINT(pa[0] >> 2, pa[1] >> 2, pa[2] >> 2));
+		}
+	}
+
+	if (save && g->diff_dir) {
+		snprintf (fname, sizeof(fname), "%s/%s", g->diff_dir, name);
+		for (p = fname + strlen (g->diff_dir) + 1; *p; p++)
+			if (*p == '/')
+				*p = '_';
+		mkdir (g->diff_dir, 0755);
+		strncat (fname, ".png", sizeof(fname) - strlen (fname) - 1);
+		fb_dump_png (fb, fname);
+		strcpy (fname + strlen (fname) - 4, "_diff.png");
+		fb_dump_png (d, fname);
+	}
+	free (a);	free (b);
+	fb_close (d);
+	return cnt;
+}
+
+//------------------------------------------------------------------------------
+/*
+	모든 형식으로 그린 후 CRC 를 golden 값과 비교하고, 기준 형식과 같은 그림인지 확인.
+*/
+static void golden_run (golden_t *g, const char *name, golden_f func, int arg)
+{
+	fb_info_t *fb[sizeof(FORMAT) / sizeof(FORMAT[0])];
+	int i, n = sizeof(FORMAT) / sizeof(FORMAT[0]);
+
+	for (i = 0; i < n; i++) {
+		golden_case_t *c = &g->c[g->cnt], *gc;
+		bool fail = false;
+		int diff = 0;
+
+		if ((fb[i] = fb_surface_init (GOLDEN_W, GOLDEN_H, FORMAT[i].bpp, FORMAT[i].is_bgr)) == NULL)
+			exit(1);
+		func (fb[i], arg);
+
+		if (g->cnt >= GOLDEN_CASE_MAX)
+			continue;
+		g->cnt++;
+		snprintf (c->name, sizeof(c->name), "%s/%s", FORMAT[i].name, name);
+		c->crc = fb_dump_crc (fb[i]);
+
+		if (g->update)
+			continue;
+
+		if ((gc = golden_find (g, c->name)) == NULL) {
+			printf("MISSING %-40s %08x\n", c->name, c->crc);
+			g->missing++;
+			continue;
+		}
+		if (gc->crc != c->crc)
+			fail = true;
+		/* 형식별 분기(is_bgr, bpp)가 다른 그림을 그리면 golden 값과 관계없이 실패 */
+		if (i && (diff = golden_diff (g, c->name, fb[i], fb[0], false)) != 0)
+			fail = true;
+		if (fail) {
+			golden_diff (g, c->name, fb[i], fb[0], true);
+			printf("FAIL    %-40s %08x (golden %08x, %d pixels differ from %s)\n",
+				c->name, c->crc, gc->crc, diff, FORMAT[0].name);
+			g->failed++;
+		}
+		else if (g->verbose)
+			printf("ok      %-40s %08x\n", c->name, c->crc);
+	}
+	for (i = 0; i < n; i++)
+		fb_close (fb[i]);
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+	static const struct option lopts[] = {
+		{ "update",		0, 0, 'u' },
+		{ "output",		1, 0, 'o' },
+		{ "verbose",	0, 0, 'v' },
+		{ NULL, 0, 0, 0 },
+	};
+	static golden_t g;
+	char name[64];
+	int c, font, scale;
+
+	g.diff_dir = "golden_diff";
+	while ((c = getopt_long(argc, argv, "uo:v", lopts, NULL)) != -1) {
+		switch (c) {
+		case 'u':	g.update   = true;		break;
+		case 'o':	g.diff_dir = optarg;	break;
+		case 'v':	g.verbose  = true;		break;
+		default:	print_usage(argv[0]);	break;
+		}
+	}
+	if (optind >= argc)
+		print_usage(argv[0]);
+
+	if (!g.update && golden_load (&g, argv[optind])) {
+		err("%s load fail! (create with -u)\n", argv[optind]);
+		return 1;
+	}
+
+	golden_run (&g, "put_pixel",      g_pixel, 0);
+	golden_run (&g, "draw_line",      g_line, 0);
+	golden_run (&g, "draw_rect",      g_rect, 0);
+	golden_run (&g, "draw_fill_rect", g_fill, 0);
+	golden_run (&g, "fb_clear",       g_clear, 0);
+	golden_run (&g, "shift_scroll",   g_shift, 0);
+	golden_run (&g, "draw_text_diff", g_text_diff, 0);
+	golden_run (&g, "layer",          g_layer, 0);
+	golden_run (&g, "cap_overlap",    g_cap_overlap, 0);
+	golden_run (&g, "image_bad",      g_image_bad, 0);
+	golden_run (&g, "ui_hex",         g_ui_hex, 0);
+	for (scale = 1; scale <= GOLDEN_SCALE_MAX; scale++) {
+		snprintf (name, sizeof(name), "text/ascii/s%d", scale);
+		golden_run (&g, name, g_text_ascii, scale);
+	}
+	for (font = 0; font < eFONT_END; font++) {
+		for (scale = 1; scale <= GOLDEN_SCALE_MAX; scale++) {
+			snprintf (name, sizeof(name), "text/%s/s%d", FONT_NAME[font], scale);
+			golden_run (&g, name, g_text_hangul, font * GOLDEN_SCALE_MAX + scale - 1);
+		}
+	}
+
+	if (g.update) {
+		if (golden_save (&g, argv[optind]))
+			return 1;
+		printf("%s : %d cases written\n", argv[optind], g.cnt);
+		return 0;
+	}
+	printf("%d cases, %d failed, %d missing\n", g.cnt, g.failed, g.missing);
+	return (g.failed || g.missing) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
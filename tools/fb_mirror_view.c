@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------------
+//
+// framebuffer mirroring viewer (fb_mirror server 의 화면을 다른 fb 에 표시)
+//
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "../typedefs.h"
+#include "../fblib/fblib.h"
+#include "../fblib/fb_dump.h"
+#include "../fblib/fb_cap.h"
+#include "../fblib/fb_mirror.h"
+
+//------------------------------------------------------------------------------
+static void print_usage(const char *prog)
+{
+	printf("Usage: %s [-Dno] <socket path>\n", prog);
+	puts("  -D --device    device to display (default /dev/fb0, mem:WxHxBPP)\n"
+	     "  -n --frames    exit after n frames.(default 0 = until server closes)\n"
+	     "  -O --output    dump displayed screen to file before exit.(.png or .ppm)\n"
+	);
+	exit(1);
+}
+
+//------------------------------------------------------------------------------
+static void blit_rect (fb_info_t *d, fb_info_t *s, fb_rect_t *r)
+{
+	/* 같은 형식이면 line 단위 복사, 다르면 RGB 로 변환하여 pixel 단위 (화면 밖은 잘림) */
+	int x, y, w = r->w, h = r->h, sb = s->bpp >> 3, db = d->bpp >> 3;
+	unsigned char *rgb = NULL;
+
+	if (r->x + w > d->w)	w = d->w - r->x;
+	if (r->y + h > d->h)	h = d->h - r->y;
+	if ((w <= 0) || (h <= 0))
+		return;
+
+	for (y = r->y; y < r->y + h; y++) {
+		unsigned char *sp = (unsigned char *)s->data + y * s->stride + r->x * sb;
+
+		if ((sb == db) && (s->is_bgr == d->is_bgr)) {
+			memcpy (d->data + y * d->stride + r->x * db, sp, w * sb);
+			continue;
+		}
+		if (!rgb && ((rgb = (unsigned char *)malloc (s->w * 3)) == NULL))
+			return;
+		fb_dump_row (s, y, rgb);
+		for (x = r->x; x < r->x + w; x++)
+			put_pixel (d, x, y, RGB_TO_UINT(rgb[x * 3], rgb[x * 3 + 1], rgb[x * 3 + 2]));
+	}
+	free (rgb);
+	fb_damage_add (d, r->x, r->y, w, h);
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+	static const struct option lopts[] = {
+		{ "device",	1, 0, 'D' },
+		{ "frames",	1, 0, 'n' },
+		{ "output",	1, 0, 'O' },
+		{ NULL, 0, 0, 0 },
+	};
+	const char *device = "/dev/fb0", *output = NULL;
+	fb_info_t *fb;
+	fb_cap_rd_t *rd;
+	int c, i, fd, frames = 0, cnt = 0, ret;
+
+	while ((c = getopt_long(argc, argv, "D:n:O:", lopts, NULL)) != -1) {
+		switch (c) {
+		case 'D':	device = optarg;				break;
+		case 'n':	frames = abs(atoi(optarg));		break;
+		case 'O':	output = optarg;				break;
+		default:	print_usage(argv[0]);			break;
+		}
+	}
+	if (optind >= argc)
+		print_usage(argv[0]);
+
+	if ((fb = fb_init (device)) == NULL)
+		exit(1);
+	if (((fd = fb_mirror_connect (argv[optind])) < 0) ||
+		((rd = fb_cap_rd_fdopen (fd)) == NULL)) {
+		fb_close (fb);
+		exit(1);
+	}
+
+	while ((ret = fb_cap_read (rd)) > 0) {
+		for (i = 0; i < rd->fb->damage_cnt; i++)
+			blit_rect (fb, rd->fb, &rd->fb->damage[i]);
+		fb_damage_clear (rd->fb);
+		fb_present (fb);
+		if (frames && (++cnt >= frames))
+			break;
+	}
+	if (ret < 0)
+		err("broken mirror stream!\n");
+
+	if (output && fb_dump (fb, output))
+		err("%s dump fail!\n", output);
+
+	fb_cap_rd_close (rd);
+	fb_close (fb);
+	return ret < 0 ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,449 @@
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+//
+// UI command daemon (unix socket / FIFO, frame 단위 batch 처리)
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE     /* accept4 */
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "typedefs.h"
+#include "fblib/fblib.h"
+#include "ui_parser.h"
+#include "ui_queue.h"
+#include "ui_sched.h"
+#include "ui_cmd.h"
+#include "ui_ring.h"
+
+//------------------------------------------------------------------------------
+// Function prototype.
+//------------------------------------------------------------------------------
+static   void        _ui_cmd_push      (ui_cmd_srv_t *srv, ui_cmd_t *cmd);
+static   void        _ui_cmd_drop      (ui_cmd_client_t *c);
+static   void        _ui_cmd_bell      (void *arg);
+static   void        _ui_cmd_ring      (ui_cmd_client_t *c);
+static   int         _ui_cmd_ring_drain(ui_cmd_srv_t *srv);
+static   void        _ui_cmd_read      (void *arg);
+static   void        _ui_cmd_accept    (void *arg);
+static   int         _ui_cmd_client    (ui_cmd_srv_t *srv, int fd);
+         int         ui_cmd_parse      (const char *line, ui_cmd_t *cmd);
+         int         ui_cmd_exec       (fb_info_t *fb, ui_grp_t *ui_grp, ui_cmd_t *cmd);
+         int         ui_cmd_apply      (void *arg);
+         void        ui_cmd_close      (ui_cmd_srv_t *srv);
+         ui_cmd_srv_t *ui_cmd_init     (ui_sched_t *s, const char *path);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+/*
+   daemon 은 fb 와 ui_grp 을 유지한 상태로 socket/FIFO 에서 command 를 받는다.
+   받은 command 는 batch 에 모아두었다가 scheduler 의 다음 frame 에서 한번에 처리하고 1번만 present.
+   같은 frame 안에서 같은 id 의 문자열 변경은 마지막 것만 처리.
+   'r' 을 보낸 socket client 는 공유 memory ring 을 받아 system call 없이 command 를 보낼 수 있다.
+*/
+
+//------------------------------------------------------------------------------
+/*
+   text command 1 line 을 cmd 로 변환. return : 0 = 성공, -1 = 잘못된 command
+*/
+int ui_cmd_parse (const char *line, ui_cmd_t *cmd)
+{
+   int n = 0, scale = 1, font = -1, ret;
+
+   memset (cmd, 0x00, sizeof(ui_cmd_t));
+   cmd->magic = UI_CMD_MAGIC;
+   cmd->op    = line[0];
+
+   switch (cmd->op) {
+      case  eUI_CMD_STR:
+      case  eUI_CMD_LOG:
+         ret = (sscanf (line + 1, "%d %n", &cmd->id, &n) == 1);
+         break;
+      case  eUI_CMD_STR_EX:
+         ret = (sscanf (line + 1, "%d %d %d %d %d %n",
+                  &cmd->id, &cmd->x, &cmd->y, &scale, &font, &n) == 5);
+         break;
+      case  eUI_CMD_FILL:
+         ret = (sscanf (line + 1, "%d %d %d %d %x",
+                  &cmd->x, &cmd->y, &cmd->w, &cmd->h, &cmd->fc) == 5);
+         break;
+      case  eUI_CMD_RECT:
+         /* scale = 선 두께 */
+         ret = (sscanf (line + 1, "%d %d %d %d %x %d",
+                  &cmd->x, &cmd->y, &cmd->w, &cmd->h, &cmd->fc, &scale) >= 5);
+         break;
+      case  eUI_CMD_TEXT:
+         ret = (sscanf (line + 1, "%d %d %x %x %d %n",
+                  &cmd->x, &cmd->y, &cmd->fc, &cmd->bc, &scale, &n) == 5);
+         break;
+      case  eUI_CMD_VALUE:
+         /* x = 막대 번호, y = 값 */
+         ret = (sscanf (line + 1, "%d %d %d", &cmd->id, &cmd->x, &cmd->y) == 3);
+         break;
+      case  eUI_CMD_UPDATE:
+         ret = (sscanf (line + 1, "%d", &cmd->id) == 1);
+         break;
+      case  eUI_CMD_LAYER:
+         ret = (sscanf (line + 1, "%d %d", &cmd->id, &cmd->x) == 2);
+         break;
+      case  eUI_CMD_PRESENT:
+      case  eUI_CMD_QUIT:
+      case  eUI_CMD_RING:
+         ret = 1;
+         break;
+      default :
+         ret = 0;
+         break;
+   }
+   if (!ret)
+      return -1;
+
+   cmd->scale = scale;
+   cmd->font  = font;
+   if (n)
+      strncpy (cmd->str, line + 1 + n, ITEM_STR_MAX - 1);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+/*
+   command 1개를 처리. fill/rect/text 는 fb 에 직접 그림 (present/quit 은 호출한 쪽에서 처리).
+   return : 처리하면 1, 아니면 0
+*/
+int ui_cmd_exec (fb_info_t *fb, ui_grp_t *ui_grp, ui_cmd_t *cmd)
+{
+   cmd->str[ITEM_STR_MAX - 1] = 0;
+
+   switch (cmd->op) {
+      case  eUI_CMD_STR:
+         /* 문자열만 변경 (0 = 위치/크기/font 는 이전 값 유지) */
+         ui_set_str (fb, ui_grp, cmd->id, 0, 0, 0, 0, "%s", cmd->str);
+         break;
+      case  eUI_CMD_STR_EX:
+         ui_set_str (fb, ui_grp, cmd->id, cmd->x, cmd->y, cmd->scale, cmd->font,
+                     "%s", cmd->str);
+         break;
+      case  eUI_CMD_FILL:
+         draw_fill_rect (fb, cmd->x, cmd->y, cmd->w, cmd->h, cmd->fc);
+         break;
+      case  eUI_CMD_RECT:
+         draw_rect (fb, cmd->x, cmd->y, cmd->w, cmd->h,
+                     (cmd->scale > 0) ? cmd->scale : 1, cmd->fc);
+         break;
+      case  eUI_CMD_TEXT:
+         set_font (ui_grp->f_type);
+         draw_text (fb, cmd->x, cmd->y, cmd->fc, cmd->bc,
+                     (cmd->scale > 0) ? cmd->scale : 1, "%s", cmd->str);
+         break;
+      case  eUI_CMD_VALUE:
+         ui_set_value (fb, ui_grp, cmd->id, cmd->x, cmd->y);
+         break;
+      case  eUI_CMD_LOG:
+         ui_log (fb, ui_grp, cmd->id, "%s", cmd->str);
+         break;
+      case  eUI_CMD_UPDATE:
+         ui_update (fb, ui_grp, cmd->id);
+         break;
+      case  eUI_CMD_LAYER:
+         ui_layer_show (fb, ui_grp, cmd->id, cmd->x ? true : false);
+         break;
+      default :
+         return 0;
+   }
+   return 1;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_cmd_push (ui_cmd_srv_t *srv, ui_cmd_t *cmd)
+{
+   int i;
+
+   /* batch 가 가득차면 frame 을 기다리지 않고 먼저 처리 (present 는 다음 frame) */
+   if (srv->cnt >= UI_CMD_BATCH_MAX)
+      ui_cmd_apply (srv);
+
+   /* 아직 처리하지 않은 같은 id 의 문자열 변경은 취소 */
+   if (cmd->op == eUI_CMD_STR) {
+      for (i = 0; i < srv->cnt; i++) {
+         if ((srv->batch[i].op == eUI_CMD_STR) && (srv->batch[i].id == cmd->id)) {
+            srv->batch[i].op = eUI_CMD_NOP;
+            srv->coalesced++;
+         }
+      }
+   }
+   memcpy (&srv->batch[srv->cnt++], cmd, sizeof(ui_cmd_t));
+   srv->cmds++;
+   ui_sched_kick (srv->s);
+}
+
+//------------------------------------------------------------------------------
+static void _ui_cmd_drop (ui_cmd_client_t *c)
+{
+   ui_sched_watch (c->srv->s, c->fd, NULL, NULL);
+   close (c->fd);
+   c->fd  = -1;
+   c->len = 0;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_cmd_bell (void *arg)
+{
+   ui_cmd_srv_t *srv = (ui_cmd_srv_t *)arg;
+   uint64_t v;
+
+   /* ring 이 비어있다가 채워짐, 다음 frame 에서 처리 */
+   if (read (srv->ring->efd, &v, sizeof(v)) < 0)
+      return;
+   ui_sched_kick (srv->s);
+}
+
+//------------------------------------------------------------------------------
+static void _ui_cmd_ring (ui_cmd_client_t *c)
+{
+   ui_cmd_srv_t *srv = c->srv;
+
+   if (!srv->ring) {
+      if ((srv->ring = ui_ring_create ()) == NULL) {
+         srv->errors++;
+         return;
+      }
+      if (ui_sched_watch (srv->s, srv->ring->efd, _ui_cmd_bell, srv) < 0) {
+         ui_ring_close (srv->ring);
+         srv->ring = NULL;
+         srv->errors++;
+         return;
+      }
+   }
+   /* FIFO 는 fd 를 전달할 수 없음 */
+   if (ui_ring_send (srv->ring, c->fd) < 0) {
+      err("command ring send fail!\n");
+      srv->errors++;
+   }
+}
+
+//------------------------------------------------------------------------------
+/*
+   ring 의 command 를 처리. 한 frame 에 ring 크기만큼만 처리하여 producer 가 frame 을 지연시키지 않도록 함.
+*/
+static int _ui_cmd_ring_drain (ui_cmd_srv_t *srv)
+{
+   ui_cmd_t cmd;
+   uint64_t v = 1;
+   int i, cnt = 0;
+
+   for (i = 0; i < UI_RING_SIZE; i++) {
+      if (!ui_ring_pop (srv->ring, &cmd))
+         break;
+      srv->ring_cmds++;
+      if (cmd.op == eUI_CMD_QUIT)
+         ui_sched_stop (srv->s);
+      else
+         cnt += ui_cmd_exec (srv->s->fb, srv->s->ui_grp, &cmd);
+   }
+   /*
+      남은 command 가 있으면 (cnt != 0 이면 다음 frame 이 이어짐) 그대로 두고,
+      비었으면 doorbell 을 기다림. arm 하는 사이에 들어온 command 는 스스로 doorbell.
+   */
+   if (((i == UI_RING_SIZE) || ui_ring_arm (srv->ring)) && !cnt) {
+      if (write (srv->ring->efd, &v, sizeof(v)) < 0)
+         err("eventfd write error!\n");
+   }
+   return cnt;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_cmd_read (void *arg)
+{
+   ui_cmd_client_t *c = (ui_cmd_client_t *)arg;
+   ui_cmd_t cmd;
+   char *p, *e;
+   int n;
+
+   if ((n = read (c->fd, c->buf + c->len, UI_CMD_BUF_SIZE - c->len)) <= 0) {
+      if ((n == 0) || ((errno != EAGAIN) && (errno != EINTR)))
+         _ui_cmd_drop (c);
+      return;
+   }
+   c->len += n;
+
+   /* 완성된 command 만 처리하고 나머지는 다음 read 까지 보관 */
+   for (p = c->buf; p < c->buf + c->len; ) {
+      if ((unsigned char)*p == UI_CMD_MAGIC) {
+         if (c->buf + c->len - p < (int)sizeof(ui_cmd_t))
+            break;
+         memcpy (&cmd, p, sizeof(ui_cmd_t));
+         p += sizeof(ui_cmd_t);
+      } else {
+         if ((e = memchr (p, '\n', c->buf + c->len - p)) == NULL)
+            break;
+         *e = 0;
+         if ((e > p) && (e[-1] == '\r'))
+            e[-1] = 0;
+         n = (*p == 0) || (*p == '#') ? 1 : ui_cmd_parse (p, &cmd);
+         p = e + 1;
+         if (n) {
+            if (n < 0)
+               c->srv->errors++;
+            continue;
+         }
+         if (cmd.op == eUI_CMD_RING) {
+            _ui_cmd_ring (c);
+            continue;
+         }
+      }
+      _ui_cmd_push (c->srv, &cmd);
+   }
+   c->len -= p - c->buf;
+   memmove (c->buf, p, c->len);
+
+   /* 버퍼 크기보다 긴 line 은 버림 */
+   if (c->len == UI_CMD_BUF_SIZE) {
+      c->len = 0;
+      c->srv->errors++;
+   }
+}
+
+//------------------------------------------------------------------------------
+static int _ui_cmd_client (ui_cmd_srv_t *srv, int fd)
+{
+   int i;
+
+   for (i = 0; i < UI_CMD_CLIENT_MAX; i++) {
+      ui_cmd_client_t *c = &srv->client[i];
+
+      if (c->fd < 0) {
+         c->fd  = fd;
+         c->len = 0;
+         if (ui_sched_watch (srv->s, fd, _ui_cmd_read, c) < 0) {
+            c->fd = -1;
+            break;
+         }
+         return 0;
+      }
+   }
+   err("command client refused!\n");
+   close (fd);
+   return -1;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_cmd_accept (void *arg)
+{
+   ui_cmd_srv_t *srv = (ui_cmd_srv_t *)arg;
+   int fd;
+
+   while ((fd = accept4 (srv->lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+      _ui_cmd_client (srv, fd);
+}
+
+//------------------------------------------------------------------------------
+/*
+   scheduler 의 frame 마다 호출 (ui_sched_batch). return : 처리한 command 수
+*/
+int ui_cmd_apply (void *arg)
+{
+   ui_cmd_srv_t *srv = (ui_cmd_srv_t *)arg;
+   int i, cnt = 0;
+
+   for (i = 0; i < srv->cnt; i++) {
+      if (srv->batch[i].op == eUI_CMD_QUIT)
+         ui_sched_stop (srv->s);
+      else
+         cnt += ui_cmd_exec (srv->s->fb, srv->s->ui_grp, &srv->batch[i]);
+   }
+   if (srv->cnt)
+      srv->frames++;
+   srv->cnt = 0;
+
+   if (srv->ring)
+      cnt += _ui_cmd_ring_drain (srv);
+   return cnt;
+}
+
+//------------------------------------------------------------------------------
+void ui_cmd_close (ui_cmd_srv_t *srv)
+{
+   int i;
+
+   if (srv) {
+      ui_sched_batch (srv->s, NULL, NULL);
+      for (i = 0; i < UI_CMD_CLIENT_MAX; i++)
+         if (srv->client[i].fd >= 0)
+            _ui_cmd_drop (&srv->client[i]);
+      if (srv->ring) {
+         ui_sched_watch (srv->s, srv->ring->efd, NULL, NULL);
+         ui_ring_close (srv->ring);
+      }
+      if (srv->lfd >= 0) {
+         ui_sched_watch (srv->s, srv->lfd, NULL, NULL);
+         close (srv->lfd);
+         unlink (srv->path);
+      }
+      free (srv);
+   }
+}
+
+//------------------------------------------------------------------------------
+/*
+   path 가 FIFO 이면 FIFO 에서, 그 외에는 unix socket 을 만들어 command 를 받는다.
+*/
+ui_cmd_srv_t *ui_cmd_init (ui_sched_t *s, const char *path)
+{
+   ui_cmd_srv_t *srv;
+   struct sockaddr_un addr;
+   struct stat st;
+   int i, fd;
+
+   if ((srv = (ui_cmd_srv_t *)malloc(sizeof(ui_cmd_srv_t))) == NULL) {
+      err("ui_cmd malloc error!\n");
+      return NULL;
+   }
+   memset (srv, 0x00, sizeof(ui_cmd_srv_t));
+   srv->s   = s;
+   srv->lfd = -1;
+   for (i = 0; i < UI_CMD_CLIENT_MAX; i++) {
+      srv->client[i].srv = srv;
+      srv->client[i].fd  = -1;
+   }
+
+   if (!stat (path, &st) && S_ISFIFO(st.st_mode)) {
+      /* writer 가 모두 닫혀도 EOF 가 되지 않도록 O_RDWR 로 열어둠 */
+      if (((fd = open (path, O_RDWR | O_NONBLOCK | O_CLOEXEC)) < 0) ||
+          _ui_cmd_client (srv, fd))
+         goto out;
+   } else {
+      memset (&addr, 0x00, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      strncpy (addr.sun_path, path, sizeof(addr.sun_path) - 1);
+      memcpy (srv->path, addr.sun_path, sizeof(srv->path));
+
+      if ((srv->lfd = socket (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0)
+         goto out;
+      unlink (srv->path);
+      if ((bind (srv->lfd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+          (listen (srv->lfd, UI_CMD_CLIENT_MAX) < 0) ||
+          (ui_sched_watch (s, srv->lfd, _ui_cmd_accept, srv) < 0)) {
+         err("%s bind/listen error!\n", srv->path);
+         goto out;
+      }
+   }
+   ui_sched_batch (s, ui_cmd_apply, srv);
+   return srv;
+out:
+   ui_cmd_close (srv);
+   return NULL;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
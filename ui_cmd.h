@@ -0,0 +1,76 @@
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#ifndef __UI_CMD_H__
+#define __UI_CMD_H__
+
+//------------------------------------------------------------------------------
+/* binary command 의 첫 byte (text command 는 ASCII 문자로 시작) */
+#define	UI_CMD_MAGIC		0xFE
+/* 1 frame 에 모아서 처리하는 최대 command 수 */
+#define	UI_CMD_BATCH_MAX	256
+#define	UI_CMD_CLIENT_MAX	8
+/* client 별 수신 버퍼 (완성되지 않은 command 보관) */
+#define	UI_CMD_BUF_SIZE		4096
+
+enum eUI_CMD {
+	eUI_CMD_NOP    = 0,
+	eUI_CMD_STR    = 's',	/* s id str                       : 문자열 변경 */
+	eUI_CMD_STR_EX = 'S',	/* S id x y scale font str        : 위치/크기/font 포함 문자열 변경 */
+	eUI_CMD_FILL   = 'f',	/* f x y w h color                : 사각형 채움 */
+	eUI_CMD_RECT   = 'b',	/* b x y w h color lw             : 사각형 테두리 */
+	eUI_CMD_TEXT   = 't',	/* t x y fc bc scale str          : 문자열 그림 */
+	eUI_CMD_VALUE  = 'v',	/* v id idx value                 : widget 값 */
+	eUI_CMD_LOG    = 'l',	/* l id str                       : log panel 1 line 추가 */
+	eUI_CMD_UPDATE = 'u',	/* u id                           : item 다시 그림 (-1 = 전체) */
+	eUI_CMD_LAYER  = 'z',	/* z layer visible                : layer 표시/숨김 */
+	eUI_CMD_PRESENT= 'p',	/* p                              : 화면 반영 (daemon 은 frame 마다 자동) */
+	eUI_CMD_QUIT   = 'q',	/* q                              : daemon 종료 */
+	eUI_CMD_RING   = 'r',	/* r                              : 공유 memory command ring 요청 (socket 만) */
+};
+
+/*
+	text command 는 1 line (공백으로 구분, 색상은 hex, str 은 line 끝까지),
+	binary command 는 magic = UI_CMD_MAGIC 인 ui_cmd_t 크기 그대로 전송.
+*/
+typedef struct ui_cmd__t {
+	/* 전송되는 크기가 compiler 와 관계없도록 padding 이 없는 배치 */
+	unsigned char	magic, op;
+	signed char		scale, font;
+	int				id, x, y, w, h;
+	unsigned int	fc, bc;
+	char			str[ITEM_STR_MAX];
+}	ui_cmd_t;
+
+typedef struct ui_cmd_client__t {
+	struct ui_cmd_srv__t	*srv;
+	int				fd;
+	int				len;
+	char			buf[UI_CMD_BUF_SIZE];
+}	ui_cmd_client_t;
+
+typedef struct ui_cmd_srv__t {
+	struct ui_sched__t	*s;
+	/* unix socket listen fd (FIFO 를 사용하면 -1) */
+	int				lfd;
+	char			path[108];
+	ui_cmd_client_t	client[UI_CMD_CLIENT_MAX];
+	/* 다음 frame 에 처리할 command */
+	int				cnt;
+	ui_cmd_t		batch[UI_CMD_BATCH_MAX];
+	/* 'r' 요청시 생성, frame 마다 비움 (ui_ring.h) */
+	struct ui_ring__t	*ring;
+	unsigned long	cmds, frames, coalesced, errors, ring_cmds;
+}	ui_cmd_srv_t;
+
+//------------------------------------------------------------------------------
+extern	int         ui_cmd_parse    (const char *line, ui_cmd_t *cmd);
+extern	int         ui_cmd_exec     (fb_info_t *fb, ui_grp_t *ui_grp, ui_cmd_t *cmd);
+extern	int         ui_cmd_apply    (void *arg);
+extern	void        ui_cmd_close    (ui_cmd_srv_t *srv);
+extern	ui_cmd_srv_t *ui_cmd_init   (struct ui_sched__t *s, const char *path);
+
+//------------------------------------------------------------------------------
+
+#endif  // #define __UI_CMD_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -23,29 +23,138 @@
 
 #include "typedefs.h"
 #include "fblib/fblib.h"
+#include "fblib/fb_layer.h"
+#include "fblib/fb_tile.h"
+#include "fblib/fb_image.h"
 #include "ui_parser.h"
 
+//------------------------------------------------------------------------------
+// Config tokenizer (mmap 된 config 의 1 line 을 가리킴, 전역 상태 없음)
+//------------------------------------------------------------------------------
+typedef struct ui_tok__t {
+   const char  *fname;
+   /* line 시작, 현재 위치, line 끝('\n' 제외) */
+   const char  *s, *p, *e;
+   int         line;
+}  ui_tok_t;
+
+//------------------------------------------------------------------------------
+// Tile 병렬 전체 다시 그리기 (ui_tile)
+//------------------------------------------------------------------------------
+enum eUI_OP {
+   eUI_OP_R = 0,
+   eUI_OP_W,
+   eUI_OP_I,
+   eUI_OP_S,
+};
+
+/*
+   ui_update(-1) 이 순서대로 그리는 item 1개. 그리기 전의 item 상태를 snap 에 복사해 두고
+   각 tile 은 snap 의 복사본으로 그리므로 item 을 변경하지 않음.
+   owner tile(영역의 첫 tile) 에서 그린 후의 상태를 out 에 기록하고 끝난 후 item 에 반영.
+*/
+typedef struct ui_op__t {
+   int         kind, layer, owner;
+   /* tile 분류에 사용하는 영역, string 의 기준 좌표 (image 는 그릴 좌표) */
+   fb_rect_t   area;
+   int         rx, ry;
+   r_item_t    *r_item;
+   void        *item;
+   union {
+      w_item_t w;
+      s_item_t s;
+   }  snap, out;
+}  ui_op_t;
+
+typedef struct ui_tile__t {
+   fb_tile_t   *pool;
+   fb_info_t   *fb;
+   ui_grp_t    *ui_grp;
+   /* 그릴 item 목록 */
+   ui_op_t     *op;
+   int         op_cnt, op_max;
+   /* op 목록 할당 실패 */
+   bool        oom;
+   /* tile 별 op index : bin[bin_s[tile]] ~ bin[bin_s[tile + 1] - 1] (op 순서) */
+   int         *bin, *bin_s, bin_max;
+   /* worker 별 layer 의 view (layer 를 사용하지 않으면 v_cnt = 1) */
+   int         v_cnt;
+   fb_info_t   view[FB_TILE_THREAD_MAX][FB_LAYER_MAX];
+}  ui_tile_t;
+
 //------------------------------------------------------------------------------
 // Function prototype.
 //------------------------------------------------------------------------------
 static   r_item_t    *_ui_find_r_item  (ui_grp_t *ui_grp, int *sid, int fid);
+static   bool        _ui_is_box        (ui_grp_t *ui_grp, int id);
 static   s_item_t    *_ui_find_s_item  (ui_grp_t *ui_grp, int *sid, int fid);
 
 static   int         _my_strlen        (char *str);
+static   fb_info_t   *_ui_fb           (fb_info_t *fb, ui_grp_t *ui_grp, int layer);
 static   int         _ui_str_scale     (int w, int h, int lw, int slen);
 static   void        _ui_str_pos_xy    (r_item_t *r_item, s_item_t *s_item);
-static   void        _ui_clr_str       (fb_info_t *fb, r_item_t *r_item, s_item_t *s_item);
+static   void        _ui_clr_diff      (fb_info_t *fb, s_item_t *s_item, int x, int y, int w, int h);
 static   void        _ui_update_r      (fb_info_t *fb, r_item_t *r_item);
 static   void        _ui_update_s      (fb_info_t *fb, s_item_t *s_item, int x, int y);
+static   int         _ui_w_pos         (w_item_t *w_item, int val, int len);
+static   void        _ui_w_area        (r_item_t *r_item, fb_rect_t *a);
+static   void        _ui_w_bar         (fb_info_t *fb, w_item_t *w_item, fb_rect_t *a, int i);
+static   void        _ui_w_spark_col   (fb_info_t *fb, w_item_t *w_item, fb_rect_t *a,
+                                          int col, int n);
+static   void        _ui_w_spark       (fb_info_t *fb, w_item_t *w_item, fb_rect_t *a);
+static   int         _ui_w_log_fit     (char *str, int w, int scale);
+static   void        _ui_w_log_line    (fb_info_t *fb, w_item_t *w_item, fb_rect_t *a,
+                                          int row, int n);
+static   void        _ui_w_log         (fb_info_t *fb, w_item_t *w_item, fb_rect_t *a);
+static   void        _ui_update_w      (fb_info_t *fb, r_item_t *r_item, w_item_t *w_item);
+static   fb_image_t  *_ui_i_img        (fb_info_t *fb, ui_grp_t *ui_grp, i_item_t *i_item);
+static   void        _ui_i_pos         (fb_info_t *fb, r_item_t *r_item, i_item_t *i_item,
+                                        int *x, int *y);
+static   void        _ui_update_i      (fb_info_t *fb, ui_grp_t *ui_grp, r_item_t *r_item,
+                                        i_item_t *i_item);
 static   void        _ui_update_extra  (fb_info_t *fb, ui_grp_t *ui_grp, int id);
 static   void        _ui_update        (fb_info_t *fb, ui_grp_t *ui_grp, int id);
-static   void        _ui_parser_cmd_C  (char *buf, fb_info_t *fb, ui_grp_t *ui_grp);
-static   void        _ui_parser_cmd_R  (char *buf, fb_info_t *fb, ui_grp_t *ui_grp);
-static   void        _ui_parser_cmd_S  (char *buf, fb_info_t *fb, ui_grp_t *ui_grp);
-static   void        _ui_parser_cmd_G  (char *buf, fb_info_t *fb, ui_grp_t *ui_grp);
+static   ui_op_t     *_ui_tile_op      (ui_tile_t *tl, int kind, int layer, r_item_t *r_item,
+                                          void *item, int rx, int ry);
+static   void        _ui_tile_prep_i   (ui_tile_t *tl, r_item_t *r_item, i_item_t *i_item);
+static   void        _ui_tile_prep_id  (ui_tile_t *tl, int id);
+static   int         _ui_tile_prep     (ui_tile_t *tl);
+static   int         _ui_tile_bin      (ui_tile_t *tl);
+static   void        _ui_tile_draw     (fb_tile_t *t, int worker, int tile, fb_rect_t *r, void *arg);
+static   void        _ui_tile_commit   (ui_tile_t *tl);
+static   int         _ui_update_tile   (fb_info_t *fb, ui_grp_t *ui_grp);
+static   void        _ui_tile_free     (ui_tile_t *tl);
+static   int         _ui_tok_err       (ui_tok_t *tok, const char *msg);
+static   int         _ui_tok_end       (ui_tok_t *tok);
+static   int         _ui_tok_int       (ui_tok_t *tok, int base, int *val);
+static   int         _ui_tok_str       (ui_tok_t *tok, char *str, int size);
+static   int         _ui_tok_cmd       (ui_tok_t *tok);
+static   int         _ui_fp            (int num, int den);
+static   void        _ui_resolve_axis  (const int *pos, const int *len,
+                                          int *o_pos, int *o_len, int cnt, int size);
+static   void        _ui_grid_axis     (int start, int size, int cnt, int margin, int gap,
+                                          int *e_s, int *e_e);
+static   void        _ui_resolve_grid  (fb_info_t *fb, ui_grp_t *ui_grp);
+static   void        _ui_r_item_del    (ui_grp_t *ui_grp, int pos);
+static   int         _ui_parser_cmd_C  (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp);
+static   int         _ui_parser_cmd_R  (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp);
+static   int         _ui_parser_cmd_S  (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp);
+static   int         _ui_parser_cmd_G  (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp);
+static   int         _ui_parser_cmd_Z  (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp);
+static   int         _ui_parser_cmd_W  (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp);
+static   int         _ui_parser_cmd_I  (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp);
+static   int         _ui_parser_cmd_L  (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp);
+static   int         _ui_parser_cmd_P  (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp);
          void        ui_set_str        (fb_info_t *fb, ui_grp_t *ui_grp,
                                  int id, int x, int y, int scale, int font, char *fmt, ...);
+         void        ui_set_value      (fb_info_t *fb, ui_grp_t *ui_grp, int id, int idx, int val);
+         void        ui_log            (fb_info_t *fb, ui_grp_t *ui_grp, int id, char *fmt, ...);
          void        ui_update         (fb_info_t *fb, ui_grp_t *ui_grp, int id);
+         void        ui_resolve        (fb_info_t *fb, ui_grp_t *ui_grp);
+         int         ui_tile           (fb_info_t *fb, ui_grp_t *ui_grp, int threads);
+         int         ui_present        (fb_info_t *fb, ui_grp_t *ui_grp);
+         void        ui_layer_show     (fb_info_t *fb, ui_grp_t *ui_grp, int layer, bool visible);
+         int         ui_check_mode     (fb_info_t *fb, ui_grp_t *ui_grp);
          void        ui_close          (ui_grp_t *ui_grp);
          ui_grp_t    *ui_init          (fb_info_t *fb, const char *cfg_filename);
 
@@ -62,8 +171,13 @@ static   void        _ui_parser_cmd_G  (char *buf, fb_info_t *fb, ui_grp_t *ui_g
    'C' : default config data
    'L' : Line data
    'G' : Rect group data
+   'Z' : layer (이후 item 을 그릴 layer 번호, 0 = 배경)
+   'W' : widget data (progress bar / bar graph / sparkline / log panel)
+   'L' : grid layout (margin, gap 을 가지는 cols x rows 박스 생성)
+   'P' : grid 박스 span (여러 칸을 차지하는 박스)
 
    Rect data x, y, w, h는 fb의 비율값 (0%~100%), 모든 컬러값은 32bits rgb data.
+   비율값은 ui_grp->geom 에 저장되며 fb 크기가 바뀌면 ui_resolve 에서 pixel 값으로 다시 변환.
 
    ui.cfg file 참조
 */
@@ -82,6 +196,15 @@ static r_item_t *_ui_find_r_item (ui_grp_t *ui_grp, int *sid, int fid)
    return NULL;
 }
 
+//------------------------------------------------------------------------------
+static bool _ui_is_box (ui_grp_t *ui_grp, int id)
+{
+   /* id 를 가지는 박스가 없으면 문자열, image 는 화면 좌표 item */
+   int n_rid = 0;
+
+   return _ui_find_r_item (ui_grp, &n_rid, id) != NULL;
+}
+
 //------------------------------------------------------------------------------
 static s_item_t *_ui_find_s_item (ui_grp_t *ui_grp, int *sid, int fid)
 {
@@ -111,6 +234,13 @@ static int _my_strlen(char *str)
    return err ? cnt : 0;
 }
 
+//------------------------------------------------------------------------------
+static fb_info_t *_ui_fb (fb_info_t *fb, ui_grp_t *ui_grp, int layer)
+{
+   /* layer 를 사용하는 경우 item 은 layer surface 에 그리고 ui_present 에서 합성 */
+   return ui_grp->comp ? fb_comp_layer (ui_grp->comp, layer) : fb;
+}
+
 //------------------------------------------------------------------------------
 static int _ui_str_scale (int w, int h, int lw, int slen)
 {
@@ -148,17 +278,25 @@ static void _ui_str_pos_xy (r_item_t *r_item, s_item_t *s_item)
 }
 
 //------------------------------------------------------------------------------
-static void _ui_clr_str (fb_info_t *fb, r_item_t *r_item, s_item_t *s_item)
+static void _ui_clr_diff (fb_info_t *fb, s_item_t *s_item, int x, int y, int w, int h)
 {
-   int color = s_item->fc.uint;
+   /* 이전 문자열 영역 중 새 문자열 영역(x, y, w, h)에 포함되지 않는 부분만 배경색으로 지움 */
+   int o_x = s_item->d_x, o_y = s_item->d_y;
+   int o_w = _my_strlen(s_item->d_str) * FONT_ASCII_WIDTH * s_item->d_scale;
+   int o_h = FONT_HEIGHT * s_item->d_scale;
+   int t, b, color = s_item->d_bc.uint;
+
+   if ((x >= o_x + o_w) || (x + w <= o_x) || (y >= o_y + o_h) || (y + h <= o_y)) {
+      draw_fill_rect (fb, o_x, o_y, o_w, o_h, color);
+      return;
+   }
+   t = (y > o_y)             ? y     : o_y;
+   b = (y + h < o_y + o_h)   ? y + h : o_y + o_h;
 
-   /* 기존 String을 배경색으로 다시 그림(텍스트 지움) */
-   /* string x, y 좌표 연산 */
-   s_item->fc.uint = s_item->bc.uint;
-   _ui_str_pos_xy(r_item, s_item);
-   _ui_update_s (fb, s_item, r_item->x, r_item->y);
-   s_item->fc.uint = color;
-   memset (s_item->str, 0x00, ITEM_STR_MAX);
+   if (o_y < t)            draw_fill_rect (fb, o_x, o_y, o_w, t - o_y, color);
+   if (b < o_y + o_h)      draw_fill_rect (fb, o_x, b,   o_w, o_y + o_h - b, color);
+   if (o_x < x)            draw_fill_rect (fb, o_x, t, x - o_x, b - t, color);
+   if (x + w < o_x + o_w)  draw_fill_rect (fb, x + w, t, o_x + o_w - x - w, b - t, color);
 }
 
 //------------------------------------------------------------------------------
@@ -174,8 +312,271 @@ static void _ui_update_r (fb_info_t *fb, r_item_t *r_item)
 //------------------------------------------------------------------------------
 static void _ui_update_s (fb_info_t *fb, s_item_t *s_item, int x, int y)
 {
-   draw_text (fb, x + s_item->x, y + s_item->y, s_item->fc.uint, s_item->bc.uint,
-               s_item->scale, s_item->str);
+   x += s_item->x;   y += s_item->y;
+
+   set_font (s_item->f_type);
+
+   /*
+      같은 위치, scale, font, 색상으로 그려진 문자열이 있는 경우
+      변경된 glyph만 다시 그리고 남는 영역만 지운다.
+   */
+   if (s_item->d_scale && (s_item->d_scale  == s_item->scale)  &&
+       (s_item->d_x      == x)              && (s_item->d_y    == y)  &&
+       (s_item->d_f_type == s_item->f_type) &&
+       (s_item->d_fc.uint == s_item->fc.uint) && (s_item->d_bc.uint == s_item->bc.uint)) {
+      draw_text_diff (fb, x, y, s_item->fc.uint, s_item->bc.uint, s_item->scale,
+                        s_item->d_str, s_item->str);
+   } else {
+      draw_text (fb, x, y, s_item->fc.uint, s_item->bc.uint, s_item->scale, "%s",
+                        s_item->str);
+      if (s_item->d_scale)
+         _ui_clr_diff (fb, s_item, x, y,
+                        _my_strlen(s_item->str) * FONT_ASCII_WIDTH * s_item->scale,
+                        FONT_HEIGHT * s_item->scale);
+   }
+
+   s_item->d_x      = x;              s_item->d_y    = y;
+   s_item->d_scale  = s_item->scale;  s_item->d_f_type = s_item->f_type;
+   s_item->d_fc     = s_item->fc;     s_item->d_bc   = s_item->bc;
+   memcpy (s_item->d_str, s_item->str, ITEM_STR_MAX);
+}
+
+//------------------------------------------------------------------------------
+static int _ui_w_pos (w_item_t *w_item, int val, int len)
+{
+   /* min ~ max 범위의 값을 0 ~ len pixel 로 변환 */
+   int range = w_item->max - w_item->min;
+
+   if (val < w_item->min)     val = w_item->min;
+   if (val > w_item->max)     val = w_item->max;
+   return range ? (int)((long long)(val - w_item->min) * len / range) : 0;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_w_area (r_item_t *r_item, fb_rect_t *a)
+{
+   /* widget 은 박스의 외곽라인 안쪽에 그림 */
+   a->x = r_item->x + r_item->lw;      a->w = r_item->w - r_item->lw * 2;
+   a->y = r_item->y + r_item->lw;      a->h = r_item->h - r_item->lw * 2;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_w_bar (fb_info_t *fb, w_item_t *w_item, fb_rect_t *a, int i)
+{
+   int len, d_len = w_item->d_len[i];
+
+   if (w_item->type == eWIDGET_PROGRESS) {
+      /* 가로 막대, 이전 길이와 차이나는 부분만 그림 */
+      len = _ui_w_pos (w_item, w_item->val[i], a->w);
+      if (d_len < 0) {
+         draw_fill_rect (fb, a->x,       a->y, len,          a->h, w_item->fc.uint);
+         draw_fill_rect (fb, a->x + len, a->y, a->w - len,   a->h, w_item->bc.uint);
+      }
+      else if (len > d_len)
+         draw_fill_rect (fb, a->x + d_len, a->y, len - d_len, a->h, w_item->fc.uint);
+      else if (len < d_len)
+         draw_fill_rect (fb, a->x + len,   a->y, d_len - len, a->h, w_item->bc.uint);
+   } else {
+      /* 세로 막대 (아래에서 위로), 막대 i 의 가로 영역 */
+      int x = a->x + a->w *  i      / w_item->cnt;
+      int w = a->x + a->w * (i + 1) / w_item->cnt - x;
+      int b = a->y + a->h;
+
+      /* 막대 사이 간격 1 pixel */
+      if (w > 2)
+         w--;
+      len = _ui_w_pos (w_item, w_item->val[i], a->h);
+      if (d_len < 0) {
+         draw_fill_rect (fb, x, b - len, w, len,          w_item->fc.uint);
+         draw_fill_rect (fb, x, a->y,    w, a->h - len,   w_item->bc.uint);
+      }
+      else if (len > d_len)
+         draw_fill_rect (fb, x, b - len,   w, len - d_len, w_item->fc.uint);
+      else if (len < d_len)
+         draw_fill_rect (fb, x, b - d_len, w, d_len - len, w_item->bc.uint);
+   }
+   w_item->d_len[i] = len;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_w_spark_col (fb_info_t *fb, w_item_t *w_item, fb_rect_t *a,
+                              int col, int n)
+{
+   /* n 번째 sample(0 = 가장 오래된 sample)을 col 위치에 이전 sample 과 이어서 그림 */
+   int s = w_item->h_size;
+   int first = (w_item->h_pos - w_item->h_cnt + s) % s;
+   int y  = a->y + a->h - 1 - _ui_w_pos (w_item, w_item->hist[(first + n) % s], a->h - 1);
+   int py = n ? a->y + a->h - 1 -
+               _ui_w_pos (w_item, w_item->hist[(first + n - 1) % s], a->h - 1) : y;
+
+   draw_fill_rect (fb, a->x + col, a->y, 1, a->h, w_item->bc.uint);
+   if (py < y)
+      draw_fill_rect (fb, a->x + col, py, 1, y - py + 1, w_item->fc.uint);
+   else
+      draw_fill_rect (fb, a->x + col, y,  1, py - y + 1, w_item->fc.uint);
+}
+
+//------------------------------------------------------------------------------
+static void _ui_w_spark (fb_info_t *fb, w_item_t *w_item, fb_rect_t *a)
+{
+   int i;
+
+   if ((w_item->hist == NULL) || (a->w <= 0) || (a->h <= 0))
+      return;
+
+   if (w_item->d_cnt < 0) {
+      /* 전체 다시 그림 */
+      draw_fill_rect (fb, a->x, a->y, a->w, a->h, w_item->bc.uint);
+      for (i = 0; i < w_item->h_cnt; i++)
+         _ui_w_spark_col (fb, w_item, a, i, i);
+      w_item->d_cnt = w_item->h_cnt;
+   }
+   else if (w_item->d_cnt < w_item->h_cnt) {
+      if (w_item->d_cnt < a->w) {
+         /* 빈 column 이 남아있으면 새로운 sample 만 추가 */
+         _ui_w_spark_col (fb, w_item, a, w_item->d_cnt, w_item->d_cnt);
+         w_item->d_cnt++;
+      }
+   }
+   else if (w_item->h_cnt == a->w) {
+      /* 가득찬 경우 1 column 왼쪽으로 이동 후 마지막 column 에 새로운 sample 을 그림 */
+      /* 첫 column 은 이전 sample 이 없어졌으므로 다시 그림 */
+      fb_shift_area (fb, a->x, a->y, a->w, a->h, -1);
+      _ui_w_spark_col (fb, w_item, a, 0, 0);
+      _ui_w_spark_col (fb, w_item, a, a->w - 1, a->w - 1);
+   }
+}
+
+//------------------------------------------------------------------------------
+static int _ui_w_log_fit (char *str, int w, int scale)
+{
+   /*
+      폭 w 안에 그려지는 문자열의 byte 수 (한글 3 byte, ASCII 1 byte).
+      잘린 UTF-8 문자는 그리지 않으므로 그 앞에서 끝냄 (_glyph_len 과 같음).
+   */
+   int len = 0, g_len, g_w;
+
+   while (str[len]) {
+      if (str[len] & 0x80) {
+         if (!str[len + 1] || !str[len + 2])
+            break;
+         g_len = 3;  g_w = FONT_HANGUL_WIDTH * scale;
+      } else {
+         g_len = 1;  g_w = FONT_ASCII_WIDTH  * scale;
+      }
+      if ((w -= g_w) < 0)
+         break;
+      len += g_len;
+   }
+   return len;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_w_log_line (fb_info_t *fb, w_item_t *w_item, fb_rect_t *a,
+                              int row, int n)
+{
+   /* n 번째 line(0 = 가장 오래된 line)을 row 위치에 그림 */
+   int lh = FONT_HEIGHT * w_item->cnt, len;
+   char *str = w_item->log[(w_item->h_pos - w_item->h_cnt + n + w_item->h_size) % w_item->h_size];
+
+   draw_fill_rect (fb, a->x, a->y + row * lh, a->w, lh, w_item->bc.uint);
+   if ((len = _ui_w_log_fit (str, a->w, w_item->cnt)) > 0) {
+      set_font (w_item->f_type);
+      draw_text (fb, a->x, a->y + row * lh, w_item->fc.uint, w_item->bc.uint,
+                  w_item->cnt, "%.*s", len, str);
+   }
+}
+
+//------------------------------------------------------------------------------
+static void _ui_w_log (fb_info_t *fb, w_item_t *w_item, fb_rect_t *a)
+{
+   int lh = FONT_HEIGHT * w_item->cnt, rows, i, first;
+
+   if ((w_item->log == NULL) || (a->w <= 0) || ((rows = a->h / lh) <= 0))
+      return;
+   if (rows > w_item->h_size)
+      rows = w_item->h_size;
+
+   if (w_item->d_cnt < 0) {
+      /* 전체 다시 그림, 마지막 rows 개의 line 만 표시 */
+      draw_fill_rect (fb, a->x, a->y, a->w, a->h, w_item->bc.uint);
+      first = (w_item->h_cnt > rows) ? w_item->h_cnt - rows : 0;
+      for (i = first; i < w_item->h_cnt; i++)
+         _ui_w_log_line (fb, w_item, a, i - first, i);
+      w_item->d_cnt = w_item->h_cnt - first;
+   }
+   else if (w_item->d_cnt < rows) {
+      /* 빈 line 이 남아있으면 새로운 line 만 추가 */
+      _ui_w_log_line (fb, w_item, a, w_item->d_cnt, w_item->h_cnt - 1);
+      w_item->d_cnt++;
+   }
+   else {
+      /* 가득찬 경우 1 line 위로 이동 후 마지막 line 에 새로운 line 을 그림 */
+      fb_scroll_area (fb, a->x, a->y, a->w, rows * lh, -lh);
+      _ui_w_log_line (fb, w_item, a, rows - 1, w_item->h_cnt - 1);
+   }
+}
+
+//------------------------------------------------------------------------------
+static void _ui_update_w (fb_info_t *fb, r_item_t *r_item, w_item_t *w_item)
+{
+   fb_rect_t a;
+   int i;
+
+   if ((signed)w_item->bc.uint < 0)
+      w_item->bc.uint = r_item->bc.uint;
+
+   _ui_w_area (r_item, &a);
+   if (w_item->type == eWIDGET_SPARK)
+      _ui_w_spark (fb, w_item, &a);
+   else if (w_item->type == eWIDGET_LOG)
+      _ui_w_log   (fb, w_item, &a);
+   else
+      for (i = 0; i < w_item->cnt; i++)
+         _ui_w_bar (fb, w_item, &a, i);
+}
+
+//------------------------------------------------------------------------------
+static fb_image_t *_ui_i_img (fb_info_t *fb, ui_grp_t *ui_grp, i_item_t *i_item)
+{
+   /*
+      그릴 surface 와 형식이 다르면 (32bpp layer surface, 화면 모드 변경) cache 에서 다시 읽음.
+      같은 형식으로 이미 읽은 image 가 있으면 변환 없이 공유.
+      읽지 못한 경우 frame 마다 다시 읽지 않도록 ui_resolve 전까지 실패를 기억.
+   */
+   fb_info_t *l_fb = _ui_fb (fb, ui_grp, i_item->layer);
+
+   if (i_item->img && !fb_image_match (l_fb, i_item->img)) {
+      fb_image_put (i_item->img);
+      i_item->img = NULL;
+   }
+   if ((i_item->img == NULL) && !i_item->fail)
+      i_item->fail = ((i_item->img = fb_image_load (l_fb, i_item->path)) == NULL);
+   return i_item->img;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_i_pos (fb_info_t *fb, r_item_t *r_item, i_item_t *i_item, int *x, int *y)
+{
+   /* 박스(박스가 없으면 화면) 기준 좌표, -1 이면 중앙 */
+   int bx = r_item ? r_item->x : 0, bw = r_item ? r_item->w : fb->w;
+   int by = r_item ? r_item->y : 0, bh = r_item ? r_item->h : fb->h;
+
+   *x = bx + ((i_item->x < 0) ? (bw - i_item->img->w) / 2 : i_item->x);
+   *y = by + ((i_item->y < 0) ? (bh - i_item->img->h) / 2 : i_item->y);
+}
+
+//------------------------------------------------------------------------------
+static void _ui_update_i (fb_info_t *fb, ui_grp_t *ui_grp, r_item_t *r_item, i_item_t *i_item)
+{
+   int x, y;
+
+   if (_ui_i_img (fb, ui_grp, i_item) == NULL)
+      return;
+
+   fb = _ui_fb (fb, ui_grp, i_item->layer);
+   _ui_i_pos (fb, r_item, i_item, &x, &y);
+   fb_image_draw (fb, i_item->img, x, y);
 }
 
 //------------------------------------------------------------------------------
@@ -185,25 +586,50 @@ static void _ui_update_extra (fb_info_t *fb, ui_grp_t *ui_grp, int id)
    int i;
    for (i = 0; i < ui_grp->r_cnt; i++)
       if (id == ui_grp->r_item[i].id)
-         _ui_update_r (fb, &ui_grp->r_item[i]);
+         _ui_update_r (_ui_fb (fb, ui_grp, ui_grp->r_item[i].layer), &ui_grp->r_item[i]);
+
+   for (i = 0; i < ui_grp->i_cnt; i++)
+      if (id == ui_grp->i_item[i].r_id)
+         _ui_update_i (fb, ui_grp, NULL, &ui_grp->i_item[i]);
 
    for (i = 0; i < ui_grp->s_cnt; i++)
       if (id == ui_grp->s_item[i].r_id)
-         _ui_update_s (fb, &ui_grp->s_item[i], 0, 0);
+         ui_grp->s_item[i].d_scale = 0;
+
+   for (i = 0; i < ui_grp->s_cnt; i++)
+      if (id == ui_grp->s_item[i].r_id)
+         _ui_update_s (_ui_fb (fb, ui_grp, ui_grp->s_item[i].layer),
+                        &ui_grp->s_item[i], 0, 0);
 }
 
 //------------------------------------------------------------------------------
 static void _ui_update (fb_info_t *fb, ui_grp_t *ui_grp, int id)
 {
-   int n_rid = 0, n_sid = 0;
+   int n_rid = 0, n_sid = 0, i;
 
    r_item_t *r_item;
    s_item_t *s_item;
 
-   if (id < ITEM_COUNT_MAX) {
+   if (_ui_is_box (ui_grp, id)) {
       while ((r_item = _ui_find_r_item(ui_grp, &n_rid, id)) != NULL) {
 
-         _ui_update_r (fb, r_item);
+         _ui_update_r (_ui_fb (fb, ui_grp, r_item->layer), r_item);
+
+         /* 박스를 다시 그렸으므로 widget 도 전체 다시 그림 */
+         for (i = 0; i < ui_grp->w_cnt; i++) {
+            w_item_t *w_item = &ui_grp->w_item[i];
+
+            if (w_item->r_id == id) {
+               memset (w_item->d_len, 0xFF, sizeof(w_item->d_len));
+               w_item->d_cnt = -1;
+               _ui_update_w (_ui_fb (fb, ui_grp, w_item->layer), r_item, w_item);
+            }
+         }
+
+         /* image 는 박스 위, 문자열 아래 */
+         for (i = 0; i < ui_grp->i_cnt; i++)
+            if (ui_grp->i_item[i].r_id == id)
+               _ui_update_i (fb, ui_grp, r_item, &ui_grp->i_item[i]);
 
          n_sid = 0;
          while ((s_item = _ui_find_s_item(ui_grp, &n_sid, id)) != NULL) {
@@ -218,8 +644,11 @@ static void _ui_update (fb_info_t *fb, ui_grp_t *ui_grp, int id)
             if (s_item->scale < 0)
                s_item->scale = _ui_str_scale (r_item->w, r_item->h, r_item->lw,
                                              _my_strlen(s_item->str));
+            /* 박스를 다시 그렸으므로 이전 문자열은 지워진 상태 */
+            s_item->d_scale = 0;
             _ui_str_pos_xy(r_item, s_item);
-            _ui_update_s (fb, s_item, r_item->x, r_item->y);
+            _ui_update_s (_ui_fb (fb, ui_grp, s_item->layer), s_item,
+                          r_item->x, r_item->y);
          }
       }
    }
@@ -228,132 +657,864 @@ static void _ui_update (fb_info_t *fb, ui_grp_t *ui_grp, int id)
 }
 
 //------------------------------------------------------------------------------
-static void _ui_parser_cmd_C (char *buf, fb_info_t *fb, ui_grp_t *ui_grp)
+static ui_op_t *_ui_tile_op (ui_tile_t *tl, int kind, int layer, r_item_t *r_item,
+                              void *item, int rx, int ry)
 {
-   char *ptr = strtok (buf, ",");
+   ui_op_t *op;
 
-   ptr = strtok (NULL, ",");     fb->is_bgr        = (atoi(ptr) != 0) ? 1: 0;
-   ptr = strtok (NULL, ",");     ui_grp->fc.uint   = strtol(ptr, NULL, 16);
-   ptr = strtok (NULL, ",");     ui_grp->bc.uint   = strtol(ptr, NULL, 16);
-   ptr = strtok (NULL, ",");     ui_grp->lc.uint   = strtol(ptr, NULL, 16);
-   ptr = strtok (NULL, ",");     ui_grp->f_type    = atoi(ptr);
+   if (tl->op_cnt >= tl->op_max) {
+      int max = tl->op_max ? tl->op_max * 2 : ITEM_COUNT_MAX * 2;
 
-   set_font(ui_grp->f_type);
+      if ((op = (ui_op_t *)realloc (tl->op, sizeof(ui_op_t) * max)) == NULL) {
+         tl->oom = true;
+         return NULL;
+      }
+      tl->op = op;   tl->op_max = max;
+   }
+   op = &tl->op[tl->op_cnt++];
+   op->kind   = kind;
+   op->layer  = tl->ui_grp->comp ? layer : 0;
+   op->owner  = -1;
+   op->r_item = r_item;
+   op->item   = item;
+   op->rx     = rx;     op->ry = ry;
+   op->area.x = r_item ? r_item->x : 0;   op->area.w = r_item ? r_item->w : 0;
+   op->area.y = r_item ? r_item->y : 0;   op->area.h = r_item ? r_item->h : 0;
+   if (kind == eUI_OP_W)
+      memcpy (&op->snap.w, item, sizeof(w_item_t));
+   if (kind == eUI_OP_I) {
+      fb_image_t *img = ((i_item_t *)item)->img;
+
+      op->area.x = rx;        op->area.y = ry;
+      op->area.w = img->w;    op->area.h = img->h;
+   }
+   if (kind == eUI_OP_S) {
+      s_item_t *s_item = (s_item_t *)item;
+
+      memcpy (&op->snap.s, s_item, sizeof(s_item_t));
+      op->area.x = rx + s_item->x;
+      op->area.y = ry + s_item->y;
+      op->area.w = _my_strlen(s_item->str) * FONT_ASCII_WIDTH * s_item->scale;
+      op->area.h = FONT_HEIGHT * s_item->scale;
+   }
+   return op;
 }
 
 //------------------------------------------------------------------------------
-static void _ui_parser_cmd_R (char *buf, fb_info_t *fb, ui_grp_t *ui_grp)
+/*
+   _ui_update(id) 와 같은 순서로 op 를 만들고 그리기 전에 변경되는 item 상태를 미리 반영.
+*/
+static void _ui_tile_prep_i (ui_tile_t *tl, r_item_t *r_item, i_item_t *i_item)
 {
-   int r_cnt = ui_grp->r_cnt;
-   char *ptr = strtok (buf, ",");
+   /* image 읽기(형식 변환)는 여기서 하고 tile 에서는 복사만 함 */
+   fb_info_t *l_fb = _ui_fb (tl->fb, tl->ui_grp, i_item->layer);
+   int x, y;
+
+   if (_ui_i_img (tl->fb, tl->ui_grp, i_item) == NULL)
+      return;
+   _ui_i_pos (l_fb, r_item, i_item, &x, &y);
+   _ui_tile_op (tl, eUI_OP_I, i_item->layer, NULL, i_item, x, y);
+}
+
+//------------------------------------------------------------------------------
+static void _ui_tile_prep_id (ui_tile_t *tl, int id)
+{
+   ui_grp_t *ui_grp = tl->ui_grp;
+   int n_rid = 0, n_sid, i;
+   r_item_t *r_item;
+   s_item_t *s_item;
+
+   if (!_ui_is_box (ui_grp, id)) {
+      /* _ui_update_extra */
+      for (i = 0; i < ui_grp->r_cnt; i++)
+         if (id == ui_grp->r_item[i].id)
+            _ui_tile_op (tl, eUI_OP_R, ui_grp->r_item[i].layer, &ui_grp->r_item[i],
+                           NULL, 0, 0);
+      for (i = 0; i < ui_grp->i_cnt; i++)
+         if (id == ui_grp->i_item[i].r_id)
+            _ui_tile_prep_i (tl, NULL, &ui_grp->i_item[i]);
+      for (i = 0; i < ui_grp->s_cnt; i++) {
+         if (id == ui_grp->s_item[i].r_id) {
+            ui_grp->s_item[i].d_scale = 0;
+            _ui_tile_op (tl, eUI_OP_S, ui_grp->s_item[i].layer, NULL,
+                           &ui_grp->s_item[i], 0, 0);
+         }
+      }
+      return;
+   }
+
+   while ((r_item = _ui_find_r_item(ui_grp, &n_rid, id)) != NULL) {
+      _ui_tile_op (tl, eUI_OP_R, r_item->layer, r_item, NULL, 0, 0);
+
+      for (i = 0; i < ui_grp->w_cnt; i++) {
+         w_item_t *w_item = &ui_grp->w_item[i];
+
+         if (w_item->r_id == id) {
+            memset (w_item->d_len, 0xFF, sizeof(w_item->d_len));
+            w_item->d_cnt = -1;
+            if ((signed)w_item->bc.uint < 0)
+               w_item->bc.uint = r_item->bc.uint;
+            _ui_tile_op (tl, eUI_OP_W, w_item->layer, r_item, w_item, 0, 0);
+         }
+      }
+      for (i = 0; i < ui_grp->i_cnt; i++)
+         if (ui_grp->i_item[i].r_id == id)
+            _ui_tile_prep_i (tl, r_item, &ui_grp->i_item[i]);
+
+      n_sid = 0;
+      while ((s_item = _ui_find_s_item(ui_grp, &n_sid, id)) != NULL) {
+         if (s_item->f_type < 0)
+            s_item->f_type = ui_grp->f_type;
+         if ((signed)s_item->bc.uint < 0)
+            s_item->bc.uint = r_item->bc.uint;
+         if (s_item->scale < 0)
+            s_item->scale = _ui_str_scale (r_item->w, r_item->h, r_item->lw,
+                                          _my_strlen(s_item->str));
+         s_item->d_scale = 0;
+         _ui_str_pos_xy(r_item, s_item);
+         _ui_tile_op (tl, eUI_OP_S, s_item->layer, NULL, s_item, r_item->x, r_item->y);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+static int _ui_tile_prep (ui_tile_t *tl)
+{
+   ui_grp_t *ui_grp = tl->ui_grp;
+   int i, j;
+
+   /* ui_update(-1) 과 같은 순서 (같은 id 는 1번만, 박스에 속하지 않은 image, 문자열은 마지막) */
+   tl->op_cnt = 0;   tl->oom = false;
+   for (i = 0; i < ui_grp->r_cnt; i++) {
+      int id = ui_grp->r_item[i].id;
+
+      for (j = 0; (j < i) && (ui_grp->r_item[j].id != id); j++)
+         ;
+      if (j == i)
+         _ui_tile_prep_id (tl, id);
+   }
+   for (i = 0; i < ui_grp->i_cnt; i++)
+      if (!_ui_is_box (ui_grp, ui_grp->i_item[i].r_id))
+         _ui_tile_prep_i (tl, NULL, &ui_grp->i_item[i]);
+   for (i = 0; i < ui_grp->s_cnt; i++) {
+      if (!_ui_is_box (ui_grp, ui_grp->s_item[i].r_id)) {
+         ui_grp->s_item[i].d_scale = 0;
+         _ui_tile_op (tl, eUI_OP_S, ui_grp->s_item[i].layer, NULL, &ui_grp->s_item[i], 0, 0);
+      }
+   }
+   return tl->oom ? -1 : 0;
+}
+
+//------------------------------------------------------------------------------
+/*
+   op 영역이 걸치는 tile 마다 op index 를 순서대로 기록 (tile 에서도 ui_update 순서로 그림).
+*/
+static int _ui_tile_bin (ui_tile_t *tl)
+{
+   fb_tile_t *t = tl->pool;
+   int i, tx, ty, cnt = 0, *pos;
+
+   if ((tl->bin_s = (int *)realloc (tl->bin_s, sizeof(int) * (t->cnt + 1))) == NULL)
+      return -1;
+   memset (tl->bin_s, 0x00, sizeof(int) * (t->cnt + 1));
+
+   /* op 의 tile 범위를 area 에 (tile 좌표로) 기록 */
+   for (i = 0; i < tl->op_cnt; i++) {
+      fb_rect_t *a = &tl->op[i].area;
+      int x0 = a->x, y0 = a->y, x1 = a->x + a->w, y1 = a->y + a->h;
+
+      if (x0 < 0)    x0 = 0;
+      if (y0 < 0)    y0 = 0;
+      if (x1 > t->w) x1 = t->w;
+      if (y1 > t->h) y1 = t->h;
+      if ((x1 <= x0) || (y1 <= y0)) {
+         a->w = 0;   a->h = 0;
+         continue;
+      }
+      a->x = x0 / t->tile_w;                 a->y = y0 / t->tile_h;
+      a->w = (x1 - 1) / t->tile_w - a->x + 1;  a->h = (y1 - 1) / t->tile_h - a->y + 1;
+      tl->op[i].owner = a->y * t->cols + a->x;
+
+      for (ty = a->y; ty < a->y + a->h; ty++)
+         for (tx = a->x; tx < a->x + a->w; tx++)
+            tl->bin_s[ty * t->cols + tx + 1]++;
+      cnt += a->w * a->h;
+   }
+   for (i = 0; i < t->cnt; i++)
+      tl->bin_s[i + 1] += tl->bin_s[i];
+
+   if (cnt > tl->bin_max) {
+      if ((pos = (int *)realloc (tl->bin, sizeof(int) * cnt)) == NULL)
+         return -1;
+      tl->bin = pos;    tl->bin_max = cnt;
+   }
+   if ((pos = (int *)malloc (sizeof(int) * (t->cnt + 1))) == NULL)
+      return -1;
+   memcpy (pos, tl->bin_s, sizeof(int) * (t->cnt + 1));
+
+   for (i = 0; i < tl->op_cnt; i++) {
+      fb_rect_t *a = &tl->op[i].area;
+
+      for (ty = a->y; ty < a->y + a->h; ty++)
+         for (tx = a->x; tx < a->x + a->w; tx++)
+            tl->bin[pos[ty * t->cols + tx]++] = i;
+   }
+   free (pos);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_tile_draw (fb_tile_t *t, int worker, int tile, fb_rect_t *r, void *arg)
+{
+   /* fb_tile worker 에서 호출, tile 영역(clip) 안에만 그림 */
+   ui_tile_t *tl = (ui_tile_t *)arg;
+   fb_info_t *view = tl->view[worker];
+   w_item_t w_item;
+   s_item_t s_item;
+   int i;
+
+   (void)t;
+   for (i = 0; i < tl->v_cnt; i++)
+      view[i].clip = *r;
+
+   for (i = tl->bin_s[tile]; i < tl->bin_s[tile + 1]; i++) {
+      ui_op_t *op = &tl->op[tl->bin[i]];
+
+      switch (op->kind) {
+         case  eUI_OP_R:
+            _ui_update_r (&view[op->layer], op->r_item);
+         break;
+         case  eUI_OP_W:
+            memcpy (&w_item, &op->snap.w, sizeof(w_item_t));
+            _ui_update_w (&view[op->layer], op->r_item, &w_item);
+            if (op->owner == tile)
+               memcpy (&op->out.w, &w_item, sizeof(w_item_t));
+         break;
+         case  eUI_OP_I:
+            fb_image_draw (&view[op->layer], ((i_item_t *)op->item)->img, op->rx, op->ry);
+         break;
+         case  eUI_OP_S:
+            memcpy (&s_item, &op->snap.s, sizeof(s_item_t));
+            _ui_update_s (&view[op->layer], &s_item, op->rx, op->ry);
+            if (op->owner == tile)
+               memcpy (&op->out.s, &s_item, sizeof(s_item_t));
+         break;
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+static void _ui_tile_commit (ui_tile_t *tl)
+{
+   fb_info_t *fb = tl->fb;
+   ui_grp_t *ui_grp = tl->ui_grp;
+   int i;
+
+   for (i = 0; i < tl->op_cnt; i++) {
+      ui_op_t *op = &tl->op[i];
+
+      /* 박스, image 는 변경되는 상태가 없음 */
+      if ((op->kind == eUI_OP_R) || (op->kind == eUI_OP_I))
+         continue;
+      if (op->owner >= 0) {
+         memcpy (op->item, &op->out,
+                  (op->kind == eUI_OP_W) ? sizeof(w_item_t) : sizeof(s_item_t));
+         continue;
+      }
+      /* 화면 밖의 item 은 그려지는 pixel 이 없으므로 snap 으로 상태만 갱신 */
+      if (op->kind == eUI_OP_W) {
+         w_item_t *w_item = (w_item_t *)op->item;
+         memcpy (w_item, &op->snap.w, sizeof(w_item_t));
+         _ui_update_w (_ui_fb (fb, ui_grp, w_item->layer), op->r_item, w_item);
+      } else {
+         s_item_t *s_item = (s_item_t *)op->item;
+         memcpy (s_item, &op->snap.s, sizeof(s_item_t));
+         _ui_update_s (_ui_fb (fb, ui_grp, s_item->layer), s_item, op->rx, op->ry);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+/*
+   전체 다시 그리기를 tile 별로 나누어 그림. 결과는 ui_update(-1) 과 같음.
+   return : 0, -1 = 메모리 부족 (호출한 쪽에서 기존 방식으로 그림)
+*/
+static int _ui_update_tile (fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   ui_tile_t *tl = ui_grp->tile;
+   int i, l;
+
+   /* 화면 모드가 변경된 경우 tile 을 다시 나눔 */
+   if ((tl->pool->w != fb->w) || (tl->pool->h != fb->h)) {
+      fb_tile_t *pool = fb_tile_init (fb->w, fb->h, tl->pool->threads);
+
+      if (pool == NULL)
+         return -1;
+      fb_tile_close (tl->pool);
+      tl->pool = pool;
+   }
+   tl->fb = fb;   tl->ui_grp = ui_grp;
+
+   if (_ui_tile_prep (tl) || _ui_tile_bin (tl))
+      return -1;
+
+   tl->v_cnt = ui_grp->comp ? ui_grp->l_cnt : 1;
+   for (i = 0; i < tl->pool->threads; i++)
+      for (l = 0; l < tl->v_cnt; l++)
+         fb_tile_view (&tl->view[i][l], _ui_fb (fb, ui_grp, l));
+
+   fb_tile_run (tl->pool, _ui_tile_draw, tl);
+
+   for (i = 0; i < tl->pool->threads; i++)
+      for (l = 0; l < tl->v_cnt; l++)
+         fb_tile_merge (_ui_fb (fb, ui_grp, l), &tl->view[i][l]);
+   _ui_tile_commit (tl);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_tile_free (ui_tile_t *tl)
+{
+   if (tl) {
+      fb_tile_close (tl->pool);
+      free (tl->op);
+      free (tl->bin);
+      free (tl->bin_s);
+      free (tl);
+   }
+}
 
-   ptr = strtok (NULL, ",");     ui_grp->r_item[r_cnt].id   = atoi(ptr);
-   ptr = strtok (NULL, ",");     ui_grp->r_item[r_cnt].x    = atoi(ptr);
-   ptr = strtok (NULL, ",");     ui_grp->r_item[r_cnt].y    = atoi(ptr);
-   ptr = strtok (NULL, ",");     ui_grp->r_item[r_cnt].w    = atoi(ptr);
-   ptr = strtok (NULL, ",");     ui_grp->r_item[r_cnt].h    = atoi(ptr);
-   ptr = strtok (NULL, ",");
+//------------------------------------------------------------------------------
+static int _ui_tok_err (ui_tok_t *tok, const char *msg)
+{
+   err("%s:%d:%d: %s\n", tok->fname, tok->line, (int)(tok->p - tok->s) + 1, msg);
+   return -1;
+}
+
+//------------------------------------------------------------------------------
+static int _ui_tok_end (ui_tok_t *tok)
+{
+   /* field 뒤의 공백을 건너뛰고 ',' 또는 line 끝이어야 함 */
+   while ((tok->p < tok->e) && ((*tok->p == ' ') || (*tok->p == '\t')))
+      tok->p++;
+
+   if (tok->p < tok->e) {
+      if (*tok->p != ',')
+         return _ui_tok_err (tok, "',' expected");
+      tok->p++;
+   }
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+static int _ui_tok_int (ui_tok_t *tok, int base, int *val)
+{
+   unsigned int v = 0, max;
+   int neg = 0, digits = 0, d;
+
+   while ((tok->p < tok->e) && ((*tok->p == ' ') || (*tok->p == '\t')))
+      tok->p++;
+
+   if (tok->p >= tok->e)
+      return _ui_tok_err (tok, "missing field");
 
-   ui_grp->r_item[r_cnt].bc.uint  = strtol(ptr, NULL, 16);
-   ptr = strtok (NULL, ",");     ui_grp->r_item[r_cnt].lw   = atoi(ptr);
+   if ((*tok->p == '-') || (*tok->p == '+'))
+      neg = (*tok->p++ == '-');
 
-   ptr = strtok (NULL, ",");
-   ui_grp->r_item[r_cnt].lc.uint = strtol(ptr, NULL, 16);
+   /* 이전 설정 파일과 같이 16진수 앞의 0x, 0X 는 허용 */
+   if ((base == 16) && (tok->e - tok->p > 1) && (tok->p[0] == '0') &&
+       ((tok->p[1] == 'x') || (tok->p[1] == 'X')))
+      tok->p += 2;
 
-   ui_grp->r_item[r_cnt].x = (ui_grp->r_item[r_cnt].x * fb->w / 100);
-   ui_grp->r_item[r_cnt].y = (ui_grp->r_item[r_cnt].y * fb->h / 100);
-   ui_grp->r_item[r_cnt].w = (ui_grp->r_item[r_cnt].w * fb->w / 100);
-   ui_grp->r_item[r_cnt].h = (ui_grp->r_item[r_cnt].h * fb->h / 100);
+   /* 16진수(색)는 32bit 전체, 10진수는 int 범위 */
+   max = (base == 16) ? UINT_MAX : (neg ? (unsigned int)INT_MAX + 1 : INT_MAX);
+   for (; tok->p < tok->e; tok->p++, digits++) {
+      char c = *tok->p;
 
-   if ((signed)ui_grp->r_item[r_cnt].bc.uint < 0)
-      ui_grp->r_item[r_cnt].bc.uint = ui_grp->bc.uint;
+      if      ((c >= '0') && (c <= '9'))   d = c - '0';
+      else if ((c >= 'a') && (c <= 'f'))   d = c - 'a' + 10;
+      else if ((c >= 'A') && (c <= 'F'))   d = c - 'A' + 10;
+      else                                 break;
+      if (d >= base)
+         break;
+      if (v > (max - d) / base)
+         return _ui_tok_err (tok, "number out of range");
+      v = v * base + d;
+   }
+   if (!digits)
+      return _ui_tok_err (tok, (base == 16) ? "hex number expected" : "number expected");
 
-   if ((signed)ui_grp->r_item[r_cnt].lc.uint < 0)
-      ui_grp->r_item[r_cnt].lc.uint = ui_grp->lc.uint;
+   *val = neg ? (int)(0u - v) : (int)v;
+   return _ui_tok_end (tok);
+}
 
-   r_cnt++;
-   ui_grp->r_cnt = r_cnt;
+//------------------------------------------------------------------------------
+static int _ui_tok_str (ui_tok_t *tok, char *str, int size)
+{
+   const char *s;
+   int len;
+
+   /* 문자열 앞부분의 공백은 제거, 다음 ',' 전까지 복사 */
+   while ((tok->p < tok->e) && (*tok->p == ' '))
+      tok->p++;
+
+   for (s = tok->p; (tok->p < tok->e) && (*tok->p != ','); tok->p++)
+      ;
+   len = tok->p - s;
+   if (len > size - 1)
+      len = size - 1;
+   memcpy (str, s, len);
+   str[len] = 0x00;
+
+   if (tok->p < tok->e)
+      tok->p++;
+   return 0;
 }
 
 //------------------------------------------------------------------------------
-static void _ui_parser_cmd_S (char *buf, fb_info_t *fb, ui_grp_t *ui_grp)
+static int _ui_tok_cmd (ui_tok_t *tok)
 {
-   int s_cnt = ui_grp->s_cnt;
-   char *ptr = strtok (buf, ",");
+   /* command 문자 다음의 첫번째 ',' 까지 건너뜀 */
+   while ((tok->p < tok->e) && (*tok->p != ','))
+      tok->p++;
+
+   if (tok->p >= tok->e)
+      return _ui_tok_err (tok, "',' expected");
+   tok->p++;
+   return 0;
+}
 
-   ptr = strtok (NULL, ",");     ui_grp->s_item[s_cnt].r_id    = atoi(ptr);
-   ptr = strtok (NULL, ",");     ui_grp->s_item[s_cnt].x       = atoi(ptr);
-   ptr = strtok (NULL, ",");     ui_grp->s_item[s_cnt].y       = atoi(ptr);
-   ptr = strtok (NULL, ",");     ui_grp->s_item[s_cnt].scale   = atoi(ptr);
+//------------------------------------------------------------------------------
+static int _ui_fp (int num, int den)
+{
+   /* num/den 비율을 fixed point 로 변환 (올림하여 pixel 변환시 내림 오차가 없도록 함) */
+   long long v = (long long)num << UI_FP_SHIFT;
 
-   ptr = strtok (NULL, ",");
-   ui_grp->s_item[s_cnt].fc.uint = strtoul(ptr, NULL, 16);
-   ptr = strtok (NULL, ",");
-   ui_grp->s_item[s_cnt].bc.uint = strtoul(ptr, NULL, 16);
+   return (int)((v >= 0) ? (v + den - 1) / den : v / den);
+}
 
-   if ((signed)ui_grp->s_item[s_cnt].fc.uint < 0)
-      ui_grp->s_item[s_cnt].fc.uint = ui_grp->fc.uint;
+//------------------------------------------------------------------------------
+static void _ui_resolve_axis (const int *pos, const int *len,
+                              int *o_pos, int *o_len, int cnt, int size)
+{
+   int i;
 
-   /* 문자열이 없거나 앞부분의 공백이 있는 경우 제거 */
-   if ((ptr = strtok (NULL, ",")) != NULL) {
-      int slen = strlen(ptr);
+   /*
+      시작/끝 경계를 각각 pixel 로 변환하여 이웃한 박스 사이에 틈이 생기지 않도록 함.
+      분기 없는 배열 연산이므로 compiler 에서 vector 화 됨.
+   */
+   for (i = 0; i < cnt; i++) {
+      int s = (int)(((long long)size * pos[i])            >> UI_FP_SHIFT);
+      int e = (int)(((long long)size * (pos[i] + len[i])) >> UI_FP_SHIFT);
 
-      while ((*ptr == 0x20) && slen--)
-         ptr++;
-      strncpy(ui_grp->s_item[s_cnt].str, ptr, slen);
+      o_pos[i] = s;
+      o_len[i] = e - s;
    }
-   ptr = strtok (NULL, ",");     ui_grp->s_item[s_cnt].f_type = atoi(ptr);
+}
 
-   if (ui_grp->s_item[s_cnt].r_id >= ITEM_COUNT_MAX) {
-      if (ui_grp->s_item[s_cnt].x < 0)          ui_grp->s_item[s_cnt].x = 0;
-      if (ui_grp->s_item[s_cnt].y < 0)          ui_grp->s_item[s_cnt].y = 0;
-      if (ui_grp->s_item[s_cnt].scale   < 0)    ui_grp->s_item[s_cnt].scale = 1;
+//------------------------------------------------------------------------------
+static void _ui_grid_axis (int start, int size, int cnt, int margin, int gap,
+                           int *e_s, int *e_e)
+{
+   /* margin, gap 을 뺀 나머지를 cnt 등분, 남는 pixel 은 앞쪽 칸부터 1 pixel 씩 배분 */
+   int avail = size - margin * 2 - gap * (cnt - 1);
+   int base, rem, i, pos = start + margin;
+
+   if (avail < 0)
+      avail = 0;
+   base = avail / cnt;   rem = avail % cnt;
+
+   for (i = 0; i < cnt; i++) {
+      e_s[i] = pos;
+      e_e[i] = pos + base + (i < rem ? 1 : 0);
+      pos    = e_e[i] + gap;
+   }
+}
 
-      if (ui_grp->s_item[s_cnt].f_type  < 0)
-         ui_grp->s_item[s_cnt].f_type  = ui_grp->f_type;
-      if (ui_grp->s_item[s_cnt].fc.uint < 0)
-         ui_grp->s_item[s_cnt].fc.uint = ui_grp->fc.uint;
-      if (ui_grp->s_item[s_cnt].bc.uint < 0)
-         ui_grp->s_item[s_cnt].bc.uint = ui_grp->bc.uint;
+//------------------------------------------------------------------------------
+static void _ui_resolve_grid (fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   ui_geom_t *g = &ui_grp->geom;
+   int xs[ITEM_RECT_MAX], xe[ITEM_RECT_MAX], ys[ITEM_RECT_MAX], ye[ITEM_RECT_MAX];
+   int n, i, gx, gy, gw, gh;
+
+   /* grid 별로 칸 경계를 한번만 계산하여 속한 박스의 pixel 좌표에 반영 */
+   for (n = 0; n < ui_grp->g_cnt; n++) {
+      ui_grid_t *grid = &ui_grp->grid[n];
+
+      _ui_resolve_axis (&grid->x, &grid->w, &gx, &gw, 1, fb->w);
+      _ui_resolve_axis (&grid->y, &grid->h, &gy, &gh, 1, fb->h);
+      _ui_grid_axis (gx, gw, grid->cols, grid->margin, grid->gap_x, xs, xe);
+      _ui_grid_axis (gy, gh, grid->rows, grid->margin, grid->gap_y, ys, ye);
+
+      for (i = 0; i < ui_grp->r_cnt; i++) {
+         if (g->grid[i] != n + 1)
+            continue;
+         g->px[i] = xs[g->col[i]];  g->pw[i] = xe[g->col[i] + g->c_span[i] - 1] - g->px[i];
+         g->py[i] = ys[g->row[i]];  g->ph[i] = ye[g->row[i] + g->r_span[i] - 1] - g->py[i];
+      }
    }
-   s_cnt++;
-   ui_grp->s_cnt = s_cnt;
 }
 
 //------------------------------------------------------------------------------
-static void _ui_parser_cmd_G (char *buf, fb_info_t *fb, ui_grp_t *ui_grp)
+static void _ui_r_item_del (ui_grp_t *ui_grp, int pos)
+{
+   ui_geom_t *g = &ui_grp->geom;
+   int i;
+
+   for (i = pos; i < ui_grp->r_cnt - 1; i++) {
+      ui_grp->r_item[i] = ui_grp->r_item[i + 1];
+      g->x[i]    = g->x[i + 1];      g->y[i]    = g->y[i + 1];
+      g->w[i]    = g->w[i + 1];      g->h[i]    = g->h[i + 1];
+      g->grid[i] = g->grid[i + 1];
+      g->col[i]  = g->col[i + 1];    g->row[i]  = g->row[i + 1];
+      g->c_span[i] = g->c_span[i + 1];
+      g->r_span[i] = g->r_span[i + 1];
+   }
+   ui_grp->r_cnt--;
+}
+
+//------------------------------------------------------------------------------
+static int _ui_parser_cmd_C (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   int is_bgr, fc, bc, lc, f_type;
+
+   if (_ui_tok_cmd (tok)              ||
+       _ui_tok_int (tok, 10, &is_bgr) ||
+       _ui_tok_int (tok, 16, &fc)     ||
+       _ui_tok_int (tok, 16, &bc)     ||
+       _ui_tok_int (tok, 16, &lc)     ||
+       _ui_tok_int (tok, 10, &f_type))
+      return -1;
+
+   fb->is_bgr        = (is_bgr != 0) ? 1: 0;
+   ui_grp->fc.uint   = fc;
+   ui_grp->bc.uint   = bc;
+   ui_grp->lc.uint   = lc;
+   ui_grp->f_type    = f_type;
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+static int _ui_parser_cmd_R (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   int r_cnt = ui_grp->r_cnt;
+   r_item_t *r_item = &ui_grp->r_item[r_cnt];
+   int x, y, w, h, bc, lc;
+
+   if (r_cnt >= ITEM_RECT_MAX)
+      return _ui_tok_err (tok, "too many rect items");
+
+   if (_ui_tok_cmd (tok)                 ||
+       _ui_tok_int (tok, 10, &r_item->id) ||
+       _ui_tok_int (tok, 10, &x)          ||
+       _ui_tok_int (tok, 10, &y)          ||
+       _ui_tok_int (tok, 10, &w)          ||
+       _ui_tok_int (tok, 10, &h)          ||
+       _ui_tok_int (tok, 16, &bc)         ||
+       _ui_tok_int (tok, 10, &r_item->lw) ||
+       _ui_tok_int (tok, 16, &lc))
+      return -1;
+
+   r_item->layer = ui_grp->l_cur;
+
+   /* 비율값(%)을 그대로 저장, pixel 변환은 ui_resolve 에서 함 */
+   ui_grp->geom.x[r_cnt] = _ui_fp (x, 100);
+   ui_grp->geom.y[r_cnt] = _ui_fp (y, 100);
+   ui_grp->geom.w[r_cnt] = _ui_fp (x + w, 100) - ui_grp->geom.x[r_cnt];
+   ui_grp->geom.h[r_cnt] = _ui_fp (y + h, 100) - ui_grp->geom.y[r_cnt];
+   ui_grp->geom.grid[r_cnt] = 0;
+   (void)fb;
+
+   r_item->bc.uint = (bc < 0) ? ui_grp->bc.uint : (unsigned int)bc;
+   r_item->lc.uint = (lc < 0) ? ui_grp->lc.uint : (unsigned int)lc;
+
+   ui_grp->r_cnt++;
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+static int _ui_parser_cmd_S (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   s_item_t *s_item = &ui_grp->s_item[ui_grp->s_cnt];
+   int fc, bc;
+
+   if (ui_grp->s_cnt >= ITEM_COUNT_MAX)
+      return _ui_tok_err (tok, "too many string items");
+
+   if (_ui_tok_cmd (tok)                       ||
+       _ui_tok_int (tok, 10, &s_item->r_id)     ||
+       _ui_tok_int (tok, 10, &s_item->x)        ||
+       _ui_tok_int (tok, 10, &s_item->y)        ||
+       _ui_tok_int (tok, 10, &s_item->scale)    ||
+       _ui_tok_int (tok, 16, &fc)               ||
+       _ui_tok_int (tok, 16, &bc)               ||
+       _ui_tok_str (tok, s_item->str, ITEM_STR_MAX) ||
+       _ui_tok_int (tok, 10, &s_item->f_type))
+      return -1;
+
+   s_item->fc.uint = (fc < 0) ? ui_grp->fc.uint : (unsigned int)fc;
+   s_item->bc.uint = bc;
+
+   s_item->layer   = ui_grp->l_cur;
+   s_item->l_x     = s_item->x;
+   s_item->l_y     = s_item->y;
+   s_item->l_scale = s_item->scale;
+
+   /* 박스가 없는 문자열의 기본값은 ui_resolve 에서 설정 (박스는 문자열 뒤에 설정될 수 있음) */
+   (void)fb;
+   ui_grp->s_cnt++;
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+static int _ui_parser_cmd_G (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp)
 {
    int pos = ui_grp->r_cnt;
-   int s_h, r_h, sid, r_cnt, g_cnt, bc, lw, lc, i, j, y_s;
-   char *ptr = strtok (buf, ",");
-
-   ptr = strtok (NULL, ",");     sid   = atoi(ptr);
-   ptr = strtok (NULL, ",");     r_cnt = atoi(ptr);
-   ptr = strtok (NULL, ",");     s_h   = atoi(ptr);
-   ptr = strtok (NULL, ",");     r_h   = atoi(ptr);
-   ptr = strtok (NULL, ",");     g_cnt = atoi(ptr);
-   ptr = strtok (NULL, ",");     bc    = strtol(ptr, NULL, 16);
-   ptr = strtok (NULL, ",");     lw    = atoi(ptr);
-   ptr = strtok (NULL, ",");     lc    = strtol(ptr, NULL, 16);
+   int s_h, r_h, sid, r_cnt, g_cnt, bc, lw, lc, i, j;
+
+   if (_ui_tok_cmd (tok)              ||
+       _ui_tok_int (tok, 10, &sid)    ||
+       _ui_tok_int (tok, 10, &r_cnt)  ||
+       _ui_tok_int (tok, 10, &s_h)    ||
+       _ui_tok_int (tok, 10, &r_h)    ||
+       _ui_tok_int (tok, 10, &g_cnt)  ||
+       _ui_tok_int (tok, 16, &bc)     ||
+       _ui_tok_int (tok, 10, &lw)     ||
+       _ui_tok_int (tok, 16, &lc))
+      return -1;
+
+   if ((r_cnt <= 0) || (g_cnt < 0))
+      return _ui_tok_err (tok, "invalid group count");
+   if (pos + r_cnt * g_cnt > ITEM_RECT_MAX)
+      return _ui_tok_err (tok, "too many rect items");
 
    for (i = 0; i < g_cnt; i++) {
-      for (j = 0; j < r_cnt; j++) {
-         pos = ui_grp->r_cnt + j + i * r_cnt;
-
-         ui_grp->r_item[pos].w = (fb->w / r_cnt);
-         y_s                   = (fb->h * s_h) / 100;
-         ui_grp->r_item[pos].h = (fb->h * r_h) / 100;
+      /* 세로는 s_h% 부터 r_h% 간격 (줄 마다 한번만 계산) */
+      int y = _ui_fp (s_h + r_h * i, 100);
+      int h = _ui_fp (s_h + r_h * (i + 1), 100) - y;
+
+      for (j = 0; j < r_cnt; j++, pos++) {
+         /* 가로는 fb 를 r_cnt 등분 */
+         ui_grp->geom.x[pos] = _ui_fp (j, r_cnt);
+         ui_grp->geom.w[pos] = _ui_fp (j + 1, r_cnt) - ui_grp->geom.x[pos];
+         ui_grp->geom.y[pos] = y;
+         ui_grp->geom.h[pos] = h;
+         ui_grp->geom.grid[pos] = 0;
 
          ui_grp->r_item[pos].id = sid + j + i * r_cnt;
-         ui_grp->r_item[pos].x  = ui_grp->r_item[pos].w * j;
-         ui_grp->r_item[pos].y  = ui_grp->r_item[pos].h * i + y_s;
          ui_grp->r_item[pos].lw = lw;
+         ui_grp->r_item[pos].layer = ui_grp->l_cur;
 
-         ui_grp->r_item[pos].bc.uint = bc < 0 ? ui_grp->bc.uint : bc;
-         ui_grp->r_item[pos].lc.uint = lc < 0 ? ui_grp->lc.uint : lc;
+         ui_grp->r_item[pos].bc.uint = bc < 0 ? ui_grp->bc.uint : (unsigned int)bc;
+         ui_grp->r_item[pos].lc.uint = lc < 0 ? ui_grp->lc.uint : (unsigned int)lc;
       }
    }
-   ui_grp->r_cnt = pos +1;
+   ui_grp->r_cnt = pos;
+   (void)fb;
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+static int _ui_parser_cmd_L (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   int pos = ui_grp->r_cnt;
+   ui_grid_t *grid = &ui_grp->grid[ui_grp->g_cnt];
+   int sid, x, y, w, h, bc, lw, lc, i, j;
+
+   if (ui_grp->g_cnt >= UI_GRID_MAX)
+      return _ui_tok_err (tok, "too many grid layouts");
+
+   if (_ui_tok_cmd (tok)                    ||
+       _ui_tok_int (tok, 10, &sid)          ||
+       _ui_tok_int (tok, 10, &grid->cols)   ||
+       _ui_tok_int (tok, 10, &grid->rows)   ||
+       _ui_tok_int (tok, 10, &x)            ||
+       _ui_tok_int (tok, 10, &y)            ||
+       _ui_tok_int (tok, 10, &w)            ||
+       _ui_tok_int (tok, 10, &h)            ||
+       _ui_tok_int (tok, 10, &grid->margin) ||
+       _ui_tok_int (tok, 10, &grid->gap_x)  ||
+       _ui_tok_int (tok, 10, &grid->gap_y)  ||
+       _ui_tok_int (tok, 16, &bc)           ||
+       _ui_tok_int (tok, 10, &lw)           ||
+       _ui_tok_int (tok, 16, &lc))
+      return -1;
+
+   if ((grid->cols <= 0) || (grid->rows <= 0))
+      return _ui_tok_err (tok, "invalid grid size");
+   if ((grid->cols > ITEM_RECT_MAX - pos) || (grid->rows > (ITEM_RECT_MAX - pos) / grid->cols))
+      return _ui_tok_err (tok, "too many rect items");
+   if ((grid->margin < 0) || (grid->gap_x < 0) || (grid->gap_y < 0))
+      return _ui_tok_err (tok, "invalid grid margin or gap");
+
+   grid->x = _ui_fp (x, 100);    grid->w = _ui_fp (x + w, 100) - grid->x;
+   grid->y = _ui_fp (y, 100);    grid->h = _ui_fp (y + h, 100) - grid->y;
+   ui_grp->g_cnt++;
+
+   /* 칸의 pixel 좌표는 ui_resolve 에서 grid 단위로 계산 */
+   for (i = 0; i < grid->rows; i++) {
+      for (j = 0; j < grid->cols; j++, pos++) {
+         ui_grp->geom.grid[pos]   = ui_grp->g_cnt;
+         ui_grp->geom.col[pos]    = j;
+         ui_grp->geom.row[pos]    = i;
+         ui_grp->geom.c_span[pos] = 1;
+         ui_grp->geom.r_span[pos] = 1;
+
+         ui_grp->r_item[pos].id    = sid + j + i * grid->cols;
+         ui_grp->r_item[pos].lw    = lw;
+         ui_grp->r_item[pos].layer = ui_grp->l_cur;
+
+         ui_grp->r_item[pos].bc.uint = bc < 0 ? ui_grp->bc.uint : (unsigned int)bc;
+         ui_grp->r_item[pos].lc.uint = lc < 0 ? ui_grp->lc.uint : (unsigned int)lc;
+      }
+   }
+   ui_grp->r_cnt = pos;
+   (void)fb;
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+static int _ui_parser_cmd_P (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   ui_geom_t *g = &ui_grp->geom;
+   int id, c_span, r_span, pos, i;
+   ui_grid_t *grid;
+
+   if (_ui_tok_cmd (tok)               ||
+       _ui_tok_int (tok, 10, &id)      ||
+       _ui_tok_int (tok, 10, &c_span)  ||
+       _ui_tok_int (tok, 10, &r_span))
+      return -1;
+
+   /* 마지막에 정의된 같은 id 의 grid 박스 */
+   for (pos = ui_grp->r_cnt - 1; pos >= 0; pos--)
+      if ((ui_grp->r_item[pos].id == id) && g->grid[pos])
+         break;
+   if (pos < 0)
+      return _ui_tok_err (tok, "span needs a grid rect id");
+
+   grid = &ui_grp->grid[g->grid[pos] - 1];
+   if ((c_span <= 0) || (r_span <= 0) ||
+       (g->col[pos] + c_span > grid->cols) || (g->row[pos] + r_span > grid->rows))
+      return _ui_tok_err (tok, "invalid span");
+
+   g->c_span[pos] = c_span;
+   g->r_span[pos] = r_span;
+
+   /* span 영역에 가려지는 같은 grid 의 박스는 삭제 */
+   for (i = ui_grp->r_cnt - 1; i >= 0; i--) {
+      if ((i == pos) || (g->grid[i] != g->grid[pos]))
+         continue;
+      if ((g->col[i] >= g->col[pos]) && (g->col[i] < g->col[pos] + c_span) &&
+          (g->row[i] >= g->row[pos]) && (g->row[i] < g->row[pos] + r_span)) {
+         _ui_r_item_del (ui_grp, i);
+         if (i < pos)
+            pos--;
+      }
+   }
+   (void)fb;
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+static int _ui_parser_cmd_Z (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   int layer;
+
+   if (_ui_tok_cmd (tok) || _ui_tok_int (tok, 10, &layer))
+      return -1;
+
+   if ((layer < 0) || (layer >= FB_LAYER_MAX))
+      return _ui_tok_err (tok, "invalid layer");
+
+   ui_grp->l_cur = layer;
+   if (ui_grp->l_cnt < layer + 1)
+      ui_grp->l_cnt = layer + 1;
+   (void)fb;
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+static int _ui_parser_cmd_W (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   w_item_t *w_item = &ui_grp->w_item[ui_grp->w_cnt];
+   int fc, bc;
+
+   if (ui_grp->w_cnt >= ITEM_COUNT_MAX)
+      return _ui_tok_err (tok, "too many widget items");
+
+   if (_ui_tok_cmd (tok)                     ||
+       _ui_tok_int (tok, 10, &w_item->r_id)  ||
+       _ui_tok_int (tok, 10, &w_item->type)  ||
+       _ui_tok_int (tok, 10, &w_item->min)   ||
+       _ui_tok_int (tok, 10, &w_item->max)   ||
+       _ui_tok_int (tok, 16, &fc)            ||
+       _ui_tok_int (tok, 16, &bc)            ||
+       _ui_tok_int (tok, 10, &w_item->cnt))
+      return -1;
+
+   if ((w_item->type < 0) || (w_item->type >= eWIDGET_END))
+      return _ui_tok_err (tok, "invalid widget type");
+   if (!_ui_is_box (ui_grp, w_item->r_id))
+      return _ui_tok_err (tok, "widget needs a rect id");
+
+   /* bar graph 는 막대 개수, log panel 은 문자 크기로 cnt 를 사용 */
+   if (w_item->type == eWIDGET_LOG) {
+      if ((w_item->cnt <= 0) || (w_item->cnt > ITEM_SCALE_MAX))
+         return _ui_tok_err (tok, "invalid log scale");
+      if ((w_item->log = malloc(sizeof(*w_item->log) * WIDGET_LOG_MAX)) == NULL)
+         return _ui_tok_err (tok, "log buffer alloc fail");
+      w_item->h_size = WIDGET_LOG_MAX;
+      w_item->f_type = ui_grp->f_type;
+   }
+   else {
+      if (w_item->type != eWIDGET_BAR)
+         w_item->cnt = 1;
+      if ((w_item->cnt <= 0) || (w_item->cnt > WIDGET_BAR_MAX))
+         return _ui_tok_err (tok, "invalid bar count");
+   }
+
+   w_item->fc.uint = (fc < 0) ? ui_grp->fc.uint : (unsigned int)fc;
+   w_item->bc.uint = bc;
+   w_item->layer   = ui_grp->l_cur;
+   w_item->d_cnt   = -1;
+   memset (w_item->val,   0x00, sizeof(w_item->val));
+   memset (w_item->d_len, 0xFF, sizeof(w_item->d_len));
+   for (fc = 0; fc < WIDGET_BAR_MAX; fc++)
+      w_item->val[fc] = w_item->min;
+
+   ui_grp->w_cnt++;
+   (void)fb;
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+static int _ui_parser_cmd_I (ui_tok_t *tok, fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   i_item_t *i_item = &ui_grp->i_item[ui_grp->i_cnt];
+   int len;
+
+   if (ui_grp->i_cnt >= ITEM_COUNT_MAX)
+      return _ui_tok_err (tok, "too many image items");
+
+   if (_ui_tok_cmd (tok)                     ||
+       _ui_tok_int (tok, 10, &i_item->r_id)  ||
+       _ui_tok_int (tok, 10, &i_item->x)     ||
+       _ui_tok_int (tok, 10, &i_item->y)     ||
+       _ui_tok_str (tok, i_item->path, ITEM_PATH_MAX))
+      return -1;
+
+   for (len = strlen (i_item->path); (len > 0) && (i_item->path[len - 1] == ' '); len--)
+      i_item->path[len - 1] = 0x00;
+
+   /* parsing 할 때 1번 읽어서 변환 (layer surface 형식이 다르면 처음 그릴 때 다시 변환) */
+   if ((i_item->img = fb_image_load (fb, i_item->path)) == NULL)
+      return _ui_tok_err (tok, "image load fail");
+
+   i_item->layer = ui_grp->l_cur;
+   ui_grp->i_cnt++;
+   return 0;
 }
 
 //------------------------------------------------------------------------------
@@ -363,89 +1524,178 @@ void ui_set_str (fb_info_t *fb, ui_grp_t *ui_grp,
    int n_sid = 0, n_rid = 0;
    s_item_t *s_item;
    r_item_t *r_item;
-
-   if (id < ITEM_COUNT_MAX) {
+   va_list va;
+   char buf[ITEM_STR_MAX];
+
+   /* 받아온 가변인자를 string 형태로 변환 하여 buf에 저장 */
+   memset(buf, 0x00, sizeof(buf));
+   va_start(va, fmt);   vsnprintf(buf, sizeof(buf), fmt, va);   va_end(va);
+
+   /*
+      이전 문자열은 s_item의 d_str에 남아있으므로 지우지 않고 새로운 문자열을 그린다.
+      _ui_update_s 에서 변경된 glyph 및 남는 영역만 다시 그림.
+   */
+   if (_ui_is_box (ui_grp, id)) {
       while ((r_item = _ui_find_r_item(ui_grp, &n_rid, id)) != NULL) {
          n_sid = 0;
          while ((s_item = _ui_find_s_item(ui_grp, &n_sid, id)) != NULL) {
-            va_list va;
-            char buf[ITEM_STR_MAX];
-            int n_scale = s_item->scale;
-
-            /* 받아온 가변인자를 string 형태로 변환 하여 buf에 저장 */
-            memset(buf, 0x00, sizeof(buf));
-            va_start(va, fmt);   vsprintf(buf, fmt, va); va_end(va);
-
             if (scale) {
+               s_item->l_scale = scale;
                /* scale = -1 이면 최대 스케일을 구하여 표시한다 */
                if (scale < 0)
-                  n_scale = _ui_str_scale (r_item->w, r_item->h,
+                  s_item->scale = _ui_str_scale (r_item->w, r_item->h,
                                              r_item->lw, _my_strlen(buf));
                else
-                  n_scale = scale;
-
-               if (s_item->scale > n_scale)
-                  _ui_clr_str (fb, r_item, s_item);
+                  s_item->scale = scale;
             }
-
-            if (font) {
+            if (font)
                s_item->f_type = (font < 0) ? ui_grp->f_type : font;
-               set_font(s_item->f_type);
-            }
-            /*
-               기존 문자열 보다 새로운 문자열이 더 작은 경우
-               기존 문자열을 배경색으로 덮어 씌운다.
-            */
-            if ((strlen(s_item->str) > strlen(buf)) || n_scale != s_item->scale) {
-               _ui_clr_str (fb, r_item, s_item);
-               s_item->scale = n_scale;
-            }
-            s_item->x = (x != 0) ? x : s_item->x;
-            s_item->y = (y != 0) ? x : s_item->y;
+
+            s_item->x = s_item->l_x = (x != 0) ? x : s_item->x;
+            s_item->y = s_item->l_y = (y != 0) ? y : s_item->y;
 
             /* 새로운 string 복사 */
-            strncpy(s_item->str, buf, strlen(buf));
+            strncpy(s_item->str, buf, ITEM_STR_MAX);
 
             _ui_str_pos_xy(r_item, s_item);
-            _ui_update_s (fb, s_item, r_item->x, r_item->y);
+            _ui_update_s (_ui_fb (fb, ui_grp, s_item->layer), s_item,
+                          r_item->x, r_item->y);
          }
       }
    } else {
       int i;
       for (i = 0; i < ui_grp->s_cnt; i++) {
          if (ui_grp->s_item[i].r_id == id) {
-            int color = ui_grp->s_item[i].fc.uint;
-
-            /* 기존 문자열을 벼경색으로 다시 그려서 지움 */
-            ui_grp->s_item[i].fc.uint = ui_grp->s_item[i].bc.uint;
-            _ui_update_s (fb, &ui_grp->s_item[i], 0, 0);
-            ui_grp->s_item[i].fc.uint = color;
             ui_grp->s_item[i].scale = (scale > 0) ? scale : 1;
             ui_grp->s_item[i].f_type = font;
-            ui_grp->s_item[i].x = x;
-            ui_grp->s_item[i].y = y;
-            _ui_update_s (fb, &ui_grp->s_item[i], 0, 0);
+            ui_grp->s_item[i].x = ui_grp->s_item[i].l_x = x;
+            ui_grp->s_item[i].y = ui_grp->s_item[i].l_y = y;
+            strncpy(ui_grp->s_item[i].str, buf, ITEM_STR_MAX);
+            _ui_update_s (_ui_fb (fb, ui_grp, ui_grp->s_item[i].layer),
+                        &ui_grp->s_item[i], 0, 0);
          }
       }
    }
 }
 
 //------------------------------------------------------------------------------
-void ui_update (fb_info_t *fb, ui_grp_t *ui_grp, int id)
+/*
+   id 박스의 widget 값을 변경하고 변경된 부분만 그린다.
+   progress bar : idx 무시, bar graph : idx 번째 막대, sparkline : 새로운 sample 추가(idx 무시)
+*/
+void ui_set_value (fb_info_t *fb, ui_grp_t *ui_grp, int id, int idx, int val)
 {
-   int i, sid, fid;
+   int i, n_rid;
    r_item_t *r_item;
 
+   for (i = 0; i < ui_grp->w_cnt; i++) {
+      w_item_t *w_item = &ui_grp->w_item[i];
+
+      if ((w_item->r_id != id) || (w_item->type == eWIDGET_LOG))
+         continue;
+
+      if (w_item->type == eWIDGET_SPARK) {
+         if (w_item->hist == NULL)
+            continue;
+         w_item->hist[w_item->h_pos] = val;
+         w_item->h_pos = (w_item->h_pos + 1) % w_item->h_size;
+         if (w_item->h_cnt < w_item->h_size)
+            w_item->h_cnt++;
+      } else {
+         if ((idx < 0) || (idx >= w_item->cnt))
+            idx = 0;
+         if (w_item->val[idx] == val)
+            continue;
+         w_item->val[idx] = val;
+      }
+
+      n_rid = 0;
+      while ((r_item = _ui_find_r_item(ui_grp, &n_rid, id)) != NULL) {
+         fb_rect_t a;
+         fb_info_t *l_fb = _ui_fb (fb, ui_grp, w_item->layer);
+
+         if ((signed)w_item->bc.uint < 0)
+            w_item->bc.uint = r_item->bc.uint;
+         _ui_w_area (r_item, &a);
+         if (w_item->type == eWIDGET_SPARK)
+            _ui_w_spark (l_fb, w_item, &a);
+         else
+            _ui_w_bar (l_fb, w_item, &a, idx);
+         break;
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+/*
+   id 박스의 log panel 에 1 line 을 추가한다.
+   panel 이 가득차면 1 line 위로 scroll 하고 새로운 line 만 그림.
+*/
+void ui_log (fb_info_t *fb, ui_grp_t *ui_grp, int id, char *fmt, ...)
+{
+   int i, n_rid;
+   r_item_t *r_item;
+   va_list va;
+   char buf[ITEM_STR_MAX];
+
+   memset(buf, 0x00, sizeof(buf));
+   va_start(va, fmt);   vsnprintf(buf, sizeof(buf), fmt, va);   va_end(va);
+
+   for (i = 0; i < ui_grp->w_cnt; i++) {
+      w_item_t *w_item = &ui_grp->w_item[i];
+
+      if ((w_item->r_id != id) || (w_item->type != eWIDGET_LOG))
+         continue;
+
+      strncpy (w_item->log[w_item->h_pos], buf, ITEM_STR_MAX);
+      w_item->h_pos = (w_item->h_pos + 1) % w_item->h_size;
+      if (w_item->h_cnt < w_item->h_size)
+         w_item->h_cnt++;
+
+      n_rid = 0;
+      if ((r_item = _ui_find_r_item(ui_grp, &n_rid, id)) != NULL) {
+         fb_rect_t a;
+
+         if ((signed)w_item->bc.uint < 0)
+            w_item->bc.uint = r_item->bc.uint;
+         _ui_w_area (r_item, &a);
+         _ui_w_log (_ui_fb (fb, ui_grp, w_item->layer), w_item, &a);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+void ui_update (fb_info_t *fb, ui_grp_t *ui_grp, int id)
+{
+   int i;
+
    /* ui_grp에 등록되어있는 모든 item에 대하여 화면 업데이트 함 */
+   if ((id < 0) && ui_grp->tile && !_ui_update_tile (fb, ui_grp))
+      return;
+
    if (id < 0) {
-      /* 사각형 item에 대한 화면 업데이트 */
-      for (i = 0; i < ui_grp->r_cnt; i++)
-         _ui_update (fb, ui_grp, i);
+      /* 사각형 item에 대한 화면 업데이트 (같은 id 는 1번만) */
+      for (i = 0; i < ui_grp->r_cnt; i++) {
+         int j, id = ui_grp->r_item[i].id;
+
+         for (j = 0; (j < i) && (ui_grp->r_item[j].id != id); j++)
+            ;
+         if (j == i)
+            _ui_update (fb, ui_grp, id);
+      }
+
+      /* 박스에 속하지 않은 image item에 대한 화면 업데이트 */
+      for (i = 0; i < ui_grp->i_cnt; i++)
+         if (!_ui_is_box (ui_grp, ui_grp->i_item[i].r_id))
+            _ui_update_i (fb, ui_grp, NULL, &ui_grp->i_item[i]);
 
       /* 문자열 item에 대한 화면 업데이트 */
       for (i = 0; i < ui_grp->s_cnt; i++) {
-         if (ui_grp->s_item[i].r_id >= ITEM_COUNT_MAX)
-            _ui_update_s (fb, &ui_grp->s_item[i], 0, 0);
+         if (!_ui_is_box (ui_grp, ui_grp->s_item[i].r_id)) {
+            ui_grp->s_item[i].d_scale = 0;
+            _ui_update_s (_ui_fb (fb, ui_grp, ui_grp->s_item[i].layer),
+                        &ui_grp->s_item[i], 0, 0);
+         }
       }
    }
    else  /* id값으로 설정된 1 개의 item에 대한 화면 업데이트 */
@@ -453,48 +1703,245 @@ void ui_update (fb_info_t *fb, ui_grp_t *ui_grp, int id)
 
 }
 
+//------------------------------------------------------------------------------
+void ui_resolve (fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   ui_geom_t *g = &ui_grp->geom;
+   int i, cnt = ui_grp->r_cnt;
+
+   /* 논리 좌표 -> pixel 좌표 */
+   _ui_resolve_axis (g->x, g->w, g->px, g->pw, cnt, fb->w);
+   _ui_resolve_axis (g->y, g->h, g->py, g->ph, cnt, fb->h);
+   _ui_resolve_grid (fb, ui_grp);
+
+   for (i = 0; i < cnt; i++) {
+      ui_grp->r_item[i].x = g->px[i];   ui_grp->r_item[i].w = g->pw[i];
+      ui_grp->r_item[i].y = g->py[i];   ui_grp->r_item[i].h = g->ph[i];
+   }
+
+   /*
+      박스 기준 문자열은 설정값으로 되돌려서 다음 update 에서 위치/크기를 다시 계산.
+      박스가 없는 문자열은 화면 좌표이며 -1 인 값은 기본값으로 설정.
+   */
+   for (i = 0; i < ui_grp->s_cnt; i++) {
+      s_item_t *s_item = &ui_grp->s_item[i];
+
+      if (_ui_is_box (ui_grp, s_item->r_id)) {
+         s_item->x     = s_item->l_x;
+         s_item->y     = s_item->l_y;
+         s_item->scale = s_item->l_scale;
+      } else {
+         if (s_item->x < 0)          s_item->x = 0;
+         if (s_item->y < 0)          s_item->y = 0;
+         if (s_item->scale   < 0)    s_item->scale = 1;
+
+         if (s_item->f_type  < 0)
+            s_item->f_type  = ui_grp->f_type;
+         if ((signed)s_item->bc.uint < 0)
+            s_item->bc.uint = ui_grp->bc.uint;
+      }
+      s_item->d_scale = 0;
+   }
+   /* widget 은 다음 update 에서 전체 다시 그림, sparkline 기록은 박스 폭 만큼 유지 */
+   for (i = 0; i < ui_grp->w_cnt; i++) {
+      w_item_t *w_item = &ui_grp->w_item[i];
+      int n_rid = 0, size, n, k, *hist;
+      r_item_t *r_item;
+      fb_rect_t a;
+
+      memset (w_item->d_len, 0xFF, sizeof(w_item->d_len));
+      w_item->d_cnt = -1;
+
+      if ((w_item->type != eWIDGET_SPARK) ||
+          ((r_item = _ui_find_r_item (ui_grp, &n_rid, w_item->r_id)) == NULL))
+         continue;
+
+      _ui_w_area (r_item, &a);
+      if (((size = a.w) <= 0) || (size == w_item->h_size))
+         continue;
+      if ((hist = (int *)malloc(sizeof(int) * size)) == NULL)
+         continue;
+
+      /* 최근 sample 부터 새로운 크기 만큼 옮김 */
+      n = (w_item->h_cnt < size) ? w_item->h_cnt : size;
+      for (k = 0; k < n; k++)
+         hist[n - 1 - k] = w_item->hist[(w_item->h_pos - 1 - k + w_item->h_size) % w_item->h_size];
+      if (w_item->hist)
+         free (w_item->hist);
+      w_item->hist   = hist;
+      w_item->h_size = size;
+      w_item->h_cnt  = n;
+      w_item->h_pos  = n % size;
+   }
+   /* 화면 모드가 바뀌면 읽지 못했던 image 를 한번 더 읽어봄 */
+   for (i = 0; i < ui_grp->i_cnt; i++)
+      ui_grp->i_item[i].fail = false;
+
+   ui_grp->fb_w = fb->w;
+   ui_grp->fb_h = fb->h;
+}
+
+//------------------------------------------------------------------------------
+int ui_present (fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   /* layer 에서 변경된 영역만 합성하여 fb 에 반영 (layer 를 사용하지 않으면 합성은 없음) */
+   int cnt = ui_grp->comp ? fb_comp_present (ui_grp->comp) : 0;
+
+   /* capture, mirroring 등 hook 에 이번 frame 의 damage 를 전달 */
+   fb_present (fb);
+   return cnt;
+}
+
+//------------------------------------------------------------------------------
+void ui_layer_show (fb_info_t *fb, ui_grp_t *ui_grp, int layer, bool visible)
+{
+   /* popup/alert layer 등을 표시하거나 숨김, 다음 ui_present 에서 반영 */
+   (void)fb;
+   if (ui_grp->comp)
+      fb_comp_show (ui_grp->comp, layer, visible);
+}
+
+//------------------------------------------------------------------------------
+int ui_check_mode (fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   /*
+      화면 모드가 변경된 경우(HDMI 재연결 등) config 를 다시 읽지 않고
+      저장된 논리 좌표로 다시 배치하여 전체 화면을 다시 그림.
+   */
+   if ((fb_update_mode (fb) <= 0) &&
+       (ui_grp->fb_w == fb->w) && (ui_grp->fb_h == fb->h))
+      return 0;
+
+   ui_resolve (fb, ui_grp);
+   fb_clear (fb);
+
+   /* layer surface 는 새로운 화면 크기로 다시 생성 */
+   if (ui_grp->comp) {
+      fb_comp_close (ui_grp->comp);
+      ui_grp->comp = fb_comp_init (fb, ui_grp->l_cnt);
+   }
+   ui_update (fb, ui_grp, -1);
+   ui_present (fb, ui_grp);
+   return 1;
+}
+
+//------------------------------------------------------------------------------
+int ui_tile (fb_info_t *fb, ui_grp_t *ui_grp, int threads)
+{
+   /*
+      전체 다시 그리기(ui_update(-1))를 threads 개의 thread 에서 tile 별로 나누어 그림.
+      threads = 0 이면 CPU 수, 1 이면 tile 사용 안함.
+      return : 사용하는 thread 수
+   */
+   ui_tile_t *tl;
+
+   _ui_tile_free (ui_grp->tile);
+   ui_grp->tile = NULL;
+   if (threads == 1)
+      return 1;
+
+   if ((tl = (ui_tile_t *)malloc(sizeof(ui_tile_t))) == NULL) {
+      err("ui_tile malloc error!\n");
+      return 1;
+   }
+   memset (tl, 0x00, sizeof(ui_tile_t));
+
+   if ((tl->pool = fb_tile_init (fb->w, fb->h, threads)) == NULL) {
+      free (tl);
+      return 1;
+   }
+   ui_grp->tile = tl;
+   return tl->pool->threads;
+}
+
 //------------------------------------------------------------------------------
 void ui_close (ui_grp_t *ui_grp)
 {
    /* 할당받은 메모리가 있다면 시스템으로 반환한다. */
-   if (ui_grp)
+   if (ui_grp) {
+      int i;
+      for (i = 0; i < ui_grp->w_cnt; i++) {
+         if (ui_grp->w_item[i].hist)
+            free (ui_grp->w_item[i].hist);
+         if (ui_grp->w_item[i].log)
+            free (ui_grp->w_item[i].log);
+      }
+      for (i = 0; i < ui_grp->i_cnt; i++)
+         fb_image_put (ui_grp->i_item[i].img);
+      if (ui_grp->comp)
+         fb_comp_close (ui_grp->comp);
+      _ui_tile_free (ui_grp->tile);
       free (ui_grp);
+   }
 }
 
 //------------------------------------------------------------------------------
 ui_grp_t *ui_init (fb_info_t *fb, const char *cfg_filename)
 {
 	ui_grp_t	*ui_grp;
-   FILE *pfd;
-   char buf[256], r_cnt = 0, s_cnt = 0, *ptr, is_cfg_file = 0;
+   ui_tok_t tok;
+   struct stat st;
+   const char *map, *map_e, *nl;
+   int fd, is_cfg_file = 0;
 
-   if ((pfd = fopen(cfg_filename, "r")) == NULL)
+   if ((fd = open(cfg_filename, O_RDONLY)) < 0)
       return   NULL;
 
-	if ((ui_grp = (ui_grp_t *)malloc(sizeof(ui_grp_t))) == NULL)
+   if ((fstat(fd, &st) < 0) || (st.st_size == 0)) {
+      close (fd);
+      err("UI Config File not found! (filename = %s)\n", cfg_filename);
       return   NULL;
+   }
+   map = (const char *)mmap(NULL, st.st_size, PROT_READ,
+                                    MAP_PRIVATE | MAP_POPULATE, fd, 0);
+   close (fd);
+   if (map == MAP_FAILED) {
+      err("mmap");
+      return   NULL;
+   }
 
+	if ((ui_grp = (ui_grp_t *)malloc(sizeof(ui_grp_t))) == NULL) {
+      munmap ((void *)map, st.st_size);
+      return   NULL;
+   }
    memset (ui_grp, 0x00, sizeof(ui_grp_t));
-   memset (buf,    0x00, sizeof(buf));
 
-   while(fgets(buf, sizeof(buf), pfd) != NULL) {
+   /* mmap 된 config 를 1 line 씩 복사 없이 parsing */
+   memset (&tok, 0x00, sizeof(tok));
+   tok.fname = cfg_filename;
+
+   for (tok.s = map, map_e = map + st.st_size; tok.s < map_e; tok.s = nl + 1) {
+      if ((nl = memchr(tok.s, '\n', map_e - tok.s)) == NULL)
+         nl = map_e;
+      tok.p = tok.s;
+      tok.e = ((nl > tok.s) && (nl[-1] == '\r')) ? nl - 1 : nl;
+      tok.line++;
+
       if (!is_cfg_file) {
-         is_cfg_file = strncmp ("ODROID-UI-CONFIG", buf, strlen(buf)-1) == 0 ? 1 : 0;
-         memset (buf, 0x00, sizeof(buf));
+         is_cfg_file = ((tok.e - tok.s) == 16) &&
+                        !memcmp (tok.s, "ODROID-UI-CONFIG", 16);
          continue;
       }
-      switch(buf[0]) {
-         case  'C':  _ui_parser_cmd_C (buf, fb, ui_grp); break;
-         case  'R':  _ui_parser_cmd_R (buf, fb, ui_grp); break;
-         case  'S':  _ui_parser_cmd_S (buf, fb, ui_grp); break;
-         case  'G':  _ui_parser_cmd_G (buf, fb, ui_grp); break;
+      if (tok.s == tok.e)
+         continue;
+
+      switch(*tok.s) {
+         case  'C':  _ui_parser_cmd_C (&tok, fb, ui_grp); break;
+         case  'R':  _ui_parser_cmd_R (&tok, fb, ui_grp); break;
+         case  'S':  _ui_parser_cmd_S (&tok, fb, ui_grp); break;
+         case  'G':  _ui_parser_cmd_G (&tok, fb, ui_grp); break;
+         case  'Z':  _ui_parser_cmd_Z (&tok, fb, ui_grp); break;
+         case  'W':  _ui_parser_cmd_W (&tok, fb, ui_grp); break;
+         case  'L':  _ui_parser_cmd_L (&tok, fb, ui_grp); break;
+         case  'P':  _ui_parser_cmd_P (&tok, fb, ui_grp); break;
+         case  'I':  _ui_parser_cmd_I (&tok, fb, ui_grp); break;
          default :
-            err("Unknown parser command! cmd = %c\n", buf[0]);
-         case  '#':  case  '\n':
+            _ui_tok_err (&tok, "Unknown parser command!");
+         case  '#':
          break;
       }
-      memset (buf, 0x00, sizeof(buf));
    }
+   munmap ((void *)map, st.st_size);
 
    if (!is_cfg_file) {
       err("UI Config File not found! (filename = %s)\n", cfg_filename);
@@ -502,12 +1949,17 @@ ui_grp_t *ui_init (fb_info_t *fb, const char *cfg_filename)
       return NULL;
    }
 
+   ui_resolve (fb, ui_grp);
+
+   /* 2개 이상의 layer 가 설정된 경우 layer 별 surface 에 그리고 합성 */
+   if ((ui_grp->l_cnt > 1) && ((ui_grp->comp = fb_comp_init (fb, ui_grp->l_cnt)) == NULL))
+      err("layer compositor create fail! (layer = %d)\n", ui_grp->l_cnt);
+
    /* all item update */
-   if (ui_grp->r_cnt)
+   if (ui_grp->r_cnt) {
       ui_update (fb, ui_grp, -1);
-
-   if (pfd)
-      fclose (pfd);
+      ui_present (fb, ui_grp);
+   }
 
 	// file parser
 	return	ui_grp;
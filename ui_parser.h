@@ -5,32 +5,139 @@
 
 //------------------------------------------------------------------------------
 #define	ITEM_COUNT_MAX	64
+/* 박스 최대 개수 ('L' grid 를 위해 다른 item 보다 많음, 박스 id 는 개수와 관계없는 임의의 값) */
+#define	ITEM_RECT_MAX	(ITEM_COUNT_MAX * 4)
 #define	ITEM_STR_MAX	64
 #define	ITEM_SCALE_MAX	100
+#define	ITEM_PATH_MAX	128
+
+/* widget : bar graph 최대 막대 개수 */
+#define	WIDGET_BAR_MAX	32
+/* widget : log panel 에 기록되는 최대 line 수 */
+#define	WIDGET_LOG_MAX	32
+
+enum eUI_WIDGET {
+	eWIDGET_PROGRESS = 0,
+	eWIDGET_BAR,
+	eWIDGET_SPARK,
+	eWIDGET_LOG,
+	eWIDGET_END
+};
+
+/* 논리 좌표 : fb w/h 에 대한 비율 (fixed point, UI_FP_ONE = 100%) */
+#define	UI_FP_SHIFT		24
+#define	UI_FP_ONE		(1 << UI_FP_SHIFT)
 
 //------------------------------------------------------------------------------
 typedef struct rect_item__t {
-	int				id, x, y, w, h, lw;
+	int				id, x, y, w, h, lw, layer;
 	fb_color_u		bc, lc;
 }	r_item_t;
 
 typedef struct string_item__t {
-	int				r_id, x, y, scale, f_type;
+	int				r_id, x, y, scale, f_type, layer;
 	fb_color_u		fc, bc;
 	char            str[ITEM_STR_MAX];
+
+	/* 설정된 x, y, scale 값 (-1 = 박스 기준 자동), 화면 모드 변경시 다시 계산 */
+	int				l_x, l_y, l_scale;
+
+	/* 화면에 마지막으로 그려진 문자열 정보 (d_scale = 0 이면 그려진 문자열 없음) */
+	int				d_x, d_y, d_scale, d_f_type;
+	fb_color_u		d_fc, d_bc;
+	char            d_str[ITEM_STR_MAX];
 }	s_item_t;
 
+/*
+	r_id 박스 안쪽(외곽라인 제외)에 그려지는 progress bar / bar graph / sparkline / log panel.
+	값이 변경되면 변경된 부분만 그림.
+*/
+typedef struct widget_item__t {
+	int				r_id, type, min, max, cnt, layer;
+	fb_color_u		fc, bc;
+	/* progress, bar graph : 값 및 화면에 그려진 막대 길이(pixel, -1 = 다시 그려야 함) */
+	int				val[WIDGET_BAR_MAX];
+	int				d_len[WIDGET_BAR_MAX];
+	/* sparkline : sample 기록(ring buffer, 박스 폭 만큼), 화면에 그려진 sample 수 */
+	int				*hist, h_size, h_pos, h_cnt, d_cnt;
+	/* log panel : line 기록(ring buffer, h_size/h_pos/h_cnt 사용), 문자 크기는 cnt, font */
+	char			(*log)[ITEM_STR_MAX];
+	int				f_type;
+}	w_item_t;
+
+/*
+	r_id 박스 안에 그려지는 image (BMP, PPM, QOI). 화면 pixel 형식으로 변환된 image 를 복사만 함.
+	x, y = -1 이면 박스 중앙, r_id 박스가 없으면 화면 좌표.
+*/
+typedef struct image_item__t {
+	int				r_id, x, y, layer;
+	char			path[ITEM_PATH_MAX];
+	/* fb_image cache 의 image (그릴 surface 의 형식과 다르면 다시 읽음) */
+	struct fb_image__t	*img;
+	/* 다시 읽기 실패 (화면 모드가 바뀌기 전까지 다시 읽지 않음) */
+	bool			fail;
+}	i_item_t;
+
+/* 'L' grid layout 최대 개수 */
+#define	UI_GRID_MAX		8
+
+/*
+	grid layout : 영역(논리 좌표)을 cols x rows 칸으로 나눔.
+	margin, gap 은 pixel 단위, 나누어 떨어지지 않는 pixel 은 앞쪽 칸부터 1 pixel 씩 배분.
+*/
+typedef struct ui_grid__t {
+	int				x, y, w, h;
+	int				cols, rows, margin, gap_x, gap_y;
+}	ui_grid_t;
+
+/*
+	r_item 의 논리 좌표 (UI_FP_ONE 기준 비율).
+	fb 크기가 변경되면 ui_resolve 에서 한번에 pixel 좌표로 변환하여 r_item 에 반영.
+*/
+typedef struct ui_geom__t {
+	int				x[ITEM_RECT_MAX], y[ITEM_RECT_MAX];
+	int				w[ITEM_RECT_MAX], h[ITEM_RECT_MAX];
+	/* 변환된 pixel 좌표 */
+	int				px[ITEM_RECT_MAX], py[ITEM_RECT_MAX];
+	int				pw[ITEM_RECT_MAX], ph[ITEM_RECT_MAX];
+	/* grid 에 속한 박스 : grid 번호(1 부터, 0 = grid 없음), 칸 위치 및 span */
+	int				grid[ITEM_RECT_MAX];
+	int				col[ITEM_RECT_MAX], row[ITEM_RECT_MAX];
+	int				c_span[ITEM_RECT_MAX], r_span[ITEM_RECT_MAX];
+}	ui_geom_t;
+
 typedef struct ui_group__t {
-	int             r_cnt, s_cnt, f_type;
+	int             r_cnt, s_cnt, w_cnt, i_cnt, f_type;
     fb_color_u      fc, bc, lc;
-	r_item_t		r_item[ITEM_COUNT_MAX];
+	r_item_t		r_item[ITEM_RECT_MAX];
 	s_item_t		s_item[ITEM_COUNT_MAX];
+	w_item_t		w_item[ITEM_COUNT_MAX];
+	i_item_t		i_item[ITEM_COUNT_MAX];
+	ui_geom_t		geom;
+	int				g_cnt;
+	ui_grid_t		grid[UI_GRID_MAX];
+	/* geom 이 변환된 fb 크기 */
+	int				fb_w, fb_h;
+
+	/* 'Z' command 로 설정된 layer 개수 및 현재 layer, 2개 이상이면 compositor 사용 */
+	int				l_cnt, l_cur;
+	struct fb_comp__t	*comp;
+
+	/* ui_tile 로 설정된 경우 전체 다시 그리기를 tile 별로 나누어 여러 thread 에서 그림 */
+	struct ui_tile__t	*tile;
 }	ui_grp_t;
 
 //------------------------------------------------------------------------------
 extern	void        ui_set_str	(fb_info_t *fb, ui_grp_t *ui_grp,
                                  int id, int x, int y, int scale, int font, char *fmt, ...);
+extern	void        ui_set_value (fb_info_t *fb, ui_grp_t *ui_grp, int id, int idx, int val);
+extern	void        ui_log      (fb_info_t *fb, ui_grp_t *ui_grp, int id, char *fmt, ...);
 extern	void        ui_update   (fb_info_t *fb, ui_grp_t *ui_grp, int id);
+extern	void        ui_resolve  (fb_info_t *fb, ui_grp_t *ui_grp);
+extern	int         ui_tile     (fb_info_t *fb, ui_grp_t *ui_grp, int threads);
+extern	int         ui_present  (fb_info_t *fb, ui_grp_t *ui_grp);
+extern	void        ui_layer_show (fb_info_t *fb, ui_grp_t *ui_grp, int layer, bool visible);
+extern	int         ui_check_mode (fb_info_t *fb, ui_grp_t *ui_grp);
 extern	void        ui_close    (ui_grp_t *ui_grp);
 extern	ui_grp_t	*ui_init    (fb_info_t *fb, const char *cfg_filename);
 
@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+//
+// UI update queue (multi-producer / single render thread)
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#include "typedefs.h"
+#include "fblib/fblib.h"
+#include "ui_parser.h"
+#include "ui_queue.h"
+
+//------------------------------------------------------------------------------
+// Function prototype.
+//------------------------------------------------------------------------------
+static   ui_upd_t    *_ui_queue_find   (ui_queue_t *q, int id);
+         int         ui_queue_set_str  (ui_queue_t *q,
+                                 int id, int x, int y, int scale, int font, char *fmt, ...);
+         int         ui_queue_drain    (ui_queue_t *q, fb_info_t *fb, ui_grp_t *ui_grp);
+         void        ui_queue_close    (ui_queue_t *q);
+         ui_queue_t  *ui_queue_init    (void);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+/*
+   ui_set_str 은 fb 및 font 전역상태를 사용하므로 여러 thread 에서 호출할 수 없다.
+   각 thread 는 ui_queue_set_str 로 update 를 등록하고,
+   1개의 render thread 가 frame 마다 ui_queue_drain 으로 화면에 반영한다.
+   drain 전에 같은 id 로 여러번 등록된 경우 마지막 값만 그려진다.
+*/
+
+//------------------------------------------------------------------------------
+static ui_upd_t *_ui_queue_find (ui_queue_t *q, int id)
+{
+   int i;
+   for (i = 0; i < q->cnt; i++) {
+      if (q->upd[i].id == id)
+         return &q->upd[i];
+   }
+   return NULL;
+}
+
+//------------------------------------------------------------------------------
+int ui_queue_set_str (ui_queue_t *q,
+                        int id, int x, int y, int scale, int font, char *fmt, ...)
+{
+   ui_upd_t *upd;
+   int wake;
+   va_list va;
+   char buf[ITEM_STR_MAX];
+
+   /* 문자열 변환은 lock 밖에서 처리 */
+   memset(buf, 0x00, sizeof(buf));
+   va_start(va, fmt);   vsnprintf(buf, sizeof(buf), fmt, va);   va_end(va);
+
+   pthread_mutex_lock (&q->mutex);
+   q->pushed++;
+   wake = (q->cnt == 0);
+   if ((upd = _ui_queue_find (q, id)) != NULL) {
+      /* 같은 id 의 update 는 합침. 0 인 인자는 ui_set_str 과 같이 이전 값 유지 */
+      q->coalesced++;
+   } else if (q->cnt < UI_QUEUE_MAX) {
+      upd = &q->upd[q->cnt++];
+      memset (upd, 0x00, sizeof(ui_upd_t));
+      upd->id = id;
+   } else {
+      q->dropped++;
+      pthread_mutex_unlock (&q->mutex);
+      return -1;
+   }
+   if (x)      upd->x     = x;
+   if (y)      upd->y     = y;
+   if (scale)  upd->scale = scale;
+   if (font)   upd->font  = font;
+   memcpy (upd->str, buf, ITEM_STR_MAX);
+   pthread_mutex_unlock (&q->mutex);
+
+   /* 비어있던 queue 에 처음 등록된 경우에만 render thread 를 깨움 */
+   if (wake) {
+      uint64_t v = 1;
+      if (write (q->efd, &v, sizeof(v)) < 0)
+         err("eventfd write error!\n");
+   }
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+int ui_queue_drain (ui_queue_t *q, fb_info_t *fb, ui_grp_t *ui_grp)
+{
+   int i, cnt;
+
+   /* pending 목록을 work 버퍼로 옮기고 바로 lock 해제, 그리기는 lock 밖에서 함 */
+   pthread_mutex_lock (&q->mutex);
+   cnt = q->cnt;
+   memcpy (q->work, q->upd, sizeof(ui_upd_t) * cnt);
+   q->cnt = 0;
+   pthread_mutex_unlock (&q->mutex);
+
+   for (i = 0; i < cnt; i++)
+      ui_set_str (fb, ui_grp, q->work[i].id, q->work[i].x, q->work[i].y,
+                  q->work[i].scale, q->work[i].font, "%s", q->work[i].str);
+
+   /* layer 를 사용하는 경우 frame 의 변경 영역을 한번에 합성 */
+   if (cnt)
+      ui_present (fb, ui_grp);
+
+   return cnt;
+}
+
+//------------------------------------------------------------------------------
+void ui_queue_close (ui_queue_t *q)
+{
+   if (q) {
+      if (q->efd >= 0)
+         close (q->efd);
+      pthread_mutex_destroy (&q->mutex);
+      free (q);
+   }
+}
+
+//------------------------------------------------------------------------------
+ui_queue_t *ui_queue_init (void)
+{
+   ui_queue_t *q;
+
+   if ((q = (ui_queue_t *)malloc(sizeof(ui_queue_t))) == NULL) {
+      err("ui_queue malloc error!\n");
+      return NULL;
+   }
+   memset (q, 0x00, sizeof(ui_queue_t));
+   pthread_mutex_init (&q->mutex, NULL);
+
+   if ((q->efd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+      err("eventfd error!\n");
+      ui_queue_close (q);
+      return NULL;
+   }
+
+   return q;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
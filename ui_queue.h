@@ -0,0 +1,40 @@
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#ifndef __UI_QUEUE_H__
+#define __UI_QUEUE_H__
+
+#include <pthread.h>
+
+//------------------------------------------------------------------------------
+#define	UI_QUEUE_MAX	(ITEM_COUNT_MAX * 2)
+
+//------------------------------------------------------------------------------
+typedef struct ui_update__t {
+	int				id, x, y, scale, font;
+	char            str[ITEM_STR_MAX];
+}	ui_upd_t;
+
+typedef struct ui_queue__t {
+	pthread_mutex_t	mutex;
+	/* pending 목록이 비어있다가 채워질 때 render thread 를 깨우는 eventfd */
+	int				efd;
+	/* producer 가 채우는 pending 목록, 같은 id 는 1개만 유지 */
+	int				cnt;
+	ui_upd_t		upd[UI_QUEUE_MAX];
+	/* render thread 에서만 사용하는 drain 버퍼 */
+	ui_upd_t		work[UI_QUEUE_MAX];
+	unsigned long	pushed, coalesced, dropped;
+}	ui_queue_t;
+
+//------------------------------------------------------------------------------
+extern	int         ui_queue_set_str (ui_queue_t *q,
+                                 int id, int x, int y, int scale, int font, char *fmt, ...);
+extern	int         ui_queue_drain   (ui_queue_t *q, fb_info_t *fb, ui_grp_t *ui_grp);
+extern	void        ui_queue_close   (ui_queue_t *q);
+extern	ui_queue_t	*ui_queue_init   (void);
+
+//------------------------------------------------------------------------------
+
+#endif  // #define __UI_QUEUE_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
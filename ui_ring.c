@@ -0,0 +1,268 @@
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+//
+// UI command ring (memfd shared memory, lock-free MPSC, eventfd doorbell)
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE     /* memfd_create */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+
+#include "typedefs.h"
+#include "fblib/fblib.h"
+#include "ui_parser.h"
+#include "ui_cmd.h"
+#include "ui_ring.h"
+
+//------------------------------------------------------------------------------
+// Function prototype.
+//------------------------------------------------------------------------------
+static   ui_ring_t   *_ui_ring_map     (int mfd, int efd, bool init);
+         int         ui_ring_push      (ui_ring_t *r, ui_cmd_t *cmd);
+         int         ui_ring_pop       (ui_ring_t *r, ui_cmd_t *cmd);
+         int         ui_ring_arm       (ui_ring_t *r);
+         int         ui_ring_send      (ui_ring_t *r, int sock);
+         void        ui_ring_close     (ui_ring_t *r);
+         ui_ring_t   *ui_ring_attach   (const char *path);
+         ui_ring_t   *ui_ring_create   (void);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+/*
+   client process 는 ui_ring_attach 로 daemon(ui_cmd) 이 만든 ring 의 memfd/eventfd 를 socket 으로 받아
+   mmap 한 후 ui_ring_push 로 command 를 채운다. push 는 system call 이 없고,
+   renderer 가 비어있는 ring 을 보고 기다리는 중(armed)인 경우에만 eventfd 로 깨운다.
+   renderer 는 frame 마다 ui_ring_pop 으로 모두 꺼내 처리한다.
+*/
+
+//------------------------------------------------------------------------------
+static ui_ring_t *_ui_ring_map (int mfd, int efd, bool init)
+{
+   ui_ring_t *r;
+   size_t size = sizeof(ui_ring_shm_t) + sizeof(ui_ring_slot_t) * UI_RING_SIZE;
+   unsigned int i;
+
+   if ((r = (ui_ring_t *)malloc(sizeof(ui_ring_t))) == NULL) {
+      err("ui_ring malloc error!\n");
+      return NULL;
+   }
+   memset (r, 0x00, sizeof(ui_ring_t));
+   r->mfd = mfd;   r->efd = efd;   r->map_size = size;
+
+   if (init && (ftruncate (mfd, size) < 0)) {
+      err("ftruncate");
+      goto out;
+   }
+   r->shm = (ui_ring_shm_t *)mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, mfd, 0);
+   if (r->shm == MAP_FAILED) {
+      r->shm = NULL;
+      err("mmap");
+      goto out;
+   }
+   if (init) {
+      r->shm->magic    = UI_RING_MAGIC;
+      r->shm->size     = UI_RING_SIZE;
+      r->shm->cmd_size = sizeof(ui_cmd_t);
+      for (i = 0; i < UI_RING_SIZE; i++)
+         atomic_init (&r->shm->slot[i].seq, i);
+      atomic_init (&r->shm->head, 0);
+      atomic_init (&r->shm->tail, 0);
+      atomic_init (&r->shm->armed, 1);
+   }
+   else if ((r->shm->magic != UI_RING_MAGIC) || (r->shm->size != UI_RING_SIZE) ||
+            (r->shm->cmd_size != sizeof(ui_cmd_t))) {
+      err("ui_ring version mismatch!\n");
+      goto out;
+   }
+   return r;
+out:
+   ui_ring_close (r);
+   return NULL;
+}
+
+//------------------------------------------------------------------------------
+/*
+   여러 producer 에서 동시에 호출 가능. return : 0 = 성공, -1 = ring 가득참 (command 버림)
+*/
+int ui_ring_push (ui_ring_t *r, ui_cmd_t *cmd)
+{
+   ui_ring_shm_t *shm = r->shm;
+   ui_ring_slot_t *slot;
+   unsigned long pos = atomic_load_explicit (&shm->head, memory_order_relaxed);
+   long diff;
+   uint64_t v = 1;
+
+   while (1) {
+      slot = &shm->slot[pos & (UI_RING_SIZE - 1)];
+      diff = (long)atomic_load_explicit (&slot->seq, memory_order_acquire) - (long)pos;
+      if (diff == 0) {
+         if (atomic_compare_exchange_weak_explicit (&shm->head, &pos, pos + 1,
+                  memory_order_relaxed, memory_order_relaxed))
+            break;
+      }
+      else if (diff < 0) {
+         atomic_fetch_add_explicit (&shm->dropped, 1, memory_order_relaxed);
+         return -1;
+      }
+      else
+         pos = atomic_load_explicit (&shm->head, memory_order_relaxed);
+   }
+   memcpy (&slot->cmd, cmd, sizeof(ui_cmd_t));
+   slot->cmd.magic = UI_CMD_MAGIC;
+   atomic_store_explicit (&slot->seq, pos + 1, memory_order_release);
+
+   /* renderer 가 기다리는 중인 경우에만 doorbell (비어있다가 채워지는 경우)
+      seq store 와 armed load 가 순서를 바꾸지 않도록 fence (ui_ring_arm 과 짝) */
+   atomic_thread_fence (memory_order_seq_cst);
+   if (atomic_exchange_explicit (&shm->armed, 0, memory_order_acq_rel)) {
+      if (write (r->efd, &v, sizeof(v)) < 0)
+         err("eventfd write error!\n");
+   }
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+/*
+   renderer(consumer 1개) 에서만 호출. return : 1 = cmd 꺼냄, 0 = 비어있음
+*/
+int ui_ring_pop (ui_ring_t *r, ui_cmd_t *cmd)
+{
+   ui_ring_shm_t *shm = r->shm;
+   unsigned long pos = atomic_load_explicit (&shm->tail, memory_order_relaxed);
+   ui_ring_slot_t *slot = &shm->slot[pos & (UI_RING_SIZE - 1)];
+
+   if (atomic_load_explicit (&slot->seq, memory_order_acquire) != pos + 1)
+      return 0;
+
+   memcpy (cmd, &slot->cmd, sizeof(ui_cmd_t));
+   atomic_store_explicit (&slot->seq, pos + UI_RING_SIZE, memory_order_release);
+   atomic_store_explicit (&shm->tail, pos + 1, memory_order_relaxed);
+   return 1;
+}
+
+//------------------------------------------------------------------------------
+/*
+   ring 을 비운 후 호출, 다음 push 에서 doorbell 을 울리도록 함.
+   arm 하는 사이에 push 된 command 가 있으면 1 을 return (doorbell 없이 바로 처리해야 함).
+*/
+int ui_ring_arm (ui_ring_t *r)
+{
+   ui_ring_shm_t *shm = r->shm;
+   unsigned long pos = atomic_load_explicit (&shm->tail, memory_order_relaxed);
+
+   atomic_store_explicit (&shm->armed, 1, memory_order_seq_cst);
+   /* armed store 후 seq load 가 먼저 실행되면 push 와 엇갈려 doorbell 을 놓침 */
+   atomic_thread_fence (memory_order_seq_cst);
+   return (atomic_load_explicit (&shm->slot[pos & (UI_RING_SIZE - 1)].seq,
+               memory_order_acquire) == pos + 1) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+/*
+   연결된 client 에 memfd, eventfd 를 전달 (SCM_RIGHTS).
+*/
+int ui_ring_send (ui_ring_t *r, int sock)
+{
+   struct msghdr msg;
+   struct iovec iov;
+   struct cmsghdr *cm;
+   char buf[CMSG_SPACE(sizeof(int) * 2)], tag = 'R';
+   int fds[2] = { r->mfd, r->efd };
+
+   memset (&msg, 0x00, sizeof(msg));
+   memset (buf, 0x00, sizeof(buf));
+   iov.iov_base = &tag;    iov.iov_len = 1;
+   msg.msg_iov  = &iov;    msg.msg_iovlen = 1;
+   msg.msg_control    = buf;
+   msg.msg_controllen = sizeof(buf);
+
+   cm = CMSG_FIRSTHDR(&msg);
+   cm->cmsg_level = SOL_SOCKET;
+   cm->cmsg_type  = SCM_RIGHTS;
+   cm->cmsg_len   = CMSG_LEN(sizeof(fds));
+   memcpy (CMSG_DATA(cm), fds, sizeof(fds));
+
+   return (sendmsg (sock, &msg, MSG_NOSIGNAL) == 1) ? 0 : -1;
+}
+
+//------------------------------------------------------------------------------
+void ui_ring_close (ui_ring_t *r)
+{
+   if (r) {
+      if (r->shm)       munmap (r->shm, r->map_size);
+      if (r->mfd >= 0)  close (r->mfd);
+      if (r->efd >= 0)  close (r->efd);
+      free (r);
+   }
+}
+
+//------------------------------------------------------------------------------
+/*
+   client 에서 호출. daemon 의 command socket(path) 에 'r' 을 보내 ring 을 받음.
+*/
+ui_ring_t *ui_ring_attach (const char *path)
+{
+   struct sockaddr_un addr;
+   struct msghdr msg;
+   struct iovec iov;
+   struct cmsghdr *cm;
+   char buf[CMSG_SPACE(sizeof(int) * 2)], tag;
+   int fd, fds[2] = { -1, -1 };
+
+   if ((fd = socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+      err("socket");
+      return NULL;
+   }
+   memset (&addr, 0x00, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strncpy (addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+   memset (&msg, 0x00, sizeof(msg));
+   iov.iov_base = &tag;    iov.iov_len = 1;
+   msg.msg_iov  = &iov;    msg.msg_iovlen = 1;
+   msg.msg_control    = buf;
+   msg.msg_controllen = sizeof(buf);
+
+   if ((connect (fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+       (write (fd, "r\n", 2) != 2) ||
+       (recvmsg (fd, &msg, MSG_CMSG_CLOEXEC) != 1) ||
+       ((cm = CMSG_FIRSTHDR(&msg)) == NULL) || (cm->cmsg_type != SCM_RIGHTS) ||
+       (cm->cmsg_len != CMSG_LEN(sizeof(fds)))) {
+      err("%s ring attach fail!\n", path);
+      close (fd);
+      return NULL;
+   }
+   memcpy (fds, CMSG_DATA(cm), sizeof(fds));
+   close (fd);
+   return _ui_ring_map (fds[0], fds[1], false);
+}
+
+//------------------------------------------------------------------------------
+/*
+   renderer 에서 호출. ring 공유 memory 와 doorbell 생성.
+*/
+ui_ring_t *ui_ring_create (void)
+{
+   int mfd, efd;
+
+   mfd = memfd_create ("ui-ring", MFD_CLOEXEC);
+   efd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+   if ((mfd < 0) || (efd < 0)) {
+      err("memfd/eventfd create error!\n");
+      if (mfd >= 0)  close (mfd);
+      if (efd >= 0)  close (efd);
+      return NULL;
+   }
+   return _ui_ring_map (mfd, efd, true);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
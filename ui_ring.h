@@ -0,0 +1,53 @@
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#ifndef __UI_RING_H__
+#define __UI_RING_H__
+
+#include <stdatomic.h>
+
+//------------------------------------------------------------------------------
+#define	UI_RING_MAGIC		0x55495247	/* "UIRG" */
+/* slot 개수 (2 의 배수) */
+#define	UI_RING_SIZE		1024
+
+//------------------------------------------------------------------------------
+typedef struct ui_ring_slot__t {
+	/* slot 순서 번호 : pos 이면 비어있음, pos + 1 이면 채워짐 (Vyukov bounded queue) */
+	atomic_ulong	seq;
+	ui_cmd_t		cmd;
+}	ui_ring_slot_t;
+
+/* memfd 로 공유되는 영역 */
+typedef struct ui_ring_shm__t {
+	unsigned int	magic, size, cmd_size;
+	/* producer 가 예약한 위치, consumer 가 읽은 위치 */
+	atomic_ulong	head;
+	atomic_ulong	tail;
+	/* consumer 가 비어있는 ring 을 보고 doorbell 을 기다리는 중 */
+	atomic_int		armed;
+	/* ring 이 가득차서 버린 command 수 */
+	atomic_ulong	dropped;
+	ui_ring_slot_t	slot[];
+}	ui_ring_shm_t;
+
+typedef struct ui_ring__t {
+	ui_ring_shm_t	*shm;
+	/* 공유 memory(memfd), doorbell(eventfd) */
+	int				mfd, efd;
+	size_t			map_size;
+}	ui_ring_t;
+
+//------------------------------------------------------------------------------
+extern	int         ui_ring_push    (ui_ring_t *r, ui_cmd_t *cmd);
+extern	int         ui_ring_pop     (ui_ring_t *r, ui_cmd_t *cmd);
+extern	int         ui_ring_arm     (ui_ring_t *r);
+extern	int         ui_ring_send    (ui_ring_t *r, int sock);
+extern	void        ui_ring_close   (ui_ring_t *r);
+extern	ui_ring_t   *ui_ring_attach (const char *path);
+extern	ui_ring_t   *ui_ring_create (void);
+
+//------------------------------------------------------------------------------
+
+#endif  // #define __UI_RING_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,313 @@
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+//
+// UI frame scheduler (frame rate cap / vsync / timerfd + epoll)
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <linux/fb.h>
+
+#include "typedefs.h"
+#include "fblib/fblib.h"
+#include "fblib/fb_cap.h"
+#include "fblib/fb_stats.h"
+#include "ui_parser.h"
+#include "ui_queue.h"
+#include "ui_sched.h"
+
+//------------------------------------------------------------------------------
+// Function prototype.
+//------------------------------------------------------------------------------
+static   void        _ui_sched_arm     (ui_sched_t *s, bool on);
+static   void        _ui_sched_frame   (ui_sched_t *s);
+static   void        _ui_sched_cap     (fb_info_t *fb, void *arg);
+         void        ui_sched_stat     (ui_sched_t *s, ui_sched_stat_t *stat);
+         void        ui_sched_capture  (ui_sched_t *s, fb_cap_t *cap);
+         int         ui_sched_watch    (ui_sched_t *s, int fd, ui_sched_f func, void *arg);
+         void        ui_sched_batch    (ui_sched_t *s, ui_sched_batch_f func, void *arg);
+         void        ui_sched_kick     (ui_sched_t *s);
+         int         ui_sched_poll     (ui_sched_t *s, int timeout_ms);
+         void        ui_sched_run      (ui_sched_t *s);
+         void        ui_sched_stop     (ui_sched_t *s);
+         void        ui_sched_close    (ui_sched_t *s);
+         ui_sched_t  *ui_sched_init    (fb_info_t *fb, ui_grp_t *ui_grp,
+                                          ui_queue_t *q, int fps);
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+/*
+   ui_queue 에 update 가 등록되면(eventfd) frame 주기(1/fps) timer 를 동작시키고,
+   timer 가 만료될 때마다 queue 를 drain 하여 1 frame 으로 화면에 반영한다.
+   반영할 update 가 없는 frame 에서는 timer 를 정지하므로 idle 상태에서는
+   epoll_wait 에서 sleep 한다.
+*/
+
+//------------------------------------------------------------------------------
+static void _ui_sched_arm (ui_sched_t *s, bool on)
+{
+   struct itimerspec its;
+
+   memset (&its, 0x00, sizeof(its));
+   if (on) {
+      /* 첫 frame 은 바로 반영하고 이후 period 간격으로 반영 */
+      its.it_value.tv_nsec    = 1;
+      its.it_interval.tv_sec  = s->period_ns / 1000000000L;
+      its.it_interval.tv_nsec = s->period_ns % 1000000000L;
+   }
+   if (timerfd_settime (s->tfd, 0, &its, NULL) < 0)
+      err("timerfd_settime error!\n");
+   s->armed = on;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_sched_frame (ui_sched_t *s)
+{
+   uint64_t exp = 0;
+   int cnt, b_cnt;
+
+   if (read (s->tfd, &exp, sizeof(exp)) != sizeof(exp))
+      return;
+
+   /* frame 처리가 늦어 timer 가 여러번 만료된 경우 */
+   if (exp > 1)
+      s->stat.skipped += exp - 1;
+
+   if (s->vsync) {
+      int arg = 0;
+      if (ioctl (s->fb->fd, FBIO_WAITFORVSYNC, &arg) < 0)
+         s->vsync = false;
+   }
+
+   /* batch 는 queue 와 같은 frame 에 반영 (present 는 1번) */
+   b_cnt = s->batch ? s->batch (s->batch_arg) : 0;
+   if ((cnt = ui_queue_drain (s->q, s->fb, s->ui_grp)) == 0) {
+      if (b_cnt)
+         ui_present (s->fb, s->ui_grp);
+   }
+   if ((cnt += b_cnt) == 0) {
+      /* 반영할 update 가 없으면 다음 update 까지 sleep */
+      _ui_sched_arm (s, false);
+      return;
+   }
+   s->stat.presented++;
+   s->stat.updates += cnt;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_sched_cap (fb_info_t *fb, void *arg)
+{
+   /* fb_present 에서 호출, 이번 frame 의 damage 영역만 기록 */
+   (void)fb;
+   fb_cap_frame ((fb_cap_t *)arg, false);
+}
+
+//------------------------------------------------------------------------------
+void ui_sched_stat (ui_sched_t *s, ui_sched_stat_t *stat)
+{
+   memcpy (stat, &s->stat, sizeof(ui_sched_stat_t));
+
+   pthread_mutex_lock (&s->q->mutex);
+   stat->coalesced = s->q->coalesced;
+   pthread_mutex_unlock (&s->q->mutex);
+}
+
+//------------------------------------------------------------------------------
+/*
+   화면에 반영한 frame 마다 cap 에 기록 (NULL = 기록 중지).
+   현재 화면을 keyframe 으로 먼저 기록하여 이후 delta 의 기준으로 사용.
+*/
+void ui_sched_capture (ui_sched_t *s, fb_cap_t *cap)
+{
+   if (s->cap)
+      fb_hook_del (s->fb, _ui_sched_cap, s->cap);
+   s->cap = cap;
+   if (cap) {
+      fb_cap_frame (cap, true);
+      fb_hook_add (s->fb, _ui_sched_cap, cap);
+   }
+}
+
+//------------------------------------------------------------------------------
+/*
+   fd 에 읽을 data 가 있으면 scheduler thread 에서 func(arg) 호출. func = NULL 이면 제거.
+*/
+int ui_sched_watch (ui_sched_t *s, int fd, ui_sched_f func, void *arg)
+{
+   struct epoll_event ev;
+   int i;
+
+   for (i = 0; (i < s->w_cnt) && (s->watch[i].fd != fd); i++)
+      ;
+   if (func == NULL) {
+      if (i == s->w_cnt)
+         return -1;
+      epoll_ctl (s->epfd, EPOLL_CTL_DEL, fd, NULL);
+      s->watch[i] = s->watch[--s->w_cnt];
+      return 0;
+   }
+   if (i == s->w_cnt) {
+      if (s->w_cnt >= UI_SCHED_WATCH_MAX) {
+         err("too many watch fds!\n");
+         return -1;
+      }
+      memset (&ev, 0x00, sizeof(ev));
+      ev.events  = EPOLLIN;
+      ev.data.fd = fd;
+      if (epoll_ctl (s->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+         err("epoll_ctl error!\n");
+         return -1;
+      }
+      s->w_cnt++;
+   }
+   s->watch[i].fd   = fd;
+   s->watch[i].func = func;
+   s->watch[i].arg  = arg;
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+int ui_sched_poll (ui_sched_t *s, int timeout_ms)
+{
+   struct epoll_event ev[UI_SCHED_WATCH_MAX + 2];
+   int i, j, n;
+
+   if ((n = epoll_wait (s->epfd, ev, UI_SCHED_WATCH_MAX + 2, timeout_ms)) < 0) {
+      if (errno != EINTR)
+         err("epoll_wait error!\n");
+      /* idle 중 signal 로 요청된 통계 출력 */
+      fb_stats_poll ();
+      return n;
+   }
+
+   for (i = 0; i < n; i++) {
+      if (ev[i].data.fd == s->q->efd) {
+         uint64_t v;
+         if (read (s->q->efd, &v, sizeof(v)) < 0)
+            err("eventfd read error!\n");
+         if (!s->armed)
+            _ui_sched_arm (s, true);
+      }
+      else if (ev[i].data.fd == s->tfd)
+         _ui_sched_frame (s);
+      else {
+         for (j = 0; j < s->w_cnt; j++) {
+            if (ev[i].data.fd == s->watch[j].fd) {
+               s->watch[j].func (s->watch[j].arg);
+               break;
+            }
+         }
+      }
+   }
+   return n;
+}
+
+//------------------------------------------------------------------------------
+void ui_sched_run (ui_sched_t *s)
+{
+   s->run = true;
+   while (s->run)
+      ui_sched_poll (s, -1);
+}
+
+//------------------------------------------------------------------------------
+void ui_sched_batch (ui_sched_t *s, ui_sched_batch_f func, void *arg)
+{
+   s->batch     = func;
+   s->batch_arg = arg;
+}
+
+//------------------------------------------------------------------------------
+/*
+   batch 에 처리할 내용이 추가된 경우 호출, 다음 frame 을 예약함.
+*/
+void ui_sched_kick (ui_sched_t *s)
+{
+   uint64_t v = 1;
+
+   if (!s->armed && (write (s->q->efd, &v, sizeof(v)) < 0))
+      err("eventfd write error!\n");
+}
+
+//------------------------------------------------------------------------------
+void ui_sched_stop (ui_sched_t *s)
+{
+   uint64_t v = 1;
+
+   /* epoll_wait 에서 sleep 중인 경우 깨워서 종료 */
+   s->run = false;
+   if (write (s->q->efd, &v, sizeof(v)) < 0)
+      err("eventfd write error!\n");
+}
+
+//------------------------------------------------------------------------------
+void ui_sched_close (ui_sched_t *s)
+{
+   if (s) {
+      if (s->cap)          fb_hook_del (s->fb, _ui_sched_cap, s->cap);
+      if (s->tfd >= 0)     close (s->tfd);
+      if (s->epfd >= 0)    close (s->epfd);
+      free (s);
+   }
+}
+
+//------------------------------------------------------------------------------
+ui_sched_t *ui_sched_init (fb_info_t *fb, ui_grp_t *ui_grp, ui_queue_t *q, int fps)
+{
+   ui_sched_t *s;
+   struct epoll_event ev;
+   int arg = 0;
+
+   if ((s = (ui_sched_t *)malloc(sizeof(ui_sched_t))) == NULL) {
+      err("ui_sched malloc error!\n");
+      return NULL;
+   }
+   memset (s, 0x00, sizeof(ui_sched_t));
+   s->fb = fb;   s->ui_grp = ui_grp;   s->q = q;
+
+   if ((fps <= 0) || (fps > UI_SCHED_FPS_MAX))
+      fps = UI_SCHED_FPS_DEFAULT;
+   s->fps       = fps;
+   s->period_ns = 1000000000L / fps;
+
+   /*
+      driver 가 vsync 대기를 지원하는 경우 vsync 에 맞추어 반영.
+      DRM 은 fb_present 의 page flip 이 vblank 를 기다리므로 사용하지 않음
+      (DRM fd 는 ioctl type 을 확인하지 않으므로 fbdev ioctl 을 보내면 안됨)
+   */
+   s->vsync = !fb->drm && (ioctl (fb->fd, FBIO_WAITFORVSYNC, &arg) == 0) ? true : false;
+
+   s->tfd  = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+   s->epfd = epoll_create1 (EPOLL_CLOEXEC);
+   if ((s->tfd < 0) || (s->epfd < 0)) {
+      err("timerfd/epoll create error!\n");
+      goto out;
+   }
+
+   memset (&ev, 0x00, sizeof(ev));
+   ev.events = EPOLLIN;
+   ev.data.fd = s->tfd;
+   if (epoll_ctl (s->epfd, EPOLL_CTL_ADD, s->tfd, &ev) < 0)
+      goto out;
+   ev.data.fd = q->efd;
+   if (epoll_ctl (s->epfd, EPOLL_CTL_ADD, q->efd, &ev) < 0)
+      goto out;
+
+   return s;
+out:
+   ui_sched_close (s);
+   return NULL;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
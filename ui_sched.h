@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+#ifndef __UI_SCHED_H__
+#define __UI_SCHED_H__
+
+#include <stdatomic.h>
+
+//------------------------------------------------------------------------------
+#define	UI_SCHED_FPS_DEFAULT	30
+#define	UI_SCHED_FPS_MAX		240
+
+/* scheduler 에서 함께 기다리는 fd 최대 개수 (mirroring, command socket 등) */
+#define	UI_SCHED_WATCH_MAX		8
+
+//------------------------------------------------------------------------------
+typedef void (*ui_sched_f) (void *arg);
+/* frame 마다 호출, return : 처리한 update 수 */
+typedef int  (*ui_sched_batch_f) (void *arg);
+
+typedef struct ui_sched_watch__t {
+	int				fd;
+	ui_sched_f		func;
+	void			*arg;
+}	ui_sched_watch_t;
+
+typedef struct ui_sched_stat__t {
+	/* 화면에 반영된 frame 수, 처리가 늦어 건너뛴 frame 수 */
+	unsigned long	presented, skipped;
+	/* 반영된 update 수, frame 안에서 합쳐진 update 수 */
+	unsigned long	updates, coalesced;
+}	ui_sched_stat_t;
+
+typedef struct ui_sched__t {
+	int				epfd, tfd;
+	int				fps;
+	long			period_ns;
+	/* FBIO_WAITFORVSYNC 지원 여부 */
+	bool			vsync;
+	bool			armed;
+	/* ui_sched_stop 은 다른 thread 에서 호출될 수 있음 */
+	_Atomic bool	run;
+
+	fb_info_t		*fb;
+	ui_grp_t		*ui_grp;
+	ui_queue_t		*q;
+	/* 설정되어 있으면 화면에 반영한 frame 마다 capture stream 에 기록 */
+	struct fb_cap__t	*cap;
+	/* frame 마다 queue 보다 먼저 처리할 batch (command daemon 등) */
+	ui_sched_batch_f	batch;
+	void			*batch_arg;
+	/* fd 에 읽을 data 가 있으면 func 호출 */
+	int				w_cnt;
+	ui_sched_watch_t	watch[UI_SCHED_WATCH_MAX];
+	ui_sched_stat_t	stat;
+}	ui_sched_t;
+
+//------------------------------------------------------------------------------
+extern	void        ui_sched_stat   (ui_sched_t *s, ui_sched_stat_t *stat);
+extern	void        ui_sched_capture (ui_sched_t *s, struct fb_cap__t *cap);
+extern	int         ui_sched_watch  (ui_sched_t *s, int fd, ui_sched_f func, void *arg);
+extern	void        ui_sched_batch  (ui_sched_t *s, ui_sched_batch_f func, void *arg);
+extern	void        ui_sched_kick   (ui_sched_t *s);
+extern	int         ui_sched_poll   (ui_sched_t *s, int timeout_ms);
+extern	void        ui_sched_run    (ui_sched_t *s);
+extern	void        ui_sched_stop   (ui_sched_t *s);
+extern	void        ui_sched_close  (ui_sched_t *s);
+extern	ui_sched_t	*ui_sched_init  (fb_info_t *fb, ui_grp_t *ui_grp, ui_queue_t *q, int fps);
+
+//------------------------------------------------------------------------------
+
+#endif  // #define __UI_SCHED_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------